@@ -78,6 +78,13 @@ api.post("  Clock API available for time-based callbacks")
 api.post("  Usage: clock = api.Clock(owner_ptr, callback_function)")
 api.post("  Methods: clock:delay(ms), clock:fdelay(ms), clock:unset()")
 
+-- In luajit~ callbacks are queued and run between DSP blocks
+local pending, executed, dropped, mean_ms, max_ms, skipped = api.mailbox_stats()
+if pending then
+    api.post(string.format("  Mailbox: %d pending, %d run, %d dropped (mean %.3f ms, max %.3f ms), %d blocks skipped",
+                           pending, executed, dropped, mean_ms, max_ms, skipped))
+end
+
 -- Example callback (won't actually work without proper owner)
 --[[
 function my_callback()
@@ -88,6 +95,32 @@ local clock = api.Clock(owner_ptr, my_callback)
 clock:fdelay(1000)  -- Fire in 1 second
 ]]--
 
+-- Many pending events: one clock and a timer wheel per state
+api.post("  Timer wheel: id = api.schedule(ms, fn), api.cancel(id)")
+
+--[[
+local period = 125
+local function step(due)
+    api.post("step at " .. due)
+    api.schedule_at(due + period, step)    -- drift-free: relative to due time
+end
+api.schedule(period, step)
+
+local id = api.schedule_ticks(480, function() api.post("one beat later") end)
+api.cancel(id)
+]]--
+
+-- The same loop as a task: api.sleep() suspends it on the wheel
+--[[
+local task = api.spawn(function(period)
+    for i = 1, 8 do
+        api.post("task step " .. i)
+        api.sleep(period)
+    end
+end, 125)
+-- api.kill(task)
+]]--
+
 -- ============================================================================
 -- Outlet API
 -- ============================================================================
@@ -104,6 +137,7 @@ api.post("    outlet:float(value)")
 api.post("    outlet:symbol(string)")
 api.post("    outlet:list({val1, val2, ...})")
 api.post("    outlet:anything(symbol, {val1, val2, ...})")
+api.post("    outlet:list_many({...}, {...}, ...) - Several messages per call")
 
 -- Example (won't actually work without proper owner and outlet)
 --[[
@@ -113,6 +147,23 @@ outlet:int(42)
 outlet:float(3.14)
 outlet:list({1, 2, 3, "test"})
 outlet:anything("custom", {1, 2, 3})
+outlet:list_many({60, 100}, {64, 100}, {"note", 67, 100})  -- two lists, then "note 67 100"
+]]--
+
+-- UI updates: only the latest value per key is sent, at most every 16 ms
+api.post("  Coalescing UI updates: ui = api.Updates(16), ui:set(key, outlet, ...)")
+
+--[[
+local ui = api.Updates(16, 2)              -- room for two keys: no allocation in set()
+for i = 1, 1000 do
+    ui:set("level", outlet, i)              -- one "1000" reaches the outlet
+end
+ui:set("label", outlet, "set", "done")     -- sends "set done"
+
+-- From the DSP function strings are rejected (gensym() may allocate);
+-- intern them beforehand
+local SET, DONE = api.gensym("set"), api.gensym("done")
+ui:set("label", outlet, SET, DONE)
 ]]--
 
 -- ============================================================================
@@ -214,6 +265,7 @@ api.post("  Methods:")
 api.post("    buf:ref_set(name) - Change buffer reference")
 api.post("    buf:exists() - Check if buffer exists")
 api.post("    buf:getinfo() - Get metadata table")
+api.post("    buf:version() - Change counter (resize, replace, dirty)")
 api.post("    buf:frames() - Get frame count")
 api.post("    buf:channels() - Get channel count")
 api.post("    buf:samplerate() - Get sample rate")
@@ -222,6 +274,14 @@ api.post("    buf:poke(frame, channel, value) - Write sample")
 api.post("    buf:to_list(channel, start, count) - Export to table")
 api.post("    buf:from_list(channel, table, start) - Import from table")
 api.post("    buf:clear() - Zero all samples")
+api.post("    buf:lock() - Lock once, returns { samples = float*, frames, channels, stride }")
+api.post("    buf:unlock(dirty) - Release the lock (dirty = true after writing)")
+api.post("    buf:with_locked(fn, dirty) - Call fn(view) between lock() and unlock()")
+api.post("    buf:read(pos, channel, interp, loop) - Interpolated read (linear/cubic/sinc)")
+api.post("    buf:play_block(out, n, pos, rate, channel, interp, loop) - Block playback")
+api.post("    buf:read_into(dst, channel, start, n) - Copy a channel into an FFI array")
+api.post("    buf:write_from(src, channel, start, n) - Copy an FFI array into a channel")
+api.post("    buf:deinterleave_into(start, n, dst1, ...) - Split all channels at once")
 
 -- Example (requires valid owner and buffer~ object)
 --[[
@@ -243,6 +303,44 @@ if buf:exists() then
     -- Bulk operations
     local samples = buf:to_list(0, 0, 100)  -- Read first 100 samples of channel 0
     buf:from_list(0, samples, 0)  -- Write back
+
+    -- Zero-copy access: one lock per block, plain pointer loads inside
+    local sum = buf:with_locked(function(view)
+        local s, stride = view.samples, view.stride
+        local acc = 0
+        for i = 0, view.frames - 1 do
+            acc = acc + math.abs(s[i * stride])  -- channel 0
+        end
+        return acc
+    end)
+    api.post("  Sum of |channel 0|: " .. sum)
+
+    -- Interpolated playback: one call per block, no per-tap locking
+    local ffi = require 'ffi'
+    local out = ffi.new("double[64]")
+    local pos = 0
+    pos = buf:play_block(out, 64, pos, 0.5, 0, "cubic", "loop")  -- half speed
+    api.post("  Cubic read at 10.25: " .. buf:read(10.25, 0, "cubic"))
+
+    -- Bulk copies into FFI arrays, no tables
+    local left, right = ffi.new("double[512]"), ffi.new("double[512]")
+    local got = buf:read_into(left, 0, 0, 512)
+    if buf:channels() == 2 then
+        buf:deinterleave_into(0, 512, left, right)
+        buf:interleave_from(0, 512, right, left)  -- swap channels
+    end
+    api.post("  Copied " .. got .. " frames")
+
+    -- Rebuild derived data only when the buffer~ really changed
+    local built_version = -1
+    local function refresh()
+        if buf:version() ~= built_version then
+            built_version = buf:version()
+            api.post("  Rebuilding tables for " .. buf:frames() .. " frames")
+        end
+    end
+    refresh()
+    refresh()  -- no-op
 end
 ]]--
 
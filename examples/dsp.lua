@@ -168,6 +168,44 @@ base = function(x, fb, n, p1)
    return x * c
 end
 
+----------------------------------------------------------------------------------
+-- reporting values to the patch with emit()
+
+-- Envelope follower and onset detector that pass audio through and send
+-- their measurements from the right outlet:
+--   "level <peak>" once per signal vector (coalesced to the latest value)
+--   "onset <level>" when the fast envelope jumps above the slow one
+-- emit() only queues the event; a clock sends it on the scheduler thread.
+-- Usage: "follow" (p1 = onset threshold ratio, default 2)
+if events then
+   events.name(0, "level")
+   events.name(1, "onset")
+   events.coalesce(true)
+end
+
+local follow_fast, follow_slow, follow_peak, follow_hold = 0, 0, 0, 0
+
+follow = function(x, fb, n, p1)
+   local a = math.abs(x)
+   follow_fast = follow_fast + 0.01 * (a - follow_fast)
+   follow_slow = follow_slow + 0.0005 * (a - follow_slow)
+   if a > follow_peak then follow_peak = a end
+
+   local ratio = p1 > 1 and p1 or 2
+   if follow_hold > 0 then
+      follow_hold = follow_hold - 1
+   elseif follow_fast > ratio * follow_slow and follow_fast > 0.01 then
+      emit(1, follow_fast)
+      follow_hold = SAMPLE_RATE * 0.05     -- 50 ms before the next onset
+   end
+
+   if n == 0 then                           -- last sample of the vector
+      emit(0, follow_peak)
+      follow_peak = 0
+   end
+   return x
+end
+
 ----------------------------------------------------------------------------------
 -- dynamic parameter test functions
 
@@ -382,6 +420,21 @@ if ffi_available then
       return wet * mix + x * (1.0 - mix)
    end
 
+   -- tanh saturation with an explicit fast-math accuracy tier
+   -- Usage: "ffi_tanh drive 3.0 mix 1.0"
+   -- Parameters:
+   --   drive: input gain in dB (default 6.0)
+   --   mix: dry/wet mix (0.0 = dry, 1.0 = wet, default 1.0)
+   ffi_tanh = function(x, fb, n, ...)
+      local drive = dsp_c.fast_db_to_gain_low(PARAMS.drive or 6.0)
+      local mix = PARAMS.mix or 1.0
+
+      -- _med is transparent for audio at a fraction of math.tanh's cost
+      local wet = dsp_c.fast_tanh_med(x * drive)
+
+      return wet * mix + x * (1.0 - mix)
+   end
+
    -- Bit crusher using C function
    -- Usage: "ffi_bitcrush bits 8 mix 0.5"
    -- Parameters:
@@ -446,6 +499,10 @@ else
       return x
    end
 
+   ffi_tanh = function(x, fb, n, ...)
+      return x
+   end
+
    ffi_bitcrush = function(x, fb, n, ...)
       return x
    end
@@ -463,6 +520,98 @@ else
    end
 end
 
+-- Filter objects from libdsp (if available)
+-- State and cached coefficients live in C structs allocated once with
+-- ffi.new, so the per-sample path does not allocate.
+if ffi_available then
+   local ffi = require 'ffi'
+
+   local _biquad = ffi.new("dsp_biquad")
+   dsp_c.biquad_init(_biquad)
+
+   local _svf = ffi.new("dsp_svf")
+   dsp_c.svf_init(_svf)
+
+   local _dcblock = ffi.new("dsp_dcblock")
+   dsp_c.dcblock_init(_dcblock)
+
+   -- RBJ cookbook biquad
+   -- Usage: "ffi_biquad type 0 freq 800 q 2.0 gain 0"
+   -- Parameters:
+   --   type: 0=lp 1=hp 2=bp 3=bs 4=ls 5=hs 6=eq 7=ap (default 0)
+   --   freq: cutoff/centre frequency in Hz (default 1000)
+   --   q: resonance (default 0.7071)
+   --   gain: shelf/eq gain in dB (default 0)
+   ffi_biquad = function(x, fb, n, ...)
+      -- biquad_set only recomputes coefficients when a parameter changes
+      dsp_c.biquad_set(_biquad, PARAMS.type or 0, PARAMS.freq or 1000.0,
+                       PARAMS.q or 0.7071, PARAMS.gain or 0.0, SAMPLE_RATE)
+      return dsp_c.biquad_tick(_biquad, x)
+   end
+
+   -- State-variable filter, stable under fast cutoff modulation
+   -- Usage: "ffi_svf mode 0 freq 500 q 4.0"
+   -- Parameters:
+   --   mode: 0=lp 1=bp 2=hp 3=notch 4=peak 5=ap (default 0)
+   --   freq: cutoff frequency in Hz (default 1000)
+   --   q: resonance (default 0.7071)
+   ffi_svf = function(x, fb, n, ...)
+      dsp_c.svf_set(_svf, PARAMS.mode or 0, PARAMS.freq or 1000.0,
+                    PARAMS.q or 0.7071, SAMPLE_RATE)
+      return dsp_c.svf_tick(_svf, x)
+   end
+
+   -- DC blocker
+   -- Usage: "ffi_dcblock freq 10"
+   ffi_dcblock = function(x, fb, n, ...)
+      dsp_c.dcblock_set(_dcblock, PARAMS.freq or 10.0, SAMPLE_RATE)
+      return dsp_c.dcblock_tick(_dcblock, x)
+   end
+else
+   ffi_biquad = function(x, fb, n, ...)
+      return x
+   end
+
+   ffi_svf = function(x, fb, n, ...)
+      return x
+   end
+
+   ffi_dcblock = function(x, fb, n, ...)
+      return x
+   end
+end
+
+-- Control-value scaling using FFI (if available)
+-- A dsp_scaler folds a scale_* curve into constants once; with a lookup
+-- table, mapping a MIDI value is a single array read.
+if ffi_available then
+   local ffi = require 'ffi'
+
+   -- MIDI 0..127 -> 20 Hz .. 20 kHz, exponential, tabulated
+   local _cc_scaler = ffi.new("dsp_scaler")
+   dsp_c.scaler_init(_cc_scaler)
+   dsp_c.scaler_set(_cc_scaler, "SCALE_EXP2", 1.0, 0, 127, 20.0, 20000.0)
+   dsp_c.scaler_set_lut(_cc_scaler, 0, 128)
+
+   local _cc_filter = ffi.new("dsp_svf")
+   dsp_c.svf_init(_cc_filter)
+
+   -- Low-pass filter with its cutoff on a MIDI controller
+   -- Usage: "ffi_cc_filter cc 64 q 2.0"
+   -- Parameters:
+   --   cc: controller value 0 - 127, mapped exponentially to 20 Hz - 20 kHz (default 64)
+   --   q: resonance (default 0.7071)
+   ffi_cc_filter = function(x, fb, n, ...)
+      local freq = dsp_c.scaler_map(_cc_scaler, PARAMS.cc or 64)
+      dsp_c.svf_set(_cc_filter, 0, freq, PARAMS.q or 0.7071, SAMPLE_RATE)
+      return dsp_c.svf_tick(_cc_filter, x)
+   end
+else
+   ffi_cc_filter = function(x, fb, n, ...)
+      return x
+   end
+end
+
 -- Oscillator functions using FFI (if available)
 -- These use a global phase accumulator that persists across calls
 if ffi_available then
@@ -655,3 +804,202 @@ else
 end
 
 
+-- Wavetable oscillators using FFI (if available)
+-- Tables are band-limited per octave once and shared, so each sample costs an
+-- interpolated table read instead of a sin() or PolyBLEP call.
+if ffi_available then
+   local ffi = require 'ffi'
+
+   local WT_SHAPES = { sine = 0, saw = 1, square = 2, tri = 3 }
+
+   local _wtosc = ffi.new("dsp_wtosc")
+   dsp_c.wtosc_init(_wtosc, dsp_c.wavetable_builtin(0))
+
+   -- Single wavetable oscillator
+   -- Usage: "ffi_wt_osc shape 1 freq 110.0 gain 0.5"
+   -- Parameters:
+   --   shape: 0=sine 1=saw 2=square 3=triangle (default 1)
+   --   freq: frequency in Hz (default 110.0)
+   --   gain: output gain (default 0.5)
+   ffi_wt_osc = function(x, fb, n, ...)
+      local shape = PARAMS.shape or WT_SHAPES.saw
+      local freq = PARAMS.freq or 110.0
+      local gain = PARAMS.gain or 0.5
+
+      -- Built-in tables are shared and never freed, switching is free
+      dsp_c.wtosc_set_table(_wtosc, dsp_c.wavetable_builtin(shape))
+      return dsp_c.wtosc_tick(_wtosc, freq / SAMPLE_RATE) * gain
+   end
+
+   -- Additive oscillator bank rendered a block at a time
+   -- One FFI call renders and mixes all partials for WT_BLOCK samples, the
+   -- per-sample call only reads the result back.
+   -- Usage: "ffi_wt_bank freq 110.0 partials 32 gain 0.3"
+   -- Parameters:
+   --   freq: fundamental in Hz (default 110.0)
+   --   partials: number of harmonics (1 - 64, default 32)
+   --   gain: output gain (default 0.3)
+   local WT_MAX_PARTIALS = 64
+   local WT_BLOCK = 64
+   local _bank = ffi.new("dsp_wtosc[?]", WT_MAX_PARTIALS)
+   local _bank_inc = ffi.new("double[?]", WT_MAX_PARTIALS)
+   local _bank_amp = ffi.new("double[?]", WT_MAX_PARTIALS)
+   local _bank_out = ffi.new("double[?]", WT_BLOCK)
+   local _bank_pos = WT_BLOCK
+   local sine_table = dsp_c.wavetable_builtin(0)
+   for i = 0, WT_MAX_PARTIALS - 1 do
+      dsp_c.wtosc_init(_bank[i], sine_table)
+   end
+
+   ffi_wt_bank = function(x, fb, n, ...)
+      if _bank_pos >= WT_BLOCK then
+         local freq = PARAMS.freq or 110.0
+         local partials = math.max(1, math.min(WT_MAX_PARTIALS, math.floor(PARAMS.partials or 32)))
+         for i = 0, partials - 1 do
+            _bank_inc[i] = freq * (i + 1) / SAMPLE_RATE
+            _bank_amp[i] = 1.0 / (i + 1)
+         end
+         dsp_c.wtosc_bank_process_block(_bank, _bank_inc, _bank_amp, partials, _bank_out, WT_BLOCK)
+         _bank_pos = 0
+      end
+      local output = _bank_out[_bank_pos] * (PARAMS.gain or 0.3)
+      _bank_pos = _bank_pos + 1
+      return output
+   end
+else
+   ffi_wt_osc = function(x, fb, n, ...)
+      return 0.0
+   end
+
+   ffi_wt_bank = function(x, fb, n, ...)
+      return 0.0
+   end
+end
+
+-- Additive synthesis using FFI (if available)
+-- Partials are held natively as structure-of-arrays state and rendered a
+-- block per call with SIMD, so pads with hundreds of harmonics stay cheap.
+if ffi_available then
+   local ffi = require 'ffi'
+
+   local ADD_MAX_PARTIALS = 1024
+   local ADD_BLOCK = 64
+   local _add = ffi.gc(dsp_c.additive_create(ADD_MAX_PARTIALS), dsp_c.additive_free)
+   local _add_amp = ffi.new("double[?]", ADD_MAX_PARTIALS)
+   local _add_out = ffi.new("double[?]", ADD_BLOCK)
+   local _add_pos = ADD_BLOCK
+   local _add_partials, _add_tilt = nil, nil
+
+   -- Additive pad: a harmonic series rendered natively
+   -- Amplitude changes ramp over one block, harmonics above Nyquist fade out.
+   -- Usage: "ffi_additive freq 55.0 partials 256 tilt 1.0 gain 0.3"
+   -- Parameters:
+   --   freq: fundamental in Hz (default 55.0)
+   --   partials: number of harmonics (1 - 1024, default 256)
+   --   tilt: spectral slope, harmonic k has amplitude 1/k^tilt (default 1.0)
+   --   gain: output gain (default 0.3)
+   ffi_additive = function(x, fb, n, ...)
+      if _add_pos >= ADD_BLOCK then
+         local freq = PARAMS.freq or 55.0
+         local partials = math.max(1, math.min(ADD_MAX_PARTIALS, math.floor(PARAMS.partials or 256)))
+         local tilt = PARAMS.tilt or 1.0
+         if partials ~= _add_partials or tilt ~= _add_tilt then
+            for k = 0, partials - 1 do
+               _add_amp[k] = 1.0 / (k + 1) ^ tilt
+            end
+            _add_partials, _add_tilt = partials, tilt
+         end
+         dsp_c.additive_set_harmonics(_add, freq / SAMPLE_RATE, _add_amp, partials)
+         dsp_c.additive_process_block(_add, _add_out, ADD_BLOCK)
+         _add_pos = 0
+      end
+      local output = _add_out[_add_pos] * (PARAMS.gain or 0.3)
+      _add_pos = _add_pos + 1
+      return output
+   end
+else
+   ffi_additive = function(x, fb, n, ...)
+      return 0.0
+   end
+end
+
+-- Convolution (IR reverb, cabinet simulation) using FFI (if available)
+if ffi_available then
+   local ffi = require 'ffi'
+   local _conv = nil
+
+   -- Load an impulse response from one channel of a buffer~
+   -- buf: an api.Buffer, e.g. api.Buffer(owner_ptr, "ir")
+   -- channel: buffer channel (0-indexed, default 0)
+   -- block_size: FFT partition size (default 128; larger = cheaper, more CPU per block)
+   -- Builds the FFT partitions, so call it when loading the script, not per sample.
+   conv_load = function(buf, channel, block_size)
+      -- Read the buffer~ memory in place instead of copying it into a table
+      local conv = buf:with_locked(function(view)
+         channel = channel or 0
+         if view.frames == 0 or channel >= view.channels then
+            return nil
+         end
+         return dsp_c.convolver_create_float(view.samples + channel, view.frames,
+                                             view.stride, block_size or 128)
+      end)
+      if conv == nil then
+         return false
+      end
+      _conv = ffi.gc(conv, dsp_c.convolver_free)
+      return true
+   end
+
+   -- Zero-latency convolution with the IR loaded by conv_load()
+   -- Usage: "ffi_convolve mix 0.3"
+   -- Parameters:
+   --   mix: dry/wet mix (0.0 = dry, 1.0 = wet, default 0.3)
+   ffi_convolve = function(x, fb, n, ...)
+      if _conv == nil then
+         return x
+      end
+      local mix = PARAMS.mix or 0.3
+      local wet = dsp_c.convolver_tick(_conv, x)
+      return wet * mix + x * (1.0 - mix)
+   end
+else
+   conv_load = function(buf, channel, block_size)
+      return false
+   end
+
+   ffi_convolve = function(x, fb, n, ...)
+      return x
+   end
+end
+
+-- Delay lines using FFI (if available)
+-- The ring buffer lives outside the Lua heap and is indexed with a mask, so
+-- the JIT compiles the read/write pair to plain loads and stores.
+if ffi_available then
+   local ffi = require 'ffi'
+
+   local DELAY_MAX_MS = 2000
+   local _delay = ffi.gc(dsp_c.delay_create(math.ceil(DELAY_MAX_MS * SAMPLE_RATE / 1000)),
+                         dsp_c.delay_free)
+
+   -- Feedback delay with a fractional, modulatable delay time
+   -- Usage: "ffi_delay time 250.0 feedback 0.5 mix 0.3"
+   -- Parameters:
+   --   time: delay time in ms (up to 2000, default 250.0)
+   --   feedback: feedback amount (0.0 - 0.99, default 0.5)
+   --   mix: dry/wet mix (0.0 = dry, 1.0 = wet, default 0.3)
+   ffi_delay = function(x, fb, n, ...)
+      local time = PARAMS.time or 250.0
+      local feedback = math.min(PARAMS.feedback or 0.5, 0.99)
+      local mix = PARAMS.mix or 0.3
+
+      -- Read before writing: a delay of t samples is then exact
+      local wet = dsp_c.delay_read_cubic(_delay, time * SAMPLE_RATE / 1000)
+      dsp_c.delay_write(_delay, x + wet * feedback)
+      return wet * mix + x * (1.0 - mix)
+   end
+else
+   ffi_delay = function(x, fb, n, ...)
+      return x
+   end
+end
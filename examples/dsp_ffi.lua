@@ -1,26 +1,37 @@
 -- dsp_ffi.lua
 -- FFI wrapper for libdsp C functions
 -- Demonstrates using LuaJIT FFI to call optimized C code
+--
+-- luajit~ and luajit.stk~ link libdsp in and declare it when the Lua state is
+-- created, so there require 'dsp_ffi' returns ffi.C and this file never runs.
+-- It is the fallback for other hosts (e.g. standalone LuaJIT), and its
+-- ffi.cdef block is also what the externals preload: CMake turns it into
+-- libdsp_cdef.h, so keep it to a single block.
 
 local ffi = require 'ffi'
 
 -- Load the libdsp shared library
 -- The library is in the support directory (Max package structure)
 
+local LIB_EXT = ({ OSX = "dylib", Windows = "dll" })[ffi.os] or "so"
+
 -- Try loading from different locations
 local dsp
 local load_success, load_error = pcall(function()
-   -- load relative to examples directory (../support/libdsp.dylib)
+   -- load relative to examples directory (../support/libdsp.<ext>)
    local function script_dir()
       local str = debug.getinfo(1, "S").source:sub(2)
-      return str:match("(.*/)")
+      return str:match("(.*/)") or "./"
    end
    local examples_dir = script_dir()
-   local support_path = examples_dir .. "../support/libdsp.dylib"
-   local ok, lib = pcall(function() return ffi.load(support_path) end)
-   if ok then
-      dsp = lib
-      return
+   -- build.sh names the library .dylib on every platform
+   for _, ext in ipairs({ LIB_EXT, "dylib" }) do
+      local support_path = examples_dir .. "../support/libdsp." .. ext
+      local ok, lib = pcall(function() return ffi.load(support_path) end)
+      if ok then
+         dsp = lib
+         return
+      end
    end
 
    error("Could not load libdsp from any location")
@@ -30,7 +41,8 @@ if not load_success then
    error("Failed to load libdsp: " .. tostring(load_error))
 end
 
--- Declare C function signatures
+-- Declare C function signatures (unless an engine already did)
+if not pcall(ffi.typeof, "dsp_delay") then
 ffi.cdef[[
 // Scaling functions
 double scale_linear(double x, double in_min, double in_max, double out_min, double out_max);
@@ -62,6 +74,323 @@ double osc_square_bl(double phase, double pulse_width, double phase_inc);
 double osc_triangle(double phase);
 double osc_phase_inc(double freq, double sample_rate);
 double osc_phase_wrap(double phase);
+
+// Block functions: process n samples per call (in and out must not overlap)
+void scale_linear_block(const double* in, double* out, size_t n, double i_min, double i_max, double o_min, double o_max);
+void scale_sine1_block(const double* in, double* out, size_t n, double i_min, double i_max, double o_min, double o_max);
+void scale_sine2_block(const double* in, double* out, size_t n, double i_min, double i_max, double o_min, double o_max);
+void scale_exp1_block(const double* in, double* out, size_t n, double s, double i_min, double i_max, double o_min, double o_max);
+void scale_exp2_block(const double* in, double* out, size_t n, double s, double i_min, double i_max, double o_min, double o_max);
+void scale_log1_block(const double* in, double* out, size_t n, double p, double i_min, double i_max, double o_min, double o_max);
+void scale_log2_block(const double* in, double* out, size_t n, double p, double i_min, double i_max, double o_min, double o_max);
+
+void soft_clip_block(const double* in, double* out, size_t n, double drive);
+void hard_clip_block(const double* in, double* out, size_t n, double threshold);
+void bit_crush_block(const double* in, double* out, size_t n, double bits);
+void lpf_1pole_block(const double* in, double* out, size_t n, double cutoff, double* state);
+void hpf_1pole_block(const double* in, double* out, size_t n, double cutoff, double* state);
+void lerp_block(const double* a, const double* b, double* out, size_t n, double t);
+void envelope_follow_block(const double* in, double* out, size_t n, double attack, double release, double* state);
+void wavefold_block(const double* in, double* out, size_t n, double threshold);
+void ring_mod_block(const double* in, const double* mod, double* out, size_t n);
+void clamp_block(const double* in, double* out, size_t n, double min, double max);
+
+double osc_phase_block(double* out, size_t n, double phase, double phase_inc);
+void osc_sine_block(const double* in, double* out, size_t n);
+void osc_saw_block(const double* in, double* out, size_t n);
+void osc_saw_bl_block(const double* in, double* out, size_t n, double phase_inc);
+void osc_square_block(const double* in, double* out, size_t n, double pulse_width);
+void osc_square_bl_block(const double* in, double* out, size_t n, double pulse_width, double phase_inc);
+void osc_triangle_block(const double* in, double* out, size_t n);
+
+// Scaler objects: allocate with ffi.new("dsp_scaler"), then scaler_init()
+typedef enum {
+    SCALE_LINEAR = 0, SCALE_SINE1, SCALE_SINE2, SCALE_EXP1, SCALE_EXP2, SCALE_LOG1, SCALE_LOG2
+} scale_curve;
+
+enum {
+    SCALER_LUT_SIZE = 128
+};
+
+typedef struct {
+    double a, b, c, d;
+    int curve;
+    double shape, i_min, i_max, o_min, o_max;
+    int lut_first, lut_size;
+    double lut[SCALER_LUT_SIZE];
+} dsp_scaler;
+
+void scaler_init(dsp_scaler* s);
+void scaler_set(dsp_scaler* s, scale_curve curve, double shape,
+                double i_min, double i_max, double o_min, double o_max);
+void scaler_set_lut(dsp_scaler* s, int first, int count);
+double scaler_map(const dsp_scaler* s, double x);
+void scaler_process_block(const dsp_scaler* s, const double* in, double* out, size_t n);
+
+// Filter objects: allocate with ffi.new("dsp_biquad") etc., then *_init()
+// (struct layouts must match source/projects/libdsp/libdsp.h)
+typedef enum {
+    BIQUAD_LP = 0, BIQUAD_HP, BIQUAD_BP, BIQUAD_BS, BIQUAD_LS, BIQUAD_HS, BIQUAD_EQ, BIQUAD_AP
+} biquad_type;
+
+typedef struct {
+    double b0, b1, b2, a1, a2;
+    double z1, z2;
+    int type;
+    double freq, q, gain, samplerate;
+} dsp_biquad;
+
+void biquad_init(dsp_biquad* f);
+void biquad_reset(dsp_biquad* f);
+void biquad_set(dsp_biquad* f, biquad_type type, double freq, double q, double gain_db, double samplerate);
+double biquad_tick(dsp_biquad* f, double x);
+void biquad_process_block(dsp_biquad* f, const double* in, double* out, size_t n);
+
+typedef enum {
+    SVF_LP = 0, SVF_BP, SVF_HP, SVF_NOTCH, SVF_PEAK, SVF_AP
+} svf_mode;
+
+typedef struct {
+    double g, k, a1, a2, a3;
+    double ic1eq, ic2eq;
+    double lp, bp, hp;
+    int mode;
+    double freq, q, samplerate;
+} dsp_svf;
+
+void svf_init(dsp_svf* f);
+void svf_reset(dsp_svf* f);
+void svf_set(dsp_svf* f, svf_mode mode, double freq, double q, double samplerate);
+double svf_tick(dsp_svf* f, double x);
+void svf_process_block(dsp_svf* f, const double* in, double* out, size_t n);
+
+typedef enum {
+    ONEPOLE_LP = 0, ONEPOLE_HP
+} onepole_mode;
+
+typedef struct {
+    double a0, a1, b1;
+    double x1, y1;
+    int mode;
+    double freq, samplerate;
+} dsp_onepole;
+
+void onepole_init(dsp_onepole* f);
+void onepole_reset(dsp_onepole* f);
+void onepole_set(dsp_onepole* f, onepole_mode mode, double freq, double samplerate);
+double onepole_tick(dsp_onepole* f, double x);
+void onepole_process_block(dsp_onepole* f, const double* in, double* out, size_t n);
+
+typedef struct {
+    double b0, b1;
+    double x1;
+    double zero;
+} dsp_onezero;
+
+void onezero_init(dsp_onezero* f);
+void onezero_reset(dsp_onezero* f);
+void onezero_set(dsp_onezero* f, double zero);
+double onezero_tick(dsp_onezero* f, double x);
+void onezero_process_block(dsp_onezero* f, const double* in, double* out, size_t n);
+
+typedef struct {
+    double r;
+    double x1, y1;
+    double freq, samplerate;
+} dsp_dcblock;
+
+void dcblock_init(dsp_dcblock* f);
+void dcblock_reset(dsp_dcblock* f);
+void dcblock_set(dsp_dcblock* f, double freq, double samplerate);
+double dcblock_tick(dsp_dcblock* f, double x);
+void dcblock_process_block(dsp_dcblock* f, const double* in, double* out, size_t n);
+
+typedef struct {
+    dsp_biquad lp[2];
+    dsp_biquad hp[2];
+} dsp_crossover;
+
+void crossover_init(dsp_crossover* f);
+void crossover_reset(dsp_crossover* f);
+void crossover_set(dsp_crossover* f, double freq, double samplerate);
+void crossover_tick(dsp_crossover* f, double x, double* low, double* high);
+void crossover_process_block(dsp_crossover* f, const double* in, double* low, double* high, size_t n);
+
+// Wavetable oscillators: tables are opaque and shared, oscillators are
+// allocated with ffi.new("dsp_wtosc") or ffi.new("dsp_wtosc[?]", count)
+enum {
+    WAVETABLE_SIZE = 2048,
+    WAVETABLE_LEVELS = 11
+};
+
+typedef enum {
+    WT_SINE = 0, WT_SAW, WT_SQUARE, WT_TRIANGLE, WT_NUM_SHAPES
+} wt_shape;
+
+typedef struct dsp_wavetable dsp_wavetable;
+
+const dsp_wavetable* wavetable_builtin(wt_shape shape);
+dsp_wavetable* wavetable_create(const double* samples, size_t n);
+dsp_wavetable* wavetable_create_float(const float* samples, size_t frames, size_t stride);
+void wavetable_free(dsp_wavetable* wt);
+double wavetable_lookup(const dsp_wavetable* wt, double phase, double phase_inc);
+
+typedef struct {
+    const dsp_wavetable* table;
+    double phase;
+} dsp_wtosc;
+
+void wtosc_init(dsp_wtosc* o, const dsp_wavetable* table);
+void wtosc_set_table(dsp_wtosc* o, const dsp_wavetable* table);
+void wtosc_reset(dsp_wtosc* o, double phase);
+double wtosc_tick(dsp_wtosc* o, double phase_inc);
+void wtosc_process_block(dsp_wtosc* o, double* out, size_t n, double phase_inc);
+void wtosc_process_block_fm(dsp_wtosc* o, const double* phase_inc, double* out, size_t n);
+void wtosc_bank_process_block(dsp_wtosc* oscs, const double* phase_inc, const double* amp,
+                              size_t count, double* out, size_t n);
+
+// Additive bank: opaque, create with additive_create and free with additive_free
+typedef struct dsp_additive dsp_additive;
+
+dsp_additive* additive_create(size_t max_partials);
+void additive_free(dsp_additive* a);
+size_t additive_capacity(const dsp_additive* a);
+void additive_reset(dsp_additive* a);
+void additive_set_freq(dsp_additive* a, size_t k, double phase_inc);
+void additive_set_amp(dsp_additive* a, size_t k, double amp);
+void additive_set_phase(dsp_additive* a, size_t k, double phase);
+void additive_set_partial(dsp_additive* a, size_t k, double phase_inc, double amp);
+void additive_set_partials(dsp_additive* a, const double* phase_inc, const double* amp, size_t count);
+void additive_set_harmonics(dsp_additive* a, double phase_inc, const double* amp, size_t count);
+void additive_process_block(dsp_additive* a, double* out, size_t n);
+
+// Fast math: _low (~1e-3), _med (~1e-7), _high (~1e-13)
+typedef enum {
+    FASTMATH_LOW = 0, FASTMATH_MED, FASTMATH_HIGH
+} fastmath_tier;
+
+double fast_exp2_low(double x);
+double fast_exp2_med(double x);
+double fast_exp2_high(double x);
+double fast_log2_low(double x);
+double fast_log2_med(double x);
+double fast_log2_high(double x);
+double fast_sin_low(double x);
+double fast_sin_med(double x);
+double fast_sin_high(double x);
+double fast_cos_low(double x);
+double fast_cos_med(double x);
+double fast_cos_high(double x);
+double fast_tanh_low(double x);
+double fast_tanh_med(double x);
+double fast_tanh_high(double x);
+double fast_pow_low(double x, double y);
+double fast_pow_med(double x, double y);
+double fast_pow_high(double x, double y);
+double fast_db_to_gain_low(double db);
+double fast_db_to_gain_med(double db);
+double fast_db_to_gain_high(double db);
+double fast_gain_to_db_low(double gain);
+double fast_gain_to_db_med(double gain);
+double fast_gain_to_db_high(double gain);
+
+void fast_exp2_block(const double* in, double* out, size_t n, fastmath_tier tier);
+void fast_log2_block(const double* in, double* out, size_t n, fastmath_tier tier);
+void fast_sin_block(const double* in, double* out, size_t n, fastmath_tier tier);
+void fast_cos_block(const double* in, double* out, size_t n, fastmath_tier tier);
+void fast_tanh_block(const double* in, double* out, size_t n, fastmath_tier tier);
+void fast_pow_block(const double* in, double* out, size_t n, double y, fastmath_tier tier);
+void fast_db_to_gain_block(const double* in, double* out, size_t n, fastmath_tier tier);
+void fast_gain_to_db_block(const double* in, double* out, size_t n, fastmath_tier tier);
+
+// Partitioned convolution: opaque, create from an IR and free with convolver_free
+typedef struct dsp_convolver dsp_convolver;
+
+dsp_convolver* convolver_create(const double* ir, size_t ir_len, size_t block_size);
+dsp_convolver* convolver_create_float(const float* ir, size_t frames, size_t stride,
+                                      size_t block_size);
+void convolver_free(dsp_convolver* c);
+void convolver_reset(dsp_convolver* c);
+size_t convolver_ir_length(const dsp_convolver* c);
+size_t convolver_block_size(const dsp_convolver* c);
+double convolver_tick(dsp_convolver* c, double x);
+void convolver_process_block(dsp_convolver* c, const double* in, double* out, size_t n);
+
+// Delay lines: power-of-two ring buffers, create with delay_create and free with delay_free
+typedef enum {
+    DELAY_NONE = 0,
+    DELAY_LINEAR,
+    DELAY_CUBIC,
+    DELAY_LAGRANGE
+} delay_interp;
+
+typedef struct {
+    double* buf;
+    size_t size;
+    size_t mask;
+    size_t write;
+    double ap_y1;
+} dsp_delay;
+
+dsp_delay* delay_create(size_t max_delay);
+void delay_free(dsp_delay* d);
+void delay_reset(dsp_delay* d);
+void delay_write(dsp_delay* d, double x);
+void delay_write_block(dsp_delay* d, const double* in, size_t n);
+double delay_read(const dsp_delay* d, size_t t);
+double delay_read_linear(const dsp_delay* d, double t);
+double delay_read_cubic(const dsp_delay* d, double t);
+double delay_read_lagrange(const dsp_delay* d, double t);
+double delay_read_allpass(dsp_delay* d, double t);
+void delay_read_taps(const dsp_delay* d, const double* times, double* out, size_t count,
+                     delay_interp interp);
+double delay_read_taps_sum(const dsp_delay* d, const double* times, const double* gains,
+                           size_t count, delay_interp interp);
+void delay_read_block(const dsp_delay* d, double* out, size_t n, double t, delay_interp interp);
+void delay_read_block_mod(const dsp_delay* d, const double* times, double* out, size_t n,
+                          delay_interp interp);
+
+// ADSR envelope: caller-allocated (ffi.new("dsp_adsr")), init with adsr_init
+typedef enum {
+    ADSR_IDLE = 0,
+    ADSR_ATTACK,
+    ADSR_DECAY,
+    ADSR_SUSTAIN,
+    ADSR_RELEASE
+} adsr_stage;
+
+typedef struct {
+    double level, velocity;
+    double step;
+    double step_a, step_d, step_r, sustain;
+    int stage;
+    double attack, decay, release, samplerate;
+} dsp_adsr;
+
+void adsr_init(dsp_adsr* e);
+void adsr_reset(dsp_adsr* e);
+void adsr_set(dsp_adsr* e, double attack, double decay, double sustain, double release,
+              double samplerate);
+void adsr_gate(dsp_adsr* e, double velocity);
+double adsr_tick(dsp_adsr* e);
+void adsr_process_block(dsp_adsr* e, double* out, size_t n);
+
+// Freeverb: opaque, create with freeverb_create and free with freeverb_free
+typedef struct dsp_freeverb dsp_freeverb;
+
+dsp_freeverb* freeverb_create(double samplerate);
+void freeverb_free(dsp_freeverb* r);
+void freeverb_reset(dsp_freeverb* r);
+void freeverb_set(dsp_freeverb* r, double room, double damp, double wet, double dry, double width);
+void freeverb_set_voicing(dsp_freeverb* r, double allpass_feedback, int lowpass);
+void freeverb_tick(dsp_freeverb* r, double in1, double in2, double* out1, double* out2);
+void freeverb_process_block(dsp_freeverb* r, const double* in1, const double* in2,
+                            double* out1, double* out2, size_t n);
+
+// CPU dispatch: active kernel variant ("sse2", "avx2", "avx512", "neon")
+const char* dsp_isa(void);
+int dsp_set_isa(const char* name);
 ]]
+end
 
 return dsp
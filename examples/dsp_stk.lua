@@ -15,6 +15,10 @@
 -- SAMPLE_RATE is automatically set by the luajit.stk~ external
 -- based on Max's audio settings. Default shown here for reference only.
 -- SAMPLE_RATE = SAMPLE_RATE or 44100.0
+--
+-- BLOCK_SIZE holds the signal vector size, and an optional
+-- dsp_prepare(samplerate, blocksize) function is called whenever DSP is
+-- compiled (see the delay example below).
 
 
 function dump(o)
@@ -69,16 +73,41 @@ sine = function(x, fb, n, p0, p1, p2, p3)
 end
 
 
--- Max delay time in secs (4096 samples / SAMPLE_RATE)
+-- Max delay time in secs
+--
+-- The delay line is sized from SAMPLE_RATE, which is only known once DSP
+-- is compiled. dsp_prepare() below rebuilds it at that point (on the main
+-- thread), so nothing is allocated in the audio callback.
 
 local _delay_max_seconds = 4.0
-local _delay_max_samples = _delay_max_seconds * SAMPLE_RATE
-
-local _delay = stk.Delay(SAMPLE_RATE / 100, _delay_max_samples) -- (initial delay = 448 samples ~10ms, maxDelay = _delay_max_seconds * SAMPLE_RATE)
+local _delay_max_samples
+local _delay
 local _delay_last_out = 0  -- store last delay output for feedback
-local _delay_current_length = SAMPLE_RATE / 100  -- track current delay length
+local _delay_current_length  -- track current delay length
 local _delay_debug_printed = false  -- debug flag
 
+local function delay_build(samplerate)
+   _delay_max_samples = math.floor(_delay_max_seconds * samplerate)
+   _delay_current_length = math.floor(samplerate / 100)  -- ~10ms
+   _delay = stk.Delay(_delay_current_length, _delay_max_samples)
+   _delay_last_out = 0
+end
+
+delay_build(SAMPLE_RATE)
+
+
+-- Called by the external when DSP is compiled (and after a reload):
+--   samplerate: current sample rate (also in SAMPLE_RATE)
+--   blocksize:  signal vector size (also in BLOCK_SIZE)
+-- stk.Stk.setSampleRate() has already been applied at this point, so
+-- existing STK oscillators and filters have recomputed their coefficients.
+-- Rebuild anything whose size or tables depend on the rate here.
+function dsp_prepare(samplerate, blocksize)
+   if _delay_max_samples ~= math.floor(_delay_max_seconds * samplerate) then
+      delay_build(samplerate)
+   end
+end
+
 delay = function(x, fb, n, p0, p1, p2, p3)
    -- p0: delay time in SECONDS (0.0 to ~0.093s at 44.1kHz)
    --     Examples: 0.01 = 10ms, 0.05 = 50ms, 0.5 = 500ms
@@ -16,6 +16,21 @@ end
 
 srate = 44100
 
+-- When the FFI library loads, Adsr, Filter and Reverb run on libdsp objects
+-- (dsp_adsr, dsp_biquad, dsp_freeverb) and Pitchshift keeps its buffer in a
+-- libdsp ring buffer; otherwise they fall back to Lua tables. Either way the
+-- control setters only store values and no tables are created per sample.
+local ffi, dsp_c
+pcall(function()
+	ffi = require 'ffi'
+	dsp_c = require 'dsp_ffi'
+end)
+if not (ffi and dsp_c) then dsp_c = nil end
+
+local function ffi_delay(max_delay)
+	return ffi.gc(dsp_c.delay_create(max_delay), dsp_c.delay_free)
+end
+
 Dsp = {}
 
 function Dsp:Mod(def, init)
@@ -111,34 +126,60 @@ end
 
 function Dsp:Adsr(init)
 
-	local arg = {
-		A = 0,
-		D = 0,
-		S = 1,
-		R = 0,
-		on = true,
-	}
+	local A, D, S, R = 0, 0, 1, 0
+	local gate, update, gen
+
+	if dsp_c then
+		local env = ffi.new("dsp_adsr")
+		dsp_c.adsr_init(env)
+
+		gate = function(val) dsp_c.adsr_gate(env, val) end
+		update = function() dsp_c.adsr_set(env, A, D, S, R, srate) end
+		gen = function() return dsp_c.adsr_tick(env) end
+	else
+		local state, v = nil, 0
+		local velocity = 0
+		local dv_A, dv_D, dv_R, level_S = 0, 0, 0, 1
+		local dv = 0
+
+		gate = function(val)
+			if val > 0 then
+				velocity = val
+				state, dv = "A", dv_A
+			end
+			if val == 0 then
+				state, dv = "R", dv_R
+			end
+		end
 
-	local state, v = nil, 0
-	local velocity = 0
-	local dv_A, dv_D, dv_R, level_S = 0, 0, 0, 1
-	local dv = 0
+		update = function()
+			dv_A = math.min(1/(srate * A), 1)
+			dv_D = math.max(-1/(srate * D), -1)
+			dv_R = math.max(-1/(srate * R), -1)
+			level_S = S
+		end
+
+		gen = function()
+			if state == "A" and v >= 1 then
+				state, dv = "D", dv_D
+			elseif state == "D" and v < level_S then
+				state, dv = "S", 0
+			end
+			v = v + dv
+			v = math.max(v, 0)
+			v = math.min(v, 1)
+			return v * velocity
+		end
+	end
 
 	return Dsp:Mod({
 		description = "ADSR envelope generator",
 		controls = {
+			fn_update = update,
 			{
 				id = "vel",
 				description = "Velocity",
-				fn_set = function(val)
-					if val > 0 then
-						velocity = val
-						state, dv = "A", dv_A
-					end
-					if val == 0 then
-						state, dv = "R", dv_R
-					end
-				end
+				fn_set = gate,
 			}, {
 				id = "A",
 				description = "Attack",
@@ -146,7 +187,7 @@ function Dsp:Adsr(init)
 				unit = "s",
 				default = 0.1,
 				fn_set = function(val)
-					dv_A =  math.min(1/(srate * val), 1)
+					A = val
 				end,
 			}, {
 				id = "D",
@@ -155,14 +196,14 @@ function Dsp:Adsr(init)
 				unit = "s",
 				default = 0.1,
 				fn_set = function(val)
-					dv_D = math.max(-1/(srate * val), -1)
+					D = val
 				end,
 			}, {
 				id = "S",
 				description = "Sustain",
 				default = 1,
 				fn_set = function(val)
-					level_S = val
+					S = val
 				end
 			}, {
 				id = "R",
@@ -171,21 +212,11 @@ function Dsp:Adsr(init)
 				unit = "s",
 				default = 0.1,
 				fn_set = function(val)
-					dv_R = math.max(-1/(srate * val), -1)
+					R = val
 				end
 			}, 
 		},
-		fn_gen = function()
-			if state == "A" and v >= 1 then
-				state, dv = "D", dv_D
-			elseif state == "D" and v < level_S then
-				state, dv = "S", 0
-			end
-			v = v + dv
-			v = math.max(v, 0)
-			v = math.min(v, 1)
-			return v * velocity
-		end,
+		fn_gen = gen,
 
 	}, init)
 end
@@ -322,61 +353,92 @@ end
 function Dsp:Filter(init)
 
 	local fs = 44100
-	local a0, a1, a2, b0, b1, b2
-	local x0, x1, x2 = 0, 0, 0
-	local y0, y1, y2 = 0, 0, 0
-
 	local type, f, Q, gain
+	local update, gen
+
+	if dsp_c then
+		-- libdsp's band pass has 0 dB peak gain, worp's a peak gain of Q
+		local types = { lp = 0, hp = 1, bp = 2, bs = 3, ls = 4, hs = 5, eq = 6, ap = 7 }
+		local bq = ffi.new("dsp_biquad")
+		local scale = 1
+		dsp_c.biquad_init(bq)
+
+		update = function()
+			local t = types[type]
+			if not t then
+				error("Unsupported filter type " .. type)
+			end
+			dsp_c.biquad_set(bq, t, f, Q, gain, fs)
+			scale = type == "bp" and Q or 1
+		end
+
+		gen = function(x0)
+			return dsp_c.biquad_tick(bq, x0) * scale
+		end
+	else
+		local a0, a1, a2, b0, b1, b2
+		local x0, x1, x2 = 0, 0, 0
+		local y0, y1, y2 = 0, 0, 0
+
+		update = function()
+			local w0 = 2 * math.pi * (f / fs)
+			local alpha = math.sin(w0) / (2*Q)
+			local cos_w0 = math.cos(w0)
+			local A = math.pow(10, gain/40)
+
+			if type == "hp" then
+				b0, b1, b2 = (1 + cos_w0)/2, -(1 + cos_w0), (1 + cos_w0)/2
+				a0, a1, a2 = 1 + alpha, -2*cos_w0, 1 - alpha
+
+			elseif type == "lp" then
+				b0, b1, b2 = (1 - cos_w0)/2, 1 - cos_w0, (1 - cos_w0)/2
+				a0, a1, a2 = 1 + alpha, -2*cos_w0, 1 - alpha
+
+			elseif type == "bp" then
+				b0, b1, b2 = Q*alpha, 0, -Q*alpha
+				a0, a1, a2 = 1 + alpha, -2*cos_w0, 1 - alpha
+
+			elseif type == "bs" then
+				b0, b1, b2 = 1, -2*cos_w0, 1
+				a0, a1, a2 = 1 + alpha, -2*cos_w0, 1 - alpha
+
+			elseif type == "ls" then
+				local ap1, am1, tsAa = A+1, A-1, 2 * math.sqrt(A) * alpha
+				local am1_cos_w0, ap1_cos_w0 = am1 * cos_w0, ap1 * cos_w0
+				b0, b1, b2 = A*( ap1 - am1_cos_w0 + tsAa ), 2*A*( am1 - ap1_cos_w0 ), A*( ap1 - am1_cos_w0 - tsAa )
+				a0, a1, a2 = ap1 + am1_cos_w0 + tsAa, -2*( am1 + ap1_cos_w0 ), ap1 + am1_cos_w0 - tsAa
+
+			elseif type == "hs" then
+				local ap1, am1, tsAa = A+1, A-1, 2 * math.sqrt(A) * alpha
+				local am1_cos_w0, ap1_cos_w0 = am1 * cos_w0, ap1 * cos_w0
+				b0, b1, b2 = A*( ap1 + am1_cos_w0 + tsAa ), -2*A*( am1 + ap1_cos_w0 ), A*( ap1 + am1_cos_w0 - tsAa )
+				a0, a1, a2 = ap1 - am1_cos_w0 + tsAa, 2*( am1 - ap1_cos_w0 ), ap1 - am1_cos_w0 - tsAa
+
+			elseif type == "eq" then
+				b0, b1, b2 = 1 + alpha*A, -2*cos_w0, 1 - alpha*A
+				a0, a1, a2 = 1 + alpha/A, -2*cos_w0, 1 - alpha/A
+
+			elseif type == "ap" then
+				b0, b1, b2 = 1 - alpha, -2*cos_w0, 1 + alpha
+				a0, a1, a2 = 1 + alpha, -2*cos_w0, 1 - alpha
+
+			else
+				error("Unsupported filter type " .. type)
+			end
+		end
+
+		gen = function(x0)
+			y2, y1 = y1, y0
+			y0 = (b0 / a0) * x0 + (b1 / a0) * x1 + (b2 / a0) * x2 - (a1 / a0) * y1 - (a2 / a0) * y2
+			x2, x1 = x1, x0
+			return y0
+		end
+	end
 
 	return Dsp:Mod({
 		description = "Biquad filter",
 		controls = {
-			fn_update = function()
-				local w0 = 2 * math.pi * (f / fs)
-				local alpha = math.sin(w0) / (2*Q)
-				local cos_w0 = math.cos(w0)
-				local A = math.pow(10, gain/40)
-
-				if type == "hp" then
-					b0, b1, b2 = (1 + cos_w0)/2, -(1 + cos_w0), (1 + cos_w0)/2
-					a0, a1, a2 = 1 + alpha, -2*cos_w0, 1 - alpha
-
-				elseif type == "lp" then
-					b0, b1, b2 = (1 - cos_w0)/2, 1 - cos_w0, (1 - cos_w0)/2
-					a0, a1, a2 = 1 + alpha, -2*cos_w0, 1 - alpha
-
-				elseif type == "bp" then
-					b0, b1, b2 = Q*alpha, 0, -Q*alpha
-					a0, a1, a2 = 1 + alpha, -2*cos_w0, 1 - alpha
-
-				elseif type == "bs" then
-					b0, b1, b2 = 1, -2*cos_w0, 1
-					a0, a1, a2 = 1 + alpha, -2*cos_w0, 1 - alpha
-
-				elseif type == "ls" then
-					local ap1, am1, tsAa = A+1, A-1, 2 * math.sqrt(A) * alpha
-					local am1_cos_w0, ap1_cos_w0 = am1 * cos_w0, ap1 * cos_w0
-					b0, b1, b2 = A*( ap1 - am1_cos_w0 + tsAa ), 2*A*( am1 - ap1_cos_w0 ), A*( ap1 - am1_cos_w0 - tsAa )
-					a0, a1, a2 = ap1 + am1_cos_w0 + tsAa, -2*( am1 + ap1_cos_w0 ), ap1 + am1_cos_w0 - tsAa
-
-				elseif type == "hs" then
-					local ap1, am1, tsAa = A+1, A-1, 2 * math.sqrt(A) * alpha
-					local am1_cos_w0, ap1_cos_w0 = am1 * cos_w0, ap1 * cos_w0
-					b0, b1, b2 = A*( ap1 + am1_cos_w0 + tsAa ), -2*A*( am1 + ap1_cos_w0 ), A*( ap1 + am1_cos_w0 - tsAa )
-					a0, a1, a2 = ap1 - am1_cos_w0 + tsAa, 2*( am1 - ap1_cos_w0 ), ap1 - am1_cos_w0 - tsAa
-
-				elseif type == "eq" then
-					b0, b1, b2 = 1 + alpha*A, -2*cos_w0, 1 - alpha*A
-					a0, a1, a2 = 1 + alpha/A, -2*cos_w0, 1 - alpha/A
-
-				elseif type == "ap" then
-					b0, b1, b2 = 1 - alpha, -2*cos_w0, 1 + alpha
-					a0, a1, a2 = 1 + alpha, -2*cos_w0, 1 - alpha
-
-				else
-					error("Unsupported filter type " .. type)
-				end
-			end,
+			fn_update = update,
 			{
 				id = "type",
 				description = "Filter type",
@@ -411,12 +473,7 @@ function Dsp:Filter(init)
 			}
 		},
 
-		fn_gen = function(x0)
-			y2, y1 = y1, y0
-			y0 = (b0 / a0) * x0 + (b1 / a0) * x1 + (b2 / a0) * x2 - (a1 / a0) * y1 - (a2 / a0) * y2
-			x2, x1 = x1, x0
-			return y0
-		end
+		fn_gen = gen,
 	}, init)
 
 end
@@ -569,22 +626,47 @@ function Dsp:Pitchshift(init)
 	
 	local floor = math.floor
 
-	for i = 0, size do buf[i] = 0 end
-
 	local function wrap(i)
 		return i % size
 	end
 
-	local function read(i) 
-		return buf[floor(wrap(i))] 
-	end
-	
-	local function read4(fi)
-		local i = floor(fi)
-		local f = fi - i
-		local a, b, c, d = read(i-1), read(i), read(i+1), read(i+2)
-		local c_b = c-b
-		return b + f * ( c_b - 0.16667 * (1.-f) * ( (d - a - 3*c_b) * f + (d + 2*a - 3*b)))
+	local read, write, read4
+
+	if dsp_c then
+		-- size - 4 rounds up to exactly size, so pw tracks the write index
+		local dl = ffi_delay(size - 4)
+		local data = dl.buf
+
+		read = function(i)
+			return data[floor(wrap(i))]
+		end
+
+		write = function(v)
+			dsp_c.delay_write(dl, v)
+		end
+
+		-- 4-point Lagrange, the delay counted from the slot after pw
+		read4 = function(fi)
+			return dsp_c.delay_read_lagrange(dl, wrap(pw + 1 - fi))
+		end
+	else
+		for i = 0, size do buf[i] = 0 end
+
+		read = function(i) 
+			return buf[floor(wrap(i))] 
+		end
+
+		write = function(v)
+			buf[pw] = v
+		end
+
+		read4 = function(fi)
+			local i = floor(fi)
+			local f = fi - i
+			local a, b, c, d = read(i-1), read(i), read(i+1), read(i+2)
+			local c_b = c-b
+			return b + f * ( c_b - 0.16667 * (1.-f) * ( (d - a - 3*c_b) * f + (d + 2*a - 3*b)))
+		end
 	end
 
 	local function find(pf, pt1, pt2)
@@ -626,7 +708,7 @@ function Dsp:Pitchshift(init)
 				return
 			end
 
-			buf[pw] = vi
+			write(vi)
 			local vo = read4(pr)
 
 			if mix > 0 then
@@ -673,98 +755,130 @@ end
 
 function Dsp:Reverb(init)
 
-	local function allpass(bufsize)
-		local buffer = {}
-		local feedback = 0
-		local bufidx = 0
-		return function(input)
-			local bufout = buffer[bufidx] or 0
-			local output = -input + bufout
-			buffer[bufidx] = input + (bufout*feedback)
-			bufidx = (bufidx + 1) % bufsize
-			return output
+	local scaledry = 2
+	local initialwidth = 2
+
+	local arg_wet, arg_dry, arg_room, arg_damp
+	local update, gen
+
+	if dsp_c then
+		-- worp's delay lengths are in samples at any rate (44.1 kHz tuning),
+		-- its allpasses have no feedback and its damping has no filter memory
+		local rv = ffi.gc(dsp_c.freeverb_create(44100), dsp_c.freeverb_free)
+		dsp_c.freeverb_set_voicing(rv, 0, 0)
+		local out1, out2 = ffi.new("double[1]"), ffi.new("double[1]")
+
+		update = function()
+			dsp_c.freeverb_set(rv, arg_room, arg_damp, arg_wet, (arg_dry or 0) * scaledry, initialwidth)
 		end
-	end
 
-	local comb_fb = 0
-	local comb_damp1 = 0.5
-	local comb_damp2 = 0.5
-
-	local function fcomb(bufsize, feedback, damp)
-		local buffer = {}
-		local bufidx = 0
-		local filterstore = 0
-		return function(input)
-			local output = buffer[bufidx] or 0
-			local filterstore = (output*comb_damp2) + (filterstore*comb_damp1)
-			buffer[bufidx] = input + (filterstore*comb_fb)
-			bufidx = (bufidx + 1) % bufsize
-			return output
+		gen = function(in1, in2)
+			in2 = in2 or in1
+			dsp_c.freeverb_tick(rv, in1, in2, out1, out2)
+			return out1[0], out2[0]
+		end
+	else
+		local function allpass(bufsize)
+			local feedback = 0
+			local buffer = {}
+			local bufidx = 0
+			return function(input)
+				local bufout = buffer[bufidx] or 0
+				local output = -input + bufout
+				buffer[bufidx] = input + (bufout*feedback)
+				bufidx = (bufidx + 1) % bufsize
+				return output
+			end
 		end
-	end
 
-	local fixedgain = 0.015
-	local scalewet = 3
-	local scaledry = 2
-	local scaledamp = 0.4
-	local scaleroom = 0.28
-	local offsetroom = 0.7
-	local stereospread = 23
-
-	local comb, allp
-	local gain
-	local dry, wet1, wet2
-
-	local comb, allp = { 
-		{
-			fcomb(1116), fcomb(1188), 
-			fcomb(1277), fcomb(1356),
-			fcomb(1422), fcomb(1491), 
-			fcomb(1557), fcomb(1617),
+		local comb_fb = 0
+		local comb_damp2 = 0.5
+
+		local function fcomb(bufsize, feedback, damp)
+			local buffer = {}
+			local bufidx = 0
+			return function(input)
+				local output = buffer[bufidx] or 0
+				local filterstore = output*comb_damp2
+				buffer[bufidx] = input + (filterstore*comb_fb)
+				bufidx = (bufidx + 1) % bufsize
+				return output
+			end
+		end
+
+		local fixedgain = 0.015
+		local scaledamp = 0.4
+		local scaleroom = 0.28
+		local offsetroom = 0.7
+		local stereospread = 23
+
+		local gain
+		local dry, wet1, wet2
+
+		local comb, allp = { 
+			{
+				fcomb(1116), fcomb(1188), 
+				fcomb(1277), fcomb(1356),
+				fcomb(1422), fcomb(1491), 
+				fcomb(1557), fcomb(1617),
+			}, {
+				fcomb(1116+stereospread), fcomb(1188+stereospread),
+				fcomb(1277+stereospread), fcomb(1356+stereospread),
+				fcomb(1422+stereospread), fcomb(1491+stereospread),
+				fcomb(1557+stereospread), fcomb(1617+stereospread),
+			}
 		}, {
-			fcomb(1116+stereospread), fcomb(1188+stereospread),
-			fcomb(1277+stereospread), fcomb(1356+stereospread),
-			fcomb(1422+stereospread), fcomb(1491+stereospread),
-			fcomb(1557+stereospread), fcomb(1617+stereospread),
-		}
-	}, {
-		{ 
-			allpass(556), allpass(441), allpass(341), allpass(225), 
-		}, { 
-			allpass(556+stereospread), allpass(441+stereospread), 
-			allpass(341+stereospread), allpass(225+stereospread), 
+			{ 
+				allpass(556), allpass(441), allpass(341), allpass(225), 
+			}, { 
+				allpass(556+stereospread), allpass(441+stereospread), 
+				allpass(341+stereospread), allpass(225+stereospread), 
+			}
 		}
-	}
 
-	local arg_wet, arg_dry, arg_room, arg_damp
+		update = function()
+			local wet = arg_wet
+			local roomsize = (arg_room*scaleroom) + offsetroom
+			dry = (arg_dry or 0) * scaledry
+			local damp = arg_damp * scaledamp
+			local width = initialwidth
+
+			wet1 = wet*(width/2 + 0.5)
+			wet2 = wet*((1-width)/2)
+
+			comb_fb = roomsize
+			comb_damp2 = 1 - damp
+			gain = fixedgain
+		end
+
+		gen = function(in1, in2)
+			in2 = in2 or in1
+			local input = (in1 + in2) * gain
+
+			local comb1, comb2 = comb[1], comb[2]
+			local allp1, allp2 = allp[1], allp[2]
+			local o1, o2 = 0, 0
+
+			for i = 1, #comb1 do
+				o1 = o1 + comb1[i](input)
+				o2 = o2 + comb2[i](input)
+			end
+			for i = 1, #allp1 do
+				o1 = allp1[i](o1)
+				o2 = allp2[i](o2)
+			end
+
+			local out1 = o1*wet1 + o2*wet2 + in1*dry
+			local out2 = o2*wet1 + o1*wet2 + in2*dry
+
+			return out1, out2
+		end
+	end
 
 	return Dsp:Mod({
 		description = "Reverb",
 		controls = {
-			fn_update = function()
-				local initialroom = arg_room 
-				local initialdamp = arg_damp 
-				local initialwet = arg_wet/scalewet
-				local initialdry = arg_dry or 0
-				local initialwidth = 2
-				local initialmode = 0
-
-				local wet = initialwet * scalewet
-				local roomsize = (initialroom*scaleroom) + offsetroom
-				dry = initialdry * scaledry
-				local damp = initialdamp * scaledamp
-				local width = initialwidth
-				local mode = initialmode
-
-				wet1 = wet*(width/2 + 0.5)
-				wet2 = wet*((1-width)/2)
-
-				comb_fb = roomsize
-				comb_damp1 = damp
-				comb_damp2 = 1 - damp
-				gain = fixedgain
-
-			end,
+			fn_update = update,
 			{
 				id = "wet",
 				description = "Wet volume",
@@ -792,26 +906,7 @@ function Dsp:Reverb(init)
 				fn_set = function(val) arg_damp = val end
 			}
 		},
-		fn_gen = function(in1, in2)
-			in2 = in2 or in1
-			local input = (in1 + in2) * gain
-			
-			local out = { 0, 0 }
-
-			for c = 1, 2 do
-				for i = 1, #comb[c] do
-					out[c] = out[c] + comb[c][i](input)
-				end
-				for i = 1, #allp[c] do
-					out[c] = allp[c][i](out[c])
-				end
-			end
-
-			local out1 = out[1]*wet1 + out[2]*wet2 + in1*dry
-			local out2 = out[2]*wet1 + out[1]*wet2 + in2*dry
-
-			return out1, out2
-		end
+		fn_gen = gen,
 	}, init)
 
 end
@@ -877,7 +972,7 @@ function Dsp:Square(init)
 				unit = "Hz",
 				default = 440,
 				fn_set = function(val)
-					saw:set { f = val }
+					saw:set("f", val)
 				end
 			}, {
 				id = "pwm",
@@ -4,6 +4,11 @@
 
     This header provides common functionality shared between luajit~ and luajit.stk~
     including message handlers, DSP callbacks, and initialization patterns.
+
+    Define LUAJIT_ENGINE_ONLY before including to get only the lua_engine_*
+    functions without any Max SDK dependency (used by the standalone
+    benchmark in luajit.stk~/tests/test_luabridge). The includer must then
+    provide error().
 */
 
 #ifndef LUAJIT_EXTERNAL_H
@@ -14,14 +19,23 @@
 #include <math.h>
 #include <libgen.h>
 #include <unistd.h>
+#ifndef LUAJIT_ENGINE_ONLY
 #include "ext.h"
 #include "ext_obex.h"
 #include "ext_strings.h"
 #include "z_dsp.h"
+#endif
 #include <lua.h>
 #include <lualib.h>
 #include <lauxlib.h>
+#ifndef LUAJIT_ENGINE_ONLY
 #include "luajit_api.h"
+#endif
+#ifdef LUAJIT_WITH_LIBDSP
+#include <dlfcn.h>
+#include "libdsp.h"
+#include "libdsp_cdef.h"
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -30,6 +44,43 @@ extern "C" {
 // Maximum number of dynamic parameters
 #define LUAJIT_MAX_PARAMS 32
 
+#ifdef LUAJIT_ENGINE_ONLY
+void error(const char* fmt, ...);   // provided by the standalone host
+#else
+
+//------------------------------------------------------------------------------
+// Event Queue State (audio thread -> scheduler)
+//------------------------------------------------------------------------------
+
+// Queue capacity in events (must be a power of two)
+#define LUAJIT_EVENT_QUEUE_SIZE 1024
+
+// Event ids accepted by emit() (0 .. LUAJIT_EVENT_MAX_IDS - 1)
+#define LUAJIT_EVENT_MAX_IDS 64
+
+typedef struct {
+    int id;
+    double value;
+} luajit_event;
+
+/**
+ * Single-producer/single-consumer ring written by the thread that runs the
+ * DSP function and drained by a clock on the scheduler thread.
+ * head and tail are free-running counters, accessed atomically.
+ */
+typedef struct {
+    luajit_event ring[LUAJIT_EVENT_QUEUE_SIZE];
+    unsigned int head;          // next slot to write (producer)
+    unsigned int tail;          // next slot to read (consumer)
+    unsigned int dropped;       // events lost to a full queue
+    int scheduled;              // drain clock armed
+    int coalesce;               // only the last value per id per drain
+    double interval;            // ms between drains (0 = next scheduler tick)
+    void* outlet;               // message outlet
+    t_clock* clock;             // drain clock
+    t_symbol* names[LUAJIT_EVENT_MAX_IDS]; // optional selector per id
+} luajit_events;
+
 //------------------------------------------------------------------------------
 // Engine State Structure
 //------------------------------------------------------------------------------
@@ -50,7 +101,10 @@ typedef struct {
     double samplerate;          // Current sample rate
     long vectorsize;            // Current vector size
     char in_error_state;        // Error flag (1 = in error, 0 = ok)
+    luajit_events* events;      // emit() queue (NULL unless attached)
+    LuaMailbox* mailbox;        // callbacks and messages, run between blocks
 } luajit_engine;
+#endif // LUAJIT_ENGINE_ONLY
 
 //------------------------------------------------------------------------------
 // Core Lua Engine Functions (from lua_engine.c)
@@ -86,6 +140,51 @@ static inline void lua_engine_free(lua_State* L) {
     }
 }
 
+/**
+ * Declare the statically linked libdsp to the FFI (no-op unless the external
+ * links libdsp_objects, which defines LUAJIT_WITH_LIBDSP).
+ *
+ * Afterwards require 'dsp_ffi' returns ffi.C, so scripts call libdsp
+ * directly without loading a shared library. The external's own symbols are
+ * made global once per process, because ffi.C only searches the global
+ * namespace and plugins are normally loaded with local visibility.
+ */
+static inline int lua_engine_preload_libdsp(lua_State* L) {
+#ifdef LUAJIT_WITH_LIBDSP
+    static int promoted = 0;
+    if (!promoted) {
+        Dl_info info;
+        if (dladdr((void*)&dsp_isa, &info) && info.dli_fname) {
+            // The handle is kept for the life of the process
+            dlopen(info.dli_fname, RTLD_NOW | RTLD_NOLOAD | RTLD_GLOBAL);
+        }
+        promoted = 1;
+    }
+
+    static const char chunk[] =
+        "local cdef = ...\n"
+        "local ffi = require 'ffi'\n"
+        "ffi.cdef(cdef)\n"
+        "if pcall(function() return ffi.C.dsp_isa end) then\n"
+        "   package.loaded.dsp_ffi = ffi.C\n"
+        "end\n";
+    if (luaL_loadbuffer(L, chunk, sizeof(chunk) - 1, "=libdsp") != 0) {
+        error("lua_engine: %s", lua_tostring(L, -1));
+        lua_pop(L, 1);
+        return -1;
+    }
+    lua_pushlstring(L, LIBDSP_CDEF, sizeof(LIBDSP_CDEF) - 1);
+    if (lua_pcall(L, 1, 0, 0) != 0) {
+        error("lua_engine: libdsp: %s", lua_tostring(L, -1));
+        lua_pop(L, 1);
+        return -1;
+    }
+#else
+    (void)L;
+#endif
+    return 0;
+}
+
 /**
  * Run Lua code from string
  */
@@ -161,6 +260,40 @@ static inline void lua_engine_set_samplerate(lua_State* L, double samplerate) {
     lua_setglobal(L, "SAMPLE_RATE");
 }
 
+/**
+ * Set block size global in Lua
+ */
+static inline void lua_engine_set_blocksize(lua_State* L, long blocksize) {
+    lua_pushinteger(L, blocksize);
+    lua_setglobal(L, "BLOCK_SIZE");
+}
+
+/**
+ * Call the optional Lua hook dsp_prepare(samplerate, blocksize).
+ *
+ * Runs on the main thread when DSP is compiled (and after a reload), so
+ * scripts can size delay lines and rebuild rate-dependent tables there
+ * instead of in the audio callback.
+ *
+ * Returns 0 if the hook is absent or succeeded, -1 on a Lua error.
+ */
+static inline int lua_engine_call_prepare(lua_State* L, double samplerate, long blocksize) {
+    lua_getglobal(L, "dsp_prepare");
+    if (!lua_isfunction(L, -1)) {
+        lua_pop(L, 1);
+        return 0;
+    }
+
+    lua_pushnumber(L, samplerate);
+    lua_pushinteger(L, blocksize);
+    if (lua_pcall(L, 2, 0, 0) != 0) {
+        error("lua_engine: dsp_prepare: %s", lua_tostring(L, -1));
+        lua_pop(L, 1);
+        return -1;
+    }
+    return 0;
+}
+
 /**
  * Configure GC for real-time use (legacy - now done in lua_engine_init)
  */
@@ -366,6 +499,8 @@ static inline float lua_engine_call_dsp_dynamic(lua_State* L, int func_ref, char
     return validate_and_clamp_result(L, error_flag);
 }
 
+#ifndef LUAJIT_ENGINE_ONLY
+
 //------------------------------------------------------------------------------
 // Max Helpers (from max_helpers.c)
 //------------------------------------------------------------------------------
@@ -495,6 +630,62 @@ typedef void (*luajit_run_file_func)(void* context);
  */
 typedef void (*luajit_list_extra_func)(void* context, long argc, t_atom* argv);
 
+//------------------------------------------------------------------------------
+// Mailbox Commands
+//------------------------------------------------------------------------------
+
+/*
+ * Message handlers do not call into Lua themselves: they queue these on the
+ * engine mailbox, which runs them before the next block while DSP is on and
+ * at once while it is off. Their messages go through api_post_any() and
+ * api_error_any(), since they may run on the audio thread.
+ */
+
+// Clear PARAMS before a new set of named parameters
+static void luajit_cmd_clear_params(void* ud, t_symbol* s, double value)
+{
+    luajit_engine* engine = (luajit_engine*)ud;
+    lua_engine_clear_named_params(engine->L);
+}
+
+// PARAMS[s] = value
+static void luajit_cmd_set_param(void* ud, t_symbol* s, double value)
+{
+    luajit_engine* engine = (luajit_engine*)ud;
+    lua_engine_set_named_param(engine->L, s->s_name, value);
+}
+
+// Switch the DSP function to s. value is nonzero when parameters follow, in
+// which case an unknown name leaves the current function running.
+static void luajit_cmd_switch(void* ud, t_symbol* s, double value)
+{
+    luajit_engine* engine = (luajit_engine*)ud;
+    int new_ref = lua_engine_cache_function(engine->L, s->s_name);
+    if (new_ref == LUA_NOREF) {
+        if (value == 0.0) {
+            api_error_any("'%s' is not a function", s->s_name);
+            engine->in_error_state = 1;
+        }
+        return;
+    }
+    int old_ref = engine->func_ref;
+    engine->func_ref = new_ref;
+    engine->funcname = s;
+    lua_engine_release_function(engine->L, old_ref);
+    engine->in_error_state = 0;
+    api_post_any("funcname: %s", s->s_name);
+}
+
+// Publish the compiled sample rate (value) and vector size to the script
+static void luajit_cmd_prepare(void* ud, t_symbol* s, double value)
+{
+    luajit_engine* engine = (luajit_engine*)ud;
+    long vectorsize = __atomic_load_n(&engine->vectorsize, __ATOMIC_RELAXED);
+    lua_engine_set_samplerate(engine->L, value);
+    lua_engine_set_blocksize(engine->L, vectorsize);
+    lua_engine_call_prepare(engine->L, value, vectorsize);
+}
+
 //------------------------------------------------------------------------------
 // Message Handlers (Inline Implementations)
 //------------------------------------------------------------------------------
@@ -512,6 +703,10 @@ static inline void luajit_handle_bang(luajit_engine* engine,
                                       luajit_run_file_func run_file,
                                       const char* error_prefix)
 {
+    // Hold the VM while the script reloads: a block (or a pipeline worker)
+    // outputs silence instead of running Lua alongside this thread
+    bool entered = engine->mailbox && mailbox_enter(engine->mailbox);
+
     // Save old reference for later cleanup
     int old_ref = engine->func_ref;
 
@@ -522,6 +717,12 @@ static inline void luajit_handle_bang(luajit_engine* engine,
     // Reload file
     run_file(context);
 
+    // Re-run the prepare hook once DSP has been compiled, so reloaded
+    // objects are sized for the current rate rather than the default
+    if (engine->vectorsize > 0) {
+        lua_engine_call_prepare(engine->L, engine->samplerate, engine->vectorsize);
+    }
+
     // Re-cache the current function
     int new_ref = lua_engine_cache_function(engine->L, engine->funcname->s_name);
     if (new_ref == LUA_NOREF) {
@@ -537,6 +738,10 @@ static inline void luajit_handle_bang(luajit_engine* engine,
 
     // Release old reference after swap
     lua_engine_release_function(engine->L, old_ref);
+
+    if (entered) {
+        mailbox_leave(engine->mailbox);
+    }
 }
 
 /**
@@ -592,21 +797,18 @@ static inline void luajit_handle_list(luajit_engine* engine,
             return;
         }
 
-        // Clear existing named parameters
-        lua_engine_clear_named_params(engine->L);
-
         for (long i = 0; i < argc; i += 2) {
             if (atom_gettype(argv + i) != A_SYM) {
                 error("%s: parameter names must be symbols", error_prefix);
                 return;
             }
+        }
 
-            t_symbol* param_name = atom_getsym(argv + i);
-            const char* name = param_name->s_name;
-            double value = atom_getfloat(argv + i + 1);
-
-            // Set named parameter in Lua PARAMS table
-            lua_engine_set_named_param(engine->L, name, value);
+        // PARAMS lives in the VM: replace it between blocks
+        mailbox_call(engine->mailbox, luajit_cmd_clear_params, engine, NULL, 0.0);
+        for (long i = 0; i < argc; i += 2) {
+            mailbox_call(engine->mailbox, luajit_cmd_set_param, engine,
+                         atom_getsym(argv + i), atom_getfloat(argv + i + 1));
         }
         post("set %ld named params", argc / 2);
     }
@@ -637,56 +839,13 @@ static inline void luajit_handle_anything(luajit_engine* engine,
                                           const char* error_prefix)
 {
     if (s != gensym("")) {
-        // Check if this is a named parameter message with arguments
+        // The function is looked up and swapped between blocks. With
+        // arguments, s is either a function followed by parameters
+        // ("funcname param1 val1") or not a function, in which case the
+        // parameters are still applied.
+        mailbox_call(engine->mailbox, luajit_cmd_switch, engine, s, argc > 0 ? 1.0 : 0.0);
         if (argc > 0) {
-            // Silence audio before touching Lua state (thread safety)
-            char was_in_error = engine->in_error_state;
-            engine->in_error_state = 1;
-
-            // Check if 's' is a valid function name
-            // Try to cache it - if it succeeds, this is a combined function+params message
-            int test_ref = lua_engine_cache_function(engine->L, s->s_name);
-
-            if (test_ref != LUA_NOREF) {
-                // Valid function - this is combined syntax: "funcname param1 val1 param2 val2"
-                // Swap to new function reference (cache first, then release old)
-                int old_ref = engine->func_ref;
-                engine->func_ref = test_ref;  // Atomic swap
-                engine->funcname = s;
-                lua_engine_release_function(engine->L, old_ref);  // Release after swap
-                post("funcname: %s", s->s_name);
-
-                // Now process the parameters
-                luajit_handle_list(engine, context, s, argc, argv, extra, error_prefix);
-
-                // Re-enable audio
-                engine->in_error_state = 0;
-            } else {
-                // Not a function - treat as named parameters only
-                engine->in_error_state = was_in_error;  // Restore state
-                luajit_handle_list(engine, context, s, argc, argv, extra, error_prefix);
-            }
-        } else {
-            // No arguments - just switch function
-            // Silence audio before touching Lua state (thread safety)
-            engine->in_error_state = 1;
-
-            // Get the new function and cache its reference first
-            int new_ref = lua_engine_cache_function(engine->L, s->s_name);
-            if (new_ref == LUA_NOREF) {
-                error("%s: '%s' is not a function", error_prefix, s->s_name);
-                // Stay in error state
-            } else {
-                // Swap to new function reference (atomic swap, then release old)
-                int old_ref = engine->func_ref;
-                engine->func_ref = new_ref;  // Atomic swap
-                engine->funcname = s;
-                lua_engine_release_function(engine->L, old_ref);  // Release after swap
-                post("funcname: %s", s->s_name);
-
-                // Re-enable audio
-                engine->in_error_state = 0;
-            }
+            luajit_handle_list(engine, context, s, argc, argv, extra, error_prefix);
         }
     }
 }
@@ -737,10 +896,11 @@ static inline void luajit_handle_dsp64(luajit_engine* engine,
 
     // Store sample rate and vector size
     engine->samplerate = samplerate;
-    engine->vectorsize = maxvectorsize;
+    __atomic_store_n(&engine->vectorsize, maxvectorsize, __ATOMIC_RELAXED);
 
-    // Update Lua global
-    lua_engine_set_samplerate(engine->L, samplerate);
+    // Update Lua globals and let the script rebuild rate-dependent state:
+    // now if DSP is off, else before the next block of the running chain
+    mailbox_call(engine->mailbox, luajit_cmd_prepare, engine, NULL, samplerate);
 
     object_method(dsp64, gensym("dsp_add64"), context, perform_func, 0, NULL);
 }
@@ -773,11 +933,18 @@ static inline void luajit_handle_perform64(luajit_engine* engine,
     int n = sampleframes;
     double prev = engine->prev_sample;
 
+    // Run queued callbacks and messages, then keep the VM for this block.
+    // Only a reload holding it keeps the block out of Lua.
+    bool held = !engine->mailbox || mailbox_begin_block(engine->mailbox);
+
     // If in error state, output silence
-    if (engine->in_error_state) {
+    if (!held || engine->in_error_state) {
         while (n--) {
             *outL++ = 0.0;
         }
+        if (held && engine->mailbox) {
+            mailbox_end_block(engine->mailbox);
+        }
         return;
     }
 
@@ -795,6 +962,207 @@ static inline void luajit_handle_perform64(luajit_engine* engine,
     }
 
     engine->prev_sample = prev;
+
+    if (engine->mailbox) {
+        mailbox_end_block(engine->mailbox);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Event Queue (audio thread -> scheduler)
+//------------------------------------------------------------------------------
+
+/*
+ * DSP functions must not call outlets or post() from perform64. Instead they
+ * call emit(id, value), which only writes to a lock-free queue and arms a
+ * clock; the clock drains the queue on the scheduler thread and sends each
+ * event from the external's message outlet:
+ *
+ *   emit(0, level)            -> list "0 <level>"
+ *   events.name(0, "level")   -> afterwards "level <level>"
+ *
+ * With events.coalesce(true) a drain sends only the last value of each id,
+ * in order of first arrival, which suits meters and trackers emitting every
+ * block. events.interval(ms) batches events for that long before a drain.
+ * A full queue drops the event; events.stats() reports the count.
+ */
+
+/**
+ * Queue one event (producer thread only). Returns 0 if the queue was full.
+ */
+static inline int luajit_events_push(luajit_events* ev, int id, double value) {
+    unsigned int head = ev->head;
+    unsigned int tail = __atomic_load_n(&ev->tail, __ATOMIC_ACQUIRE);
+    if (head - tail >= LUAJIT_EVENT_QUEUE_SIZE) {
+        __atomic_fetch_add(&ev->dropped, 1, __ATOMIC_RELAXED);
+        return 0;
+    }
+    luajit_event* slot = &ev->ring[head & (LUAJIT_EVENT_QUEUE_SIZE - 1)];
+    slot->id = id;
+    slot->value = value;
+    __atomic_store_n(&ev->head, head + 1, __ATOMIC_RELEASE);
+
+    // Arm the drain once; the clock clears the flag before draining, so an
+    // event pushed during a drain schedules the next one
+    if (!__atomic_exchange_n(&ev->scheduled, 1, __ATOMIC_ACQ_REL)) {
+        clock_fdelay(ev->clock, ev->interval);
+    }
+    return 1;
+}
+
+static inline void luajit_events_send(luajit_events* ev, int id, double value) {
+    t_atom av[2];
+    t_symbol* name = ev->names[id];
+    if (name) {
+        atom_setfloat(av, value);
+        outlet_anything(ev->outlet, name, 1, av);
+    } else {
+        atom_setlong(av, id);
+        atom_setfloat(av + 1, value);
+        outlet_list(ev->outlet, NULL, 2, av);
+    }
+}
+
+/**
+ * Clock callback: send everything queued so far (scheduler thread).
+ */
+static inline void luajit_events_tick(luajit_events* ev) {
+    __atomic_store_n(&ev->scheduled, 0, __ATOMIC_RELEASE);
+
+    unsigned int tail = ev->tail;
+    unsigned int head = __atomic_load_n(&ev->head, __ATOMIC_ACQUIRE);
+
+    if (!ev->coalesce) {
+        while (tail != head) {
+            luajit_event e = ev->ring[tail & (LUAJIT_EVENT_QUEUE_SIZE - 1)];
+            __atomic_store_n(&ev->tail, ++tail, __ATOMIC_RELEASE);
+            luajit_events_send(ev, e.id, e.value);
+        }
+        return;
+    }
+
+    double last[LUAJIT_EVENT_MAX_IDS];
+    unsigned char seen[LUAJIT_EVENT_MAX_IDS];
+    int order[LUAJIT_EVENT_MAX_IDS];
+    int count = 0;
+    memset(seen, 0, sizeof(seen));
+
+    while (tail != head) {
+        const luajit_event* e = &ev->ring[tail & (LUAJIT_EVENT_QUEUE_SIZE - 1)];
+        if (!seen[e->id]) {
+            seen[e->id] = 1;
+            order[count++] = e->id;
+        }
+        last[e->id] = e->value;
+        tail++;
+    }
+    // Release the slots before sending, so output never holds up the producer
+    __atomic_store_n(&ev->tail, tail, __ATOMIC_RELEASE);
+
+    for (int i = 0; i < count; i++) {
+        luajit_events_send(ev, order[i], last[order[i]]);
+    }
+}
+
+static inline luajit_events* luajit_events_owner(lua_State* L) {
+    return (luajit_events*)lua_touserdata(L, lua_upvalueindex(1));
+}
+
+// emit(id [, value]) -> queued (audio thread safe: no allocation, no locks)
+static inline int luajit_events_emit(lua_State* L) {
+    luajit_events* ev = luajit_events_owner(L);
+    int id = (int)luaL_checkinteger(L, 1);
+    if (id < 0 || id >= LUAJIT_EVENT_MAX_IDS) {
+        return luaL_error(L, "emit: id %d out of range [0, %d]", id, LUAJIT_EVENT_MAX_IDS - 1);
+    }
+    lua_pushboolean(L, luajit_events_push(ev, id, luaL_optnumber(L, 2, 1.0)));
+    return 1;
+}
+
+// events.coalesce(on)
+static inline int luajit_events_coalesce(lua_State* L) {
+    luajit_events_owner(L)->coalesce = lua_toboolean(L, 1);
+    return 0;
+}
+
+// events.interval(ms)
+static inline int luajit_events_interval(lua_State* L) {
+    double ms = luaL_checknumber(L, 1);
+    luajit_events_owner(L)->interval = ms > 0.0 ? ms : 0.0;
+    return 0;
+}
+
+// events.name(id, selector) - selector nil restores "id value" lists
+static inline int luajit_events_name(lua_State* L) {
+    luajit_events* ev = luajit_events_owner(L);
+    int id = (int)luaL_checkinteger(L, 1);
+    if (id < 0 || id >= LUAJIT_EVENT_MAX_IDS) {
+        return luaL_error(L, "events.name: id %d out of range [0, %d]", id, LUAJIT_EVENT_MAX_IDS - 1);
+    }
+    ev->names[id] = lua_isnoneornil(L, 2) ? NULL : gensym(luaL_checkstring(L, 2));
+    return 0;
+}
+
+// events.stats() -> queued, dropped
+static inline int luajit_events_stats(lua_State* L) {
+    luajit_events* ev = luajit_events_owner(L);
+    unsigned int head = __atomic_load_n(&ev->head, __ATOMIC_ACQUIRE);
+    unsigned int tail = __atomic_load_n(&ev->tail, __ATOMIC_ACQUIRE);
+    lua_pushinteger(L, (lua_Integer)(head - tail));
+    lua_pushinteger(L, (lua_Integer)__atomic_load_n(&ev->dropped, __ATOMIC_RELAXED));
+    return 2;
+}
+
+/**
+ * Give an engine an event queue that drains into outlet, and register the
+ * Lua global emit() and the events table. Call from the external's new
+ * method after luajit_new(), passing a message outlet of the external.
+ *
+ * @return 0 on success, -1 on failure
+ */
+static inline int luajit_events_attach(luajit_engine* engine, void* outlet) {
+    static const luaL_Reg event_funcs[] = {
+        {"coalesce", luajit_events_coalesce},
+        {"interval", luajit_events_interval},
+        {"name",     luajit_events_name},
+        {"stats",    luajit_events_stats},
+        {NULL, NULL}
+    };
+
+    luajit_events* ev = (luajit_events*)calloc(1, sizeof(luajit_events));
+    if (!ev) {
+        return -1;
+    }
+    ev->outlet = outlet;
+    ev->clock = (t_clock*)clock_new(ev, (method)luajit_events_tick);
+    engine->events = ev;
+
+    lua_State* L = engine->L;
+    lua_pushlightuserdata(L, ev);
+    lua_pushcclosure(L, luajit_events_emit, 1);
+    lua_setglobal(L, "emit");
+
+    lua_newtable(L);
+    for (const luaL_Reg* f = event_funcs; f->name; f++) {
+        lua_pushlightuserdata(L, ev);
+        lua_pushcclosure(L, f->func, 1);
+        lua_setfield(L, -2, f->name);
+    }
+    lua_setglobal(L, "events");
+    return 0;
+}
+
+/**
+ * Stop the drain clock and free the queue. The DSP chain must be gone.
+ */
+static inline void luajit_events_free(luajit_events* ev) {
+    if (ev) {
+        if (ev->clock) {
+            clock_unset(ev->clock);
+            object_free(ev->clock);
+        }
+        free(ev);
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -839,6 +1207,7 @@ static inline luajit_engine* luajit_new(luajit_custom_bindings_func custom_bindi
     // Set initial sample rate (will be updated in dsp64)
     engine->samplerate = 44100.0;
     lua_engine_set_samplerate(engine->L, engine->samplerate);
+    lua_engine_set_blocksize(engine->L, 64);
 
     // Initialize function reference to invalid
     engine->func_ref = LUA_NOREF;
@@ -846,15 +1215,29 @@ static inline luajit_engine* luajit_new(luajit_custom_bindings_func custom_bindi
     engine->num_params = 0;
     engine->prev_sample = 0.0;
     engine->vectorsize = 0;
+    engine->events = NULL;
 
     // Initialize the shared Max API module for Lua
     luajit_api_init(engine->L);
 
+    // Run Clock and Qelem callbacks and messages between the DSP function's
+    // blocks. Without a mailbox they run directly, racing the audio thread.
+    engine->mailbox = mailbox_new();
+    if (engine->mailbox) {
+        mailbox_attach(engine->L, engine->mailbox);
+    } else {
+        error("%s: failed to allocate the callback mailbox", error_prefix);
+    }
+
+    // Declare the built-in libdsp; scripts still run without it
+    lua_engine_preload_libdsp(engine->L);
+
     // Call custom bindings if provided
     if (custom_bindings) {
         if (custom_bindings(engine->L) != 0) {
             error("%s: custom bindings initialization failed", error_prefix);
             lua_engine_free(engine->L);
+            mailbox_free(engine->mailbox);
             free(engine);
             return NULL;
         }
@@ -871,6 +1254,9 @@ static inline luajit_engine* luajit_new(luajit_custom_bindings_func custom_bindi
 static inline void luajit_free(luajit_engine* engine)
 {
     if (engine) {
+        luajit_events_free(engine->events);
+        engine->events = NULL;
+
         if (engine->L) {
             // Release cached function reference
             if (engine->func_ref != LUA_NOREF) {
@@ -883,11 +1269,17 @@ static inline void luajit_free(luajit_engine* engine)
             engine->L = NULL;
         }
 
+        // After lua_close(): collecting clocks and qelems releases their slots
+        mailbox_free(engine->mailbox);
+        engine->mailbox = NULL;
+
         // Free the engine itself
         free(engine);
     }
 }
 
+#endif // LUAJIT_ENGINE_ONLY
+
 #ifdef __cplusplus
 }
 #endif
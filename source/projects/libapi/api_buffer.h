@@ -8,18 +8,157 @@
 #include "api_common.h"
 #include "ext_buffer.h"
 
+// Stereo deinterleave/interleave in read_into() and friends
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BUFFER_SIMD_SSE2 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define BUFFER_SIMD_NEON 1
+#endif
+
 // Metatable name for Buffer userdata
 #define BUFFER_MT "Max.Buffer"
 
+// Prefix of the NOBOX listener class. Every external that embeds libapi
+// registers its own class, as a class registered by another external would
+// run that external's notify method on this one's BufferUD.
+#ifndef LUAJIT_API_CLASS_PREFIX
+#define LUAJIT_API_CLASS_PREFIX "luajit"
+#endif
+
 // Buffer userdata structure
 typedef struct {
     t_buffer_ref* buffer_ref;
     bool owns_ref;  // Whether we should free it
+
+    // Held by Buffer:lock() until the matching Buffer:unlock()
+    t_buffer_obj* locked_obj;
+    float* locked_samples;
+    long locked_frames;
+    long locked_chans;
+    int lock_count;     // lock() calls may nest
+    bool lock_dirty;    // some unlock(true) asked for buffer_setdirty
+
+    // Metadata of the bound buffer~, refreshed by its notifications
+    t_object* listener;
+    t_buffer_obj* cache_obj;
+    t_buffer_info info;
+    long version;       // bumped whenever the cache is refreshed (atomic)
 } BufferUD;
 
+// ----------------------------------------------------------------------------
+// Change notifications
+//
+// The buffer reference is owned by a small listener object, so the buffer~
+// notifies it directly whatever owner the script passed. Notifications
+// arrive on the main thread, and only the main thread writes the cached
+// info; its metadata getters read the cache instead of calling
+// buffer_getinfo() per call. Other threads, and anything that touches
+// samples, read the size under the lock instead.
+
+typedef struct {
+    t_object ob;
+    BufferUD* ud;       // NULL once the userdata is collected
+} t_buffer_listener;
+
+static t_class* buffer_listener_class = NULL;
+
+// Main thread only
+static void buffer_cache_refresh(BufferUD* ud) {
+    t_buffer_obj* obj = ud->buffer_ref ? buffer_ref_getobject(ud->buffer_ref) : NULL;
+    ud->cache_obj = obj;
+    if (obj) {
+        buffer_getinfo(obj, &ud->info);
+    } else {
+        memset(&ud->info, 0, sizeof(t_buffer_info));
+    }
+    __atomic_fetch_add(&ud->version, 1, __ATOMIC_RELEASE);
+}
+
+// After the reference changed: the main thread refreshes now, elsewhere the
+// binding notification does
+static void buffer_cache_update(BufferUD* ud) {
+    if (systhread_ismainthread()) {
+        buffer_cache_refresh(ud);
+    }
+}
+
+// Resized, replaced, rebound or written (buffer_setdirty)
+static t_max_err buffer_listener_notify(t_buffer_listener* x, t_symbol* s, t_symbol* msg,
+                                        void* sender, void* data) {
+    BufferUD* ud = x->ud;
+    if (!ud || !ud->buffer_ref) {
+        return MAX_ERR_NONE;
+    }
+    t_max_err err = buffer_ref_notify(ud->buffer_ref, s, msg, sender, data);
+    if (msg == gensym("buffer_modified") || msg == gensym("globalsymbol_binding") ||
+        msg == gensym("globalsymbol_unbinding")) {
+        buffer_cache_refresh(ud);
+    }
+    return err;
+}
+
+static void buffer_listener_init(void) {
+    if (buffer_listener_class) {
+        return;
+    }
+    t_class* c = class_new(LUAJIT_API_CLASS_PREFIX ".buffer.listener", NULL, NULL,
+                           (long)sizeof(t_buffer_listener), 0L, 0);
+    class_addmethod(c, (method)buffer_listener_notify, "notify", A_CANT, 0);
+    class_register(CLASS_NOBOX, c);
+    buffer_listener_class = c;
+}
+
+// The bound buffer~ for sample access, without touching the cache: the audio
+// thread must not rewrite what the main thread's notifications also write
+static inline t_buffer_obj* buffer_current(BufferUD* ud) {
+    return ud->buffer_ref ? buffer_ref_getobject(ud->buffer_ref) : NULL;
+}
+
+// The bound buffer~ and a copy of its info. The main thread answers from the
+// cache, refreshed first if the object changed without a notification
+// reaching us. Other threads (the audio thread running a block or a queued
+// callback) leave the cache alone and read the info under the sample lock,
+// as the sample paths do; a buffer~ that cannot be locked reports no frames.
+static inline t_buffer_obj* buffer_cached(BufferUD* ud, t_buffer_info* info) {
+    t_buffer_obj* obj = buffer_current(ud);
+    if (systhread_ismainthread()) {
+        if (obj != ud->cache_obj) {
+            buffer_cache_refresh(ud);
+        }
+        *info = ud->info;
+        return obj;
+    }
+    memset(info, 0, sizeof(t_buffer_info));
+    if (obj && buffer_locksamples(obj)) {
+        buffer_getinfo(obj, info);
+        buffer_unlocksamples(obj);
+    }
+    return obj;
+}
+
+static inline long buffer_version(BufferUD* ud) {
+    return __atomic_load_n(&ud->version, __ATOMIC_ACQUIRE);
+}
+
+// Lock the samples and read their size under the lock. The cache may lag a
+// resize that has not been notified yet, or be half rewritten by the main
+// thread, so every path that indexes samples sizes them from here.
+static inline float* buffer_lock_sized(t_buffer_obj* obj, long* frames, long* chans) {
+    float* samples = buffer_locksamples(obj);
+    if (samples) {
+        *frames = (long)buffer_getframecount(obj);
+        *chans = (long)buffer_getchannelcount(obj);
+    }
+    return samples;
+}
+
 // Buffer constructor: Buffer(owner_ptr, name)
+// owner_ptr is accepted for compatibility; the reference is owned by the
+// internal listener so that change notifications reach the cache.
 static int Buffer_new(lua_State* L) {
-    t_object* owner = (t_object*)(intptr_t)luaL_checknumber(L, 1);
+    (void)luaL_checknumber(L, 1);
     t_symbol* name = NULL;
 
     if (lua_gettop(L) >= 2 && !lua_isnil(L, 2)) {
@@ -29,8 +168,23 @@ static int Buffer_new(lua_State* L) {
 
     // Create userdata
     BufferUD* ud = (BufferUD*)lua_newuserdata(L, sizeof(BufferUD));
-    ud->buffer_ref = buffer_ref_new(owner, name);
+    t_buffer_listener* listener = (t_buffer_listener*)object_alloc(buffer_listener_class);
+    if (listener) {
+        listener->ud = ud;
+    }
+    ud->listener = (t_object*)listener;
+    ud->buffer_ref = listener ? buffer_ref_new((t_object*)listener, name) : NULL;
     ud->owns_ref = true;
+    ud->locked_obj = NULL;
+    ud->locked_samples = NULL;
+    ud->locked_frames = 0;
+    ud->locked_chans = 0;
+    ud->lock_count = 0;
+    ud->lock_dirty = false;
+    ud->cache_obj = NULL;
+    memset(&ud->info, 0, sizeof(t_buffer_info));
+    ud->version = 0;
+    buffer_cache_update(ud);
 
     // Set metatable
     luaL_getmetatable(L, BUFFER_MT);
@@ -46,10 +200,21 @@ static int Buffer_ref_set(lua_State* L) {
 
     t_symbol* buffer_name = gensym(name);
     buffer_ref_set(ud->buffer_ref, buffer_name);
+    buffer_cache_update(ud);
 
     return 0;
 }
 
+// Buffer:version() - Counter bumped whenever the buffer~ is resized,
+// replaced, rebound or marked dirty; compare it to rebuild derived data
+static int Buffer_version(lua_State* L) {
+    BufferUD* ud = (BufferUD*)luaL_checkudata(L, 1, BUFFER_MT);
+    t_buffer_info info;
+    buffer_cached(ud, &info);
+    lua_pushnumber(L, buffer_version(ud));
+    return 1;
+}
+
 // Buffer:exists() - Check if buffer exists
 static int Buffer_exists(lua_State* L) {
     BufferUD* ud = (BufferUD*)luaL_checkudata(L, 1, BUFFER_MT);
@@ -59,7 +224,7 @@ static int Buffer_exists(lua_State* L) {
         return 1;
     }
 
-    t_buffer_obj* obj = buffer_ref_getobject(ud->buffer_ref);
+    t_buffer_obj* obj = buffer_current(ud);
     lua_pushboolean(L, obj != NULL);
     return 1;
 }
@@ -68,32 +233,35 @@ static int Buffer_exists(lua_State* L) {
 static int Buffer_getinfo(lua_State* L) {
     BufferUD* ud = (BufferUD*)luaL_checkudata(L, 1, BUFFER_MT);
 
-    t_buffer_obj* obj = buffer_ref_getobject(ud->buffer_ref);
+    t_buffer_info cached;
+    t_buffer_obj* obj = buffer_cached(ud, &cached);
     if (!obj) {
         return luaL_error(L, "Buffer reference is not valid");
     }
 
-    t_buffer_info info;
-    buffer_getinfo(obj, &info);
+    const t_buffer_info* info = &cached;
 
     // Create Lua table with buffer info
     lua_newtable(L);
 
-    lua_pushnumber(L, info.b_frames);
+    lua_pushnumber(L, info->b_frames);
     lua_setfield(L, -2, "frames");
 
-    lua_pushnumber(L, info.b_nchans);
+    lua_pushnumber(L, info->b_nchans);
     lua_setfield(L, -2, "channels");
 
-    lua_pushnumber(L, info.b_sr);
+    lua_pushnumber(L, info->b_sr);
     lua_setfield(L, -2, "samplerate");
 
-    lua_pushnumber(L, info.b_modtime);
+    lua_pushnumber(L, info->b_modtime);
     lua_setfield(L, -2, "modtime");
 
-    lua_pushnumber(L, info.b_size);
+    lua_pushnumber(L, info->b_size);
     lua_setfield(L, -2, "size");
 
+    lua_pushnumber(L, buffer_version(ud));
+    lua_setfield(L, -2, "version");
+
     return 1;
 }
 
@@ -101,15 +269,15 @@ static int Buffer_getinfo(lua_State* L) {
 static int Buffer_frames(lua_State* L) {
     BufferUD* ud = (BufferUD*)luaL_checkudata(L, 1, BUFFER_MT);
 
-    t_buffer_obj* obj = buffer_ref_getobject(ud->buffer_ref);
+    t_buffer_info cached;
+    t_buffer_obj* obj = buffer_cached(ud, &cached);
     if (!obj) {
         lua_pushnumber(L, 0);
         return 1;
     }
 
-    t_buffer_info info;
-    buffer_getinfo(obj, &info);
-    lua_pushnumber(L, info.b_frames);
+    const t_buffer_info* info = &cached;
+    lua_pushnumber(L, info->b_frames);
     return 1;
 }
 
@@ -117,15 +285,15 @@ static int Buffer_frames(lua_State* L) {
 static int Buffer_channels(lua_State* L) {
     BufferUD* ud = (BufferUD*)luaL_checkudata(L, 1, BUFFER_MT);
 
-    t_buffer_obj* obj = buffer_ref_getobject(ud->buffer_ref);
+    t_buffer_info cached;
+    t_buffer_obj* obj = buffer_cached(ud, &cached);
     if (!obj) {
         lua_pushnumber(L, 0);
         return 1;
     }
 
-    t_buffer_info info;
-    buffer_getinfo(obj, &info);
-    lua_pushnumber(L, info.b_nchans);
+    const t_buffer_info* info = &cached;
+    lua_pushnumber(L, info->b_nchans);
     return 1;
 }
 
@@ -133,15 +301,15 @@ static int Buffer_channels(lua_State* L) {
 static int Buffer_samplerate(lua_State* L) {
     BufferUD* ud = (BufferUD*)luaL_checkudata(L, 1, BUFFER_MT);
 
-    t_buffer_obj* obj = buffer_ref_getobject(ud->buffer_ref);
+    t_buffer_info cached;
+    t_buffer_obj* obj = buffer_cached(ud, &cached);
     if (!obj) {
         lua_pushnumber(L, 0);
         return 1;
     }
 
-    t_buffer_info info;
-    buffer_getinfo(obj, &info);
-    lua_pushnumber(L, info.b_sr);
+    const t_buffer_info* info = &cached;
+    lua_pushnumber(L, info->b_sr);
     return 1;
 }
 
@@ -151,30 +319,40 @@ static int Buffer_peek(lua_State* L) {
     long frame = (long)luaL_checknumber(L, 2);
     long channel = (long)luaL_checknumber(L, 3);
 
-    t_buffer_obj* obj = buffer_ref_getobject(ud->buffer_ref);
-    if (!obj) {
-        return luaL_error(L, "Buffer reference is not valid");
+    // Inside lock()/unlock() the samples are already held
+    if (ud->lock_count > 0) {
+        if (frame < 0 || frame >= ud->locked_frames) {
+            return luaL_error(L, "Frame index %d out of range [0, %d)", (int)frame, (int)ud->locked_frames);
+        }
+        if (channel < 0 || channel >= ud->locked_chans) {
+            return luaL_error(L, "Channel index %d out of range [0, %d)", (int)channel, (int)ud->locked_chans);
+        }
+        lua_pushnumber(L, ud->locked_samples[frame * ud->locked_chans + channel]);
+        return 1;
     }
 
-    t_buffer_info info;
-    buffer_getinfo(obj, &info);
-
-    // Validate indices (0-based)
-    if (frame < 0 || frame >= info.b_frames) {
-        return luaL_error(L, "Frame index %d out of range [0, %d)", (int)frame, (int)info.b_frames);
-    }
-    if (channel < 0 || channel >= info.b_nchans) {
-        return luaL_error(L, "Channel index %d out of range [0, %d)", (int)channel, (int)info.b_nchans);
+    t_buffer_obj* obj = buffer_current(ud);
+    if (!obj) {
+        return luaL_error(L, "Buffer reference is not valid");
     }
 
-    // Lock and read
-    float* samples = buffer_locksamples(obj);
+    // Lock, then validate indices (0-based) against the locked size
+    long frames, chans;
+    float* samples = buffer_lock_sized(obj, &frames, &chans);
     if (!samples) {
         return luaL_error(L, "Failed to lock buffer samples");
     }
+    if (frame < 0 || frame >= frames) {
+        buffer_unlocksamples(obj);
+        return luaL_error(L, "Frame index %d out of range [0, %d)", (int)frame, (int)frames);
+    }
+    if (channel < 0 || channel >= chans) {
+        buffer_unlocksamples(obj);
+        return luaL_error(L, "Channel index %d out of range [0, %d)", (int)channel, (int)chans);
+    }
 
     // Calculate index (samples are interleaved: frame * nchans + channel)
-    long index = frame * info.b_nchans + channel;
+    long index = frame * chans + channel;
     float value = samples[index];
 
     buffer_unlocksamples(obj);
@@ -190,30 +368,41 @@ static int Buffer_poke(lua_State* L) {
     long channel = (long)luaL_checknumber(L, 3);
     float value = (float)luaL_checknumber(L, 4);
 
-    t_buffer_obj* obj = buffer_ref_getobject(ud->buffer_ref);
-    if (!obj) {
-        return luaL_error(L, "Buffer reference is not valid");
+    // Inside lock()/unlock(): write through the held pointer, dirty on unlock
+    if (ud->lock_count > 0) {
+        if (frame < 0 || frame >= ud->locked_frames) {
+            return luaL_error(L, "Frame index %d out of range [0, %d)", (int)frame, (int)ud->locked_frames);
+        }
+        if (channel < 0 || channel >= ud->locked_chans) {
+            return luaL_error(L, "Channel index %d out of range [0, %d)", (int)channel, (int)ud->locked_chans);
+        }
+        ud->locked_samples[frame * ud->locked_chans + channel] = value;
+        ud->lock_dirty = true;
+        return 0;
     }
 
-    t_buffer_info info;
-    buffer_getinfo(obj, &info);
-
-    // Validate indices (0-based)
-    if (frame < 0 || frame >= info.b_frames) {
-        return luaL_error(L, "Frame index %d out of range [0, %d)", (int)frame, (int)info.b_frames);
-    }
-    if (channel < 0 || channel >= info.b_nchans) {
-        return luaL_error(L, "Channel index %d out of range [0, %d)", (int)channel, (int)info.b_nchans);
+    t_buffer_obj* obj = buffer_current(ud);
+    if (!obj) {
+        return luaL_error(L, "Buffer reference is not valid");
     }
 
-    // Lock and write
-    float* samples = buffer_locksamples(obj);
+    // Lock, then validate indices (0-based) against the locked size
+    long frames, chans;
+    float* samples = buffer_lock_sized(obj, &frames, &chans);
     if (!samples) {
         return luaL_error(L, "Failed to lock buffer samples");
     }
+    if (frame < 0 || frame >= frames) {
+        buffer_unlocksamples(obj);
+        return luaL_error(L, "Frame index %d out of range [0, %d)", (int)frame, (int)frames);
+    }
+    if (channel < 0 || channel >= chans) {
+        buffer_unlocksamples(obj);
+        return luaL_error(L, "Channel index %d out of range [0, %d)", (int)channel, (int)chans);
+    }
 
     // Calculate index (samples are interleaved)
-    long index = frame * info.b_nchans + channel;
+    long index = frame * chans + channel;
     samples[index] = value;
 
     buffer_unlocksamples(obj);
@@ -222,6 +411,632 @@ static int Buffer_poke(lua_State* L) {
     return 0;
 }
 
+// Buffer:lock_raw() - Lock the samples until Buffer:unlock()
+// Returns the interleaved float* as lightuserdata, frames and channels.
+// Buffer:lock() wraps this in an FFI view.
+static int Buffer_lock_raw(lua_State* L) {
+    BufferUD* ud = (BufferUD*)luaL_checkudata(L, 1, BUFFER_MT);
+
+    if (ud->lock_count == 0) {
+        t_buffer_obj* obj = buffer_current(ud);
+        if (!obj) {
+            return luaL_error(L, "Buffer reference is not valid");
+        }
+
+        // Size is read after locking so it cannot change underneath us
+        long frames, chans;
+        float* samples = buffer_lock_sized(obj, &frames, &chans);
+        if (!samples) {
+            return luaL_error(L, "Failed to lock buffer samples");
+        }
+
+        ud->locked_obj = obj;
+        ud->locked_samples = samples;
+        ud->locked_frames = frames;
+        ud->locked_chans = chans;
+        ud->lock_dirty = false;
+    }
+    ud->lock_count++;
+
+    lua_pushlightuserdata(L, ud->locked_samples);
+    lua_pushnumber(L, ud->locked_frames);
+    lua_pushnumber(L, ud->locked_chans);
+    return 3;
+}
+
+static void buffer_release_lock(BufferUD* ud) {
+    buffer_unlocksamples(ud->locked_obj);
+    if (ud->lock_dirty) {
+        buffer_setdirty(ud->locked_obj);
+    }
+    ud->locked_obj = NULL;
+    ud->locked_samples = NULL;
+    ud->locked_frames = 0;
+    ud->locked_chans = 0;
+    ud->lock_count = 0;
+    ud->lock_dirty = false;
+}
+
+// Buffer:unlock(dirty) - Release one lock() (pass true after writing samples)
+static int Buffer_unlock(lua_State* L) {
+    BufferUD* ud = (BufferUD*)luaL_checkudata(L, 1, BUFFER_MT);
+
+    if (ud->lock_count == 0) {
+        return luaL_error(L, "Buffer is not locked");
+    }
+    if (lua_toboolean(L, 2)) {
+        ud->lock_dirty = true;
+    }
+    if (--ud->lock_count == 0) {
+        buffer_release_lock(ud);
+    }
+    return 0;
+}
+
+// Buffer:is_locked() - Whether a lock() is outstanding
+static int Buffer_is_locked(lua_State* L) {
+    BufferUD* ud = (BufferUD*)luaL_checkudata(L, 1, BUFFER_MT);
+    lua_pushboolean(L, ud->lock_count > 0);
+    return 1;
+}
+
+// ----------------------------------------------------------------------------
+// Interpolated reads
+//
+// Positions are fractional frame indices. With loop "off" the position and
+// the interpolation taps are clamped to the buffer, with "loop" both wrap
+// around it, and "pingpong" reflects the position at either end.
+
+typedef enum {
+    BUFFER_INTERP_LINEAR = 0,
+    BUFFER_INTERP_CUBIC,    // 4-point Hermite
+    BUFFER_INTERP_SINC      // 8-point Blackman-windowed sinc
+} buffer_interp;
+
+typedef enum {
+    BUFFER_LOOP_OFF = 0,
+    BUFFER_LOOP_WRAP,
+    BUFFER_LOOP_PINGPONG
+} buffer_loop;
+
+static const char* const buffer_interp_names[] = { "linear", "cubic", "sinc", NULL };
+static const char* const buffer_loop_names[] = { "off", "loop", "pingpong", NULL };
+
+// Sinc taps sit at offsets -3 .. +4 from the integer position. The kernel is
+// tabulated for BUFFER_SINC_PHASES fractions (plus one guard row) and
+// interpolated linearly between rows.
+#define BUFFER_SINC_TAPS 8
+#define BUFFER_SINC_PHASES 256
+
+static double buffer_sinc_table[(BUFFER_SINC_PHASES + 1) * BUFFER_SINC_TAPS];
+static bool buffer_sinc_ready = false;
+
+// Called from register_buffer_type(), i.e. before any audio thread reads
+static void buffer_sinc_init(void) {
+    if (buffer_sinc_ready) {
+        return;
+    }
+    for (int p = 0; p <= BUFFER_SINC_PHASES; p++) {
+        double frac = (double)p / BUFFER_SINC_PHASES;
+        double* row = buffer_sinc_table + p * BUFFER_SINC_TAPS;
+        double sum = 0.0;
+        for (int k = 0; k < BUFFER_SINC_TAPS; k++) {
+            double x = (double)(k - (BUFFER_SINC_TAPS / 2 - 1)) - frac;
+            double sinc = x == 0.0 ? 1.0 : sin(M_PI * x) / (M_PI * x);
+            double t = (x + BUFFER_SINC_TAPS / 2) / BUFFER_SINC_TAPS;
+            double w = 0.42 - 0.5 * cos(2.0 * M_PI * t) + 0.08 * cos(4.0 * M_PI * t);
+            row[k] = sinc * w;
+            sum += row[k];
+        }
+        // Unity gain at DC for every fraction
+        for (int k = 0; k < BUFFER_SINC_TAPS; k++) {
+            row[k] /= sum;
+        }
+    }
+    buffer_sinc_ready = true;
+}
+
+// One channel of locked buffer~ memory
+typedef struct {
+    const float* samples;
+    long frames;
+    long chans;
+    long channel;
+    int loop;
+    bool owns_lock;     // locked for this call only
+    t_buffer_obj* obj;
+} BufferReader;
+
+// Use the held lock or lock for the duration of the call
+// Returns an error message, or NULL on success
+static const char* buffer_reader_begin(BufferUD* ud, long channel, int loop, BufferReader* r) {
+    r->loop = loop;
+    r->channel = channel;
+    if (ud->lock_count > 0) {
+        r->samples = ud->locked_samples;
+        r->frames = ud->locked_frames;
+        r->chans = ud->locked_chans;
+        r->owns_lock = false;
+        r->obj = NULL;
+    } else {
+        t_buffer_obj* obj = buffer_current(ud);
+        if (!obj) {
+            return "Buffer reference is not valid";
+        }
+        float* samples = buffer_lock_sized(obj, &r->frames, &r->chans);
+        if (!samples) {
+            return "Failed to lock buffer samples";
+        }
+        r->samples = samples;
+        r->owns_lock = true;
+        r->obj = obj;
+    }
+    if (channel < 0 || channel >= r->chans || r->frames <= 0) {
+        if (r->owns_lock) {
+            buffer_unlocksamples(r->obj);
+        }
+        return r->frames <= 0 ? "Buffer is empty" : "Channel index out of range";
+    }
+    return NULL;
+}
+
+static void buffer_reader_end(BufferReader* r) {
+    if (r->owns_lock) {
+        buffer_unlocksamples(r->obj);
+    }
+}
+
+static inline double buffer_reader_tap(const BufferReader* r, long i) {
+    if (i < 0 || i >= r->frames) {
+        if (r->loop == BUFFER_LOOP_WRAP) {
+            i %= r->frames;
+            if (i < 0) {
+                i += r->frames;
+            }
+        } else {
+            i = i < 0 ? 0 : r->frames - 1;
+        }
+    }
+    return r->samples[i * r->chans + r->channel];
+}
+
+// Map any position into the buffer according to the loop mode
+static inline double buffer_reader_position(const BufferReader* r, double pos) {
+    double last = (double)(r->frames - 1);
+    switch (r->loop) {
+        case BUFFER_LOOP_WRAP: {
+            double len = (double)r->frames;
+            if (pos < 0.0 || pos >= len) {
+                pos = fmod(pos, len);
+                if (pos < 0.0) {
+                    pos += len;
+                }
+            }
+            return pos;
+        }
+        case BUFFER_LOOP_PINGPONG: {
+            double period = 2.0 * last;
+            if (period <= 0.0) {
+                return 0.0;
+            }
+            if (pos < 0.0 || pos > last) {
+                pos = fmod(pos, period);
+                if (pos < 0.0) {
+                    pos += period;
+                }
+                if (pos > last) {
+                    pos = period - pos;
+                }
+            }
+            return pos;
+        }
+        default:
+            return pos < 0.0 ? 0.0 : (pos > last ? last : pos);
+    }
+}
+
+static inline double buffer_reader_read(const BufferReader* r, double pos, int interp) {
+    pos = buffer_reader_position(r, pos);
+    long i = (long)pos;
+    double f = pos - (double)i;
+
+    // Every tap inside the buffer: index the channel directly
+    const float* s = r->samples + r->channel;
+    long stride = r->chans;
+    bool inside = i >= BUFFER_SINC_TAPS / 2 - 1 && i + BUFFER_SINC_TAPS / 2 < r->frames;
+
+    switch (interp) {
+        case BUFFER_INTERP_CUBIC: {
+            double sm1, s0, s1, s2;
+            if (inside) {
+                const float* p = s + i * stride;
+                sm1 = p[-stride];
+                s0 = p[0];
+                s1 = p[stride];
+                s2 = p[2 * stride];
+            } else {
+                sm1 = buffer_reader_tap(r, i - 1);
+                s0 = buffer_reader_tap(r, i);
+                s1 = buffer_reader_tap(r, i + 1);
+                s2 = buffer_reader_tap(r, i + 2);
+            }
+            double c1 = 0.5 * (s1 - sm1);
+            double c2 = sm1 - 2.5 * s0 + 2.0 * s1 - 0.5 * s2;
+            double c3 = 0.5 * (s2 - sm1) + 1.5 * (s0 - s1);
+            return ((c3 * f + c2) * f + c1) * f + s0;
+        }
+        case BUFFER_INTERP_SINC: {
+            double phase = f * BUFFER_SINC_PHASES;
+            int row = (int)phase;
+            double pf = phase - (double)row;
+            const double* k0 = buffer_sinc_table + row * BUFFER_SINC_TAPS;
+            const double* k1 = k0 + BUFFER_SINC_TAPS;
+            long first = i - (BUFFER_SINC_TAPS / 2 - 1);
+            double y = 0.0;
+            if (inside) {
+                const float* p = s + first * stride;
+                for (int k = 0; k < BUFFER_SINC_TAPS; k++) {
+                    y += p[k * stride] * (k0[k] + (k1[k] - k0[k]) * pf);
+                }
+            } else {
+                for (int k = 0; k < BUFFER_SINC_TAPS; k++) {
+                    y += buffer_reader_tap(r, first + k) * (k0[k] + (k1[k] - k0[k]) * pf);
+                }
+            }
+            return y;
+        }
+        default: {
+            double s0, s1;
+            if (inside) {
+                s0 = s[i * stride];
+                s1 = s[(i + 1) * stride];
+            } else {
+                s0 = buffer_reader_tap(r, i);
+                s1 = buffer_reader_tap(r, i + 1);
+            }
+            return s0 + (s1 - s0) * f;
+        }
+    }
+}
+
+// Buffer:read(pos, channel, interp, loop) - One interpolated sample
+// pos: fractional frame; channel: 0-indexed (default 0)
+// interp: "linear" (default), "cubic" or "sinc"; loop: "off" (default), "loop", "pingpong"
+// Inside lock()/unlock() this reuses the held lock.
+static int Buffer_read(lua_State* L) {
+    BufferUD* ud = (BufferUD*)luaL_checkudata(L, 1, BUFFER_MT);
+    double pos = luaL_checknumber(L, 2);
+    long channel = (long)luaL_optnumber(L, 3, 0);
+    int interp = luaL_checkoption(L, 4, "linear", buffer_interp_names);
+    int loop = luaL_checkoption(L, 5, "off", buffer_loop_names);
+
+    BufferReader r;
+    const char* err = buffer_reader_begin(ud, channel, loop, &r);
+    if (err) {
+        return luaL_error(L, "%s", err);
+    }
+    double y = buffer_reader_read(&r, pos, interp);
+    buffer_reader_end(&r);
+
+    lua_pushnumber(L, y);
+    return 1;
+}
+
+// Addresses of FFI double arrays arrive as numbers, like Buffer_new's owner
+static inline double* buffer_checkaddress(lua_State* L, int idx) {
+    double* p = (double*)(intptr_t)luaL_checknumber(L, idx);
+    if (!p) {
+        luaL_argerror(L, idx, "NULL pointer");
+    }
+    return p;
+}
+
+// Buffer:read_block_raw(out, pos, n, channel, interp, loop)
+// out[i] = read(pos[i]) for FFI arrays passed as addresses; see read_block()
+static int Buffer_read_block_raw(lua_State* L) {
+    BufferUD* ud = (BufferUD*)luaL_checkudata(L, 1, BUFFER_MT);
+    double* out = buffer_checkaddress(L, 2);
+    const double* pos = buffer_checkaddress(L, 3);
+    long n = (long)luaL_checknumber(L, 4);
+    long channel = (long)luaL_optnumber(L, 5, 0);
+    int interp = luaL_checkoption(L, 6, "linear", buffer_interp_names);
+    int loop = luaL_checkoption(L, 7, "off", buffer_loop_names);
+
+    BufferReader r;
+    const char* err = buffer_reader_begin(ud, channel, loop, &r);
+    if (err) {
+        return luaL_error(L, "%s", err);
+    }
+    for (long i = 0; i < n; i++) {
+        out[i] = buffer_reader_read(&r, pos[i], interp);
+    }
+    buffer_reader_end(&r);
+    return 0;
+}
+
+// Buffer:phasor_block_raw(out, phase, n, channel, interp)
+// wave~-style: phase 0..1 spans the whole buffer and wraps
+static int Buffer_phasor_block_raw(lua_State* L) {
+    BufferUD* ud = (BufferUD*)luaL_checkudata(L, 1, BUFFER_MT);
+    double* out = buffer_checkaddress(L, 2);
+    const double* phase = buffer_checkaddress(L, 3);
+    long n = (long)luaL_checknumber(L, 4);
+    long channel = (long)luaL_optnumber(L, 5, 0);
+    int interp = luaL_checkoption(L, 6, "linear", buffer_interp_names);
+
+    BufferReader r;
+    const char* err = buffer_reader_begin(ud, channel, BUFFER_LOOP_WRAP, &r);
+    if (err) {
+        return luaL_error(L, "%s", err);
+    }
+    double len = (double)r.frames;
+    for (long i = 0; i < n; i++) {
+        out[i] = buffer_reader_read(&r, phase[i] * len, interp);
+    }
+    buffer_reader_end(&r);
+    return 0;
+}
+
+// Buffer:play_block_raw(out, n, pos, rate, rate_addr, channel, interp, loop)
+// Plays from pos advancing by rate frames per sample, or by rate_addr[i] when
+// rate_addr is not 0. Returns the next position, kept inside the loop.
+static int Buffer_play_block_raw(lua_State* L) {
+    BufferUD* ud = (BufferUD*)luaL_checkudata(L, 1, BUFFER_MT);
+    double* out = buffer_checkaddress(L, 2);
+    long n = (long)luaL_checknumber(L, 3);
+    double pos = luaL_checknumber(L, 4);
+    double rate = luaL_optnumber(L, 5, 1.0);
+    const double* rates = (const double*)(intptr_t)luaL_optnumber(L, 6, 0);
+    long channel = (long)luaL_optnumber(L, 7, 0);
+    int interp = luaL_checkoption(L, 8, "linear", buffer_interp_names);
+    int loop = luaL_checkoption(L, 9, "off", buffer_loop_names);
+
+    BufferReader r;
+    const char* err = buffer_reader_begin(ud, channel, loop, &r);
+    if (err) {
+        return luaL_error(L, "%s", err);
+    }
+    if (rates) {
+        for (long i = 0; i < n; i++) {
+            out[i] = buffer_reader_read(&r, pos, interp);
+            pos += rates[i];
+        }
+    } else {
+        for (long i = 0; i < n; i++) {
+            out[i] = buffer_reader_read(&r, pos, interp);
+            pos += rate;
+        }
+    }
+    // Fold back so the position never loses precision; one-shot playback
+    // keeps running past the end (and reads the last frame)
+    if (loop != BUFFER_LOOP_OFF) {
+        pos = buffer_reader_position(&r, pos);
+    }
+    buffer_reader_end(&r);
+
+    lua_pushnumber(L, pos);
+    return 1;
+}
+
+// ----------------------------------------------------------------------------
+// Bulk transfer between buffer~ floats and FFI double arrays
+//
+// One call per block, no Lua tables. Stereo buffers are split and merged
+// four frames at a time with SSE2 or NEON shuffles; other layouts use plain
+// strided loops (the mono case is a straight conversion the compiler
+// vectorises).
+
+// Gather one channel (every stride-th float) into doubles
+static inline void buffer_gather(double* dst, const float* src, long stride, long n) {
+    if (stride == 1) {
+        for (long i = 0; i < n; i++) {
+            dst[i] = src[i];
+        }
+    } else {
+        for (long i = 0; i < n; i++) {
+            dst[i] = src[i * stride];
+        }
+    }
+}
+
+// Scatter doubles into one channel
+static inline void buffer_scatter(float* dst, const double* src, long stride, long n) {
+    if (stride == 1) {
+        for (long i = 0; i < n; i++) {
+            dst[i] = (float)src[i];
+        }
+    } else {
+        for (long i = 0; i < n; i++) {
+            dst[i * stride] = (float)src[i];
+        }
+    }
+}
+
+// L R L R ... -> L L ..., R R ...
+static inline void buffer_deinterleave2(double* left, double* right, const float* src, long n) {
+    long i = 0;
+#if defined(BUFFER_SIMD_SSE2)
+    for (; i + 4 <= n; i += 4) {
+        __m128 a = _mm_loadu_ps(src + 2 * i);       // L0 R0 L1 R1
+        __m128 b = _mm_loadu_ps(src + 2 * i + 4);   // L2 R2 L3 R3
+        __m128 l = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 r = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm_storeu_pd(left + i, _mm_cvtps_pd(l));
+        _mm_storeu_pd(left + i + 2, _mm_cvtps_pd(_mm_movehl_ps(l, l)));
+        _mm_storeu_pd(right + i, _mm_cvtps_pd(r));
+        _mm_storeu_pd(right + i + 2, _mm_cvtps_pd(_mm_movehl_ps(r, r)));
+    }
+#elif defined(BUFFER_SIMD_NEON)
+    for (; i + 4 <= n; i += 4) {
+        float32x4x2_t v = vld2q_f32(src + 2 * i);
+        vst1q_f64(left + i, vcvt_f64_f32(vget_low_f32(v.val[0])));
+        vst1q_f64(left + i + 2, vcvt_high_f64_f32(v.val[0]));
+        vst1q_f64(right + i, vcvt_f64_f32(vget_low_f32(v.val[1])));
+        vst1q_f64(right + i + 2, vcvt_high_f64_f32(v.val[1]));
+    }
+#endif
+    for (; i < n; i++) {
+        left[i] = src[2 * i];
+        right[i] = src[2 * i + 1];
+    }
+}
+
+// L L ..., R R ... -> L R L R ...
+static inline void buffer_interleave2(float* dst, const double* left, const double* right, long n) {
+    long i = 0;
+#if defined(BUFFER_SIMD_SSE2)
+    for (; i + 4 <= n; i += 4) {
+        __m128 l = _mm_movelh_ps(_mm_cvtpd_ps(_mm_loadu_pd(left + i)),
+                                 _mm_cvtpd_ps(_mm_loadu_pd(left + i + 2)));
+        __m128 r = _mm_movelh_ps(_mm_cvtpd_ps(_mm_loadu_pd(right + i)),
+                                 _mm_cvtpd_ps(_mm_loadu_pd(right + i + 2)));
+        _mm_storeu_ps(dst + 2 * i, _mm_unpacklo_ps(l, r));
+        _mm_storeu_ps(dst + 2 * i + 4, _mm_unpackhi_ps(l, r));
+    }
+#elif defined(BUFFER_SIMD_NEON)
+    for (; i + 4 <= n; i += 4) {
+        float32x4x2_t v;
+        v.val[0] = vcvt_high_f32_f64(vcvt_f32_f64(vld1q_f64(left + i)), vld1q_f64(left + i + 2));
+        v.val[1] = vcvt_high_f32_f64(vcvt_f32_f64(vld1q_f64(right + i)), vld1q_f64(right + i + 2));
+        vst2q_f32(dst + 2 * i, v);
+    }
+#endif
+    for (; i < n; i++) {
+        dst[2 * i] = (float)left[i];
+        dst[2 * i + 1] = (float)right[i];
+    }
+}
+
+// Frames of [start, start + n) inside the buffer; 0 when start is outside it
+static inline long buffer_span(const BufferReader* r, long start, long n) {
+    if (start < 0 || start >= r->frames || n <= 0) {
+        return 0;
+    }
+    return n < r->frames - start ? n : r->frames - start;
+}
+
+// Written through a held lock: dirty on unlock, otherwise now
+static void buffer_written(BufferUD* ud, BufferReader* r) {
+    if (r->owns_lock) {
+        buffer_setdirty(r->obj);
+    } else {
+        ud->lock_dirty = true;
+    }
+}
+
+// Buffer:read_into_raw(dst, channel, start, n) - see read_into()
+static int Buffer_read_into_raw(lua_State* L) {
+    BufferUD* ud = (BufferUD*)luaL_checkudata(L, 1, BUFFER_MT);
+    double* dst = buffer_checkaddress(L, 2);
+    long channel = (long)luaL_optnumber(L, 3, 0);
+    long start = (long)luaL_optnumber(L, 4, 0);
+    long n = (long)luaL_checknumber(L, 5);
+
+    BufferReader r;
+    const char* err = buffer_reader_begin(ud, channel, BUFFER_LOOP_OFF, &r);
+    if (err) {
+        return luaL_error(L, "%s", err);
+    }
+    long count = buffer_span(&r, start, n);
+    if (count > 0) {
+        buffer_gather(dst, r.samples + start * r.chans + channel, r.chans, count);
+    }
+    buffer_reader_end(&r);
+
+    lua_pushnumber(L, count);
+    return 1;
+}
+
+// Buffer:write_from_raw(src, channel, start, n) - see write_from()
+static int Buffer_write_from_raw(lua_State* L) {
+    BufferUD* ud = (BufferUD*)luaL_checkudata(L, 1, BUFFER_MT);
+    const double* src = buffer_checkaddress(L, 2);
+    long channel = (long)luaL_optnumber(L, 3, 0);
+    long start = (long)luaL_optnumber(L, 4, 0);
+    long n = (long)luaL_checknumber(L, 5);
+
+    BufferReader r;
+    const char* err = buffer_reader_begin(ud, channel, BUFFER_LOOP_OFF, &r);
+    if (err) {
+        return luaL_error(L, "%s", err);
+    }
+    long count = buffer_span(&r, start, n);
+    if (count > 0) {
+        buffer_scatter((float*)r.samples + start * r.chans + channel, src, r.chans, count);
+        buffer_written(ud, &r);
+    }
+    buffer_reader_end(&r);
+
+    lua_pushnumber(L, count);
+    return 1;
+}
+
+// Buffer:deinterleave_raw(start, n, dst1, dst2, ...) / interleave_raw(start, n, src1, ...)
+// One array per channel from channel 0 up; see deinterleave_into()
+static int buffer_transfer_all(lua_State* L, bool write) {
+    BufferUD* ud = (BufferUD*)luaL_checkudata(L, 1, BUFFER_MT);
+    long start = (long)luaL_checknumber(L, 2);
+    long n = (long)luaL_checknumber(L, 3);
+    int arrays = lua_gettop(L) - 3;
+    if (arrays < 1) {
+        return luaL_error(L, "expected at least one array");
+    }
+    for (int c = 0; c < arrays; c++) {
+        buffer_checkaddress(L, 4 + c);
+    }
+
+    BufferReader r;
+    const char* err = buffer_reader_begin(ud, 0, BUFFER_LOOP_OFF, &r);
+    if (err) {
+        return luaL_error(L, "%s", err);
+    }
+    if (arrays > r.chans) {
+        buffer_reader_end(&r);
+        return luaL_error(L, "%d arrays for a %d channel buffer", arrays, (int)r.chans);
+    }
+    long count = buffer_span(&r, start, n);
+    if (count == 0) {
+        buffer_reader_end(&r);
+        lua_pushnumber(L, 0);
+        return 1;
+    }
+    float* frames = (float*)r.samples + start * r.chans;
+
+    if (r.chans == 2 && arrays == 2) {
+        double* a = (double*)(intptr_t)lua_tonumber(L, 4);
+        double* b = (double*)(intptr_t)lua_tonumber(L, 5);
+        if (write) {
+            buffer_interleave2(frames, a, b, count);
+        } else {
+            buffer_deinterleave2(a, b, frames, count);
+        }
+    } else {
+        for (int c = 0; c < arrays; c++) {
+            double* p = (double*)(intptr_t)lua_tonumber(L, 4 + c);
+            if (write) {
+                buffer_scatter(frames + c, p, r.chans, count);
+            } else {
+                buffer_gather(p, frames + c, r.chans, count);
+            }
+        }
+    }
+    if (write) {
+        buffer_written(ud, &r);
+    }
+    buffer_reader_end(&r);
+
+    lua_pushnumber(L, count);
+    return 1;
+}
+
+static int Buffer_deinterleave_raw(lua_State* L) {
+    return buffer_transfer_all(L, false);
+}
+
+static int Buffer_interleave_raw(lua_State* L) {
+    return buffer_transfer_all(L, true);
+}
+
 // Buffer:to_list(channel, start_frame, num_frames) - Export channel to Lua table
 static int Buffer_to_list(lua_State* L) {
     BufferUD* ud = (BufferUD*)luaL_checkudata(L, 1, BUFFER_MT);
@@ -239,36 +1054,35 @@ static int Buffer_to_list(lua_State* L) {
         num_frames = (long)luaL_checknumber(L, 4);
     }
 
-    t_buffer_obj* obj = buffer_ref_getobject(ud->buffer_ref);
+    t_buffer_obj* obj = buffer_current(ud);
     if (!obj) {
         return luaL_error(L, "Buffer reference is not valid");
     }
 
-    t_buffer_info info;
-    buffer_getinfo(obj, &info);
+    // Lock samples; the range is validated against the locked size
+    long frames, chans;
+    float* samples = buffer_lock_sized(obj, &frames, &chans);
+    if (!samples) {
+        return luaL_error(L, "Failed to lock buffer samples");
+    }
 
     // Validate channel
-    if (channel < 0 || channel >= info.b_nchans) {
+    if (channel < 0 || channel >= chans) {
+        buffer_unlocksamples(obj);
         return luaL_error(L, "Channel index out of range");
     }
 
     // Validate start_frame
+    if (start_frame >= frames) {
+        start_frame = frames - 1;
+    }
     if (start_frame < 0) {
         start_frame = 0;
     }
-    if (start_frame >= info.b_frames) {
-        start_frame = info.b_frames - 1;
-    }
 
     // Determine num_frames
-    if (num_frames < 0 || (start_frame + num_frames) > info.b_frames) {
-        num_frames = info.b_frames - start_frame;
-    }
-
-    // Lock samples
-    float* samples = buffer_locksamples(obj);
-    if (!samples) {
-        return luaL_error(L, "Failed to lock buffer samples");
+    if (num_frames < 0 || (start_frame + num_frames) > frames) {
+        num_frames = frames - start_frame;
     }
 
     // Create Lua table
@@ -276,7 +1090,7 @@ static int Buffer_to_list(lua_State* L) {
 
     for (long i = 0; i < num_frames; i++) {
         long frame = start_frame + i;
-        long index = frame * info.b_nchans + channel;
+        long index = frame * chans + channel;
         lua_pushnumber(L, samples[index]);
         lua_rawseti(L, -2, i + 1);  // Lua 1-indexed
     }
@@ -297,32 +1111,34 @@ static int Buffer_from_list(lua_State* L) {
         start_frame = (long)luaL_checknumber(L, 4);
     }
 
-    t_buffer_obj* obj = buffer_ref_getobject(ud->buffer_ref);
+    t_buffer_obj* obj = buffer_current(ud);
     if (!obj) {
         return luaL_error(L, "Buffer reference is not valid");
     }
 
-    t_buffer_info info;
-    buffer_getinfo(obj, &info);
+    // Get table length
+    long table_len = (long)lua_objlen(L, 3);
+
+    // Lock samples; the range is validated against the locked size
+    long frames, chans;
+    float* samples = buffer_lock_sized(obj, &frames, &chans);
+    if (!samples) {
+        return luaL_error(L, "Failed to lock buffer samples");
+    }
 
     // Validate channel
-    if (channel < 0 || channel >= info.b_nchans) {
+    if (channel < 0 || channel >= chans) {
+        buffer_unlocksamples(obj);
         return luaL_error(L, "Channel index out of range");
     }
 
-    // Get table length
-    long table_len = (long)lua_objlen(L, 3);
-
     // Determine how many frames to write
-    long num_frames = table_len;
-    if (start_frame + num_frames > info.b_frames) {
-        num_frames = info.b_frames - start_frame;
+    if (start_frame < 0) {
+        start_frame = 0;
     }
-
-    // Lock samples
-    float* samples = buffer_locksamples(obj);
-    if (!samples) {
-        return luaL_error(L, "Failed to lock buffer samples");
+    long num_frames = table_len;
+    if (start_frame + num_frames > frames) {
+        num_frames = frames - start_frame;
     }
 
     // Write samples from table
@@ -332,7 +1148,7 @@ static int Buffer_from_list(lua_State* L) {
         lua_pop(L, 1);
 
         long frame = start_frame + i;
-        long index = frame * info.b_nchans + channel;
+        long index = frame * chans + channel;
         samples[index] = value;
     }
 
@@ -346,21 +1162,19 @@ static int Buffer_from_list(lua_State* L) {
 static int Buffer_clear(lua_State* L) {
     BufferUD* ud = (BufferUD*)luaL_checkudata(L, 1, BUFFER_MT);
 
-    t_buffer_obj* obj = buffer_ref_getobject(ud->buffer_ref);
+    t_buffer_obj* obj = buffer_current(ud);
     if (!obj) {
         return luaL_error(L, "Buffer reference is not valid");
     }
 
-    t_buffer_info info;
-    buffer_getinfo(obj, &info);
-
-    float* samples = buffer_locksamples(obj);
+    long frames, chans;
+    float* samples = buffer_lock_sized(obj, &frames, &chans);
     if (!samples) {
         return luaL_error(L, "Failed to lock buffer samples");
     }
 
     // Clear all samples
-    long total_samples = info.b_frames * info.b_nchans;
+    long total_samples = frames * chans;
     for (long i = 0; i < total_samples; i++) {
         samples[i] = 0.0f;
     }
@@ -381,10 +1195,20 @@ static int Buffer_pointer(lua_State* L) {
 // __gc metamethod (destructor)
 static int Buffer_gc(lua_State* L) {
     BufferUD* ud = (BufferUD*)luaL_checkudata(L, 1, BUFFER_MT);
+    if (ud->lock_count > 0) {
+        buffer_release_lock(ud);
+    }
+    if (ud->listener) {
+        ((t_buffer_listener*)ud->listener)->ud = NULL;
+    }
     if (ud->owns_ref && ud->buffer_ref) {
         object_free(ud->buffer_ref);
         ud->buffer_ref = NULL;
     }
+    if (ud->listener) {
+        object_free(ud->listener);
+        ud->listener = NULL;
+    }
     return 0;
 }
 
@@ -392,22 +1216,92 @@ static int Buffer_gc(lua_State* L) {
 static int Buffer_tostring(lua_State* L) {
     BufferUD* ud = (BufferUD*)luaL_checkudata(L, 1, BUFFER_MT);
 
-    t_buffer_obj* obj = buffer_ref_getobject(ud->buffer_ref);
+    t_buffer_info cached;
+    t_buffer_obj* obj = buffer_cached(ud, &cached);
     if (!obj) {
         lua_pushstring(L, "Buffer(not bound)");
         return 1;
     }
 
-    t_buffer_info info;
-    buffer_getinfo(obj, &info);
+    const t_buffer_info* info = &cached;
 
     lua_pushfstring(L, "Buffer(frames=%d, channels=%d, sr=%.1f)",
-                    (int)info.b_frames, (int)info.b_nchans, info.b_sr);
+                    (int)info->b_frames, (int)info->b_nchans, info->b_sr);
     return 1;
 }
 
+// FFI side of Buffer:lock(), the block reads and the bulk copies, run once with the
+// metatable as its argument.
+// The view table is cached per buffer, so locking once per block does not
+// allocate beyond the pointer cast (which the JIT sinks).
+static const char buffer_lock_chunk[] =
+    "local mt = ...\n"
+    "local ok, ffi = pcall(require, 'ffi')\n"
+    "if not ok then return end\n"
+    "local float_ptr = ffi.typeof('float*')\n"
+    "local lock_raw, unlock = mt.lock_raw, mt.unlock\n"
+    "local views = setmetatable({}, { __mode = 'k' })\n"
+    "function mt.lock(self)\n"
+    "   local p, frames, channels = lock_raw(self)\n"
+    "   local view = views[self]\n"
+    "   if not view then\n"
+    "      view = {}\n"
+    "      views[self] = view\n"
+    "   end\n"
+    "   view.samples = ffi.cast(float_ptr, p)\n"
+    "   view.frames = frames\n"
+    "   view.channels = channels\n"
+    "   view.stride = channels\n"
+    "   return view\n"
+    "end\n"
+    "local function finish(self, dirty, ok, ...)\n"
+    "   unlock(self, dirty)\n"
+    "   if not ok then error((...), 0) end\n"
+    "   return ...\n"
+    "end\n"
+    "function mt.with_locked(self, fn, dirty)\n"
+    "   return finish(self, dirty, pcall(fn, mt.lock(self)))\n"
+    "end\n"
+    "local uintptr_t = ffi.typeof('uintptr_t')\n"
+    "local function addr(p) return tonumber(ffi.cast(uintptr_t, p)) end\n"
+    "local read_block_raw, phasor_block_raw, play_block_raw =\n"
+    "   mt.read_block_raw, mt.phasor_block_raw, mt.play_block_raw\n"
+    "function mt.read_block(self, out, pos, n, channel, interp, loop)\n"
+    "   read_block_raw(self, addr(out), addr(pos), n, channel, interp, loop)\n"
+    "end\n"
+    "function mt.phasor_block(self, out, phase, n, channel, interp)\n"
+    "   phasor_block_raw(self, addr(out), addr(phase), n, channel, interp)\n"
+    "end\n"
+    "function mt.play_block(self, out, n, pos, rate, channel, interp, loop)\n"
+    "   if type(rate) == 'number' or rate == nil then\n"
+    "      return play_block_raw(self, addr(out), n, pos, rate, 0, channel, interp, loop)\n"
+    "   end\n"
+    "   return play_block_raw(self, addr(out), n, pos, 0, addr(rate), channel, interp, loop)\n"
+    "end\n"
+    "local read_into_raw, write_from_raw = mt.read_into_raw, mt.write_from_raw\n"
+    "local deinterleave_raw, interleave_raw = mt.deinterleave_raw, mt.interleave_raw\n"
+    "function mt.read_into(self, dst, channel, start, n)\n"
+    "   return read_into_raw(self, addr(dst), channel, start, n)\n"
+    "end\n"
+    "function mt.write_from(self, src, channel, start, n)\n"
+    "   return write_from_raw(self, addr(src), channel, start, n)\n"
+    "end\n"
+    "local function addrs(p, ...)\n"
+    "   if select('#', ...) == 0 then return addr(p) end\n"
+    "   return addr(p), addrs(...)\n"
+    "end\n"
+    "function mt.deinterleave_into(self, start, n, ...)\n"
+    "   return deinterleave_raw(self, start, n, addrs(...))\n"
+    "end\n"
+    "function mt.interleave_from(self, start, n, ...)\n"
+    "   return interleave_raw(self, start, n, addrs(...))\n"
+    "end\n";
+
 // Register Buffer type
 static void register_buffer_type(lua_State* L) {
+    buffer_sinc_init();
+    buffer_listener_init();
+
     // Create metatable
     luaL_newmetatable(L, BUFFER_MT);
 
@@ -421,6 +1315,9 @@ static void register_buffer_type(lua_State* L) {
     lua_pushcfunction(L, Buffer_getinfo);
     lua_setfield(L, -2, "getinfo");
 
+    lua_pushcfunction(L, Buffer_version);
+    lua_setfield(L, -2, "version");
+
     lua_pushcfunction(L, Buffer_frames);
     lua_setfield(L, -2, "frames");
 
@@ -436,6 +1333,39 @@ static void register_buffer_type(lua_State* L) {
     lua_pushcfunction(L, Buffer_poke);
     lua_setfield(L, -2, "poke");
 
+    lua_pushcfunction(L, Buffer_lock_raw);
+    lua_setfield(L, -2, "lock_raw");
+
+    lua_pushcfunction(L, Buffer_unlock);
+    lua_setfield(L, -2, "unlock");
+
+    lua_pushcfunction(L, Buffer_is_locked);
+    lua_setfield(L, -2, "is_locked");
+
+    lua_pushcfunction(L, Buffer_read);
+    lua_setfield(L, -2, "read");
+
+    lua_pushcfunction(L, Buffer_read_block_raw);
+    lua_setfield(L, -2, "read_block_raw");
+
+    lua_pushcfunction(L, Buffer_phasor_block_raw);
+    lua_setfield(L, -2, "phasor_block_raw");
+
+    lua_pushcfunction(L, Buffer_play_block_raw);
+    lua_setfield(L, -2, "play_block_raw");
+
+    lua_pushcfunction(L, Buffer_read_into_raw);
+    lua_setfield(L, -2, "read_into_raw");
+
+    lua_pushcfunction(L, Buffer_write_from_raw);
+    lua_setfield(L, -2, "write_from_raw");
+
+    lua_pushcfunction(L, Buffer_deinterleave_raw);
+    lua_setfield(L, -2, "deinterleave_raw");
+
+    lua_pushcfunction(L, Buffer_interleave_raw);
+    lua_setfield(L, -2, "interleave_raw");
+
     lua_pushcfunction(L, Buffer_to_list);
     lua_setfield(L, -2, "to_list");
 
@@ -459,6 +1389,18 @@ static void register_buffer_type(lua_State* L) {
     lua_pushvalue(L, -1);
     lua_setfield(L, -2, "__index");
 
+    // lock() and with_locked() are defined in Lua on top of lock_raw()
+    if (luaL_loadbuffer(L, buffer_lock_chunk, sizeof(buffer_lock_chunk) - 1, "=api_buffer") == 0) {
+        lua_pushvalue(L, -2);
+        if (lua_pcall(L, 1, 0, 0) != 0) {
+            error("api: Buffer: %s", lua_tostring(L, -1));
+            lua_pop(L, 1);
+        }
+    } else {
+        error("api: Buffer: %s", lua_tostring(L, -1));
+        lua_pop(L, 1);
+    }
+
     lua_pop(L, 1);  // Pop metatable
 
     // Register constructor in api module
@@ -5,6 +5,7 @@
 #define LUAJIT_API_CLOCK_H
 
 #include "api_common.h"
+#include "api_mailbox.h"
 
 // Metatable name for Clock userdata
 #define CLOCK_MT "Max.Clock"
@@ -16,11 +17,15 @@ typedef struct {
     lua_State* L;           // Store Lua state for callback
     int callback_ref;       // Lua registry reference to callback
     void* owner;            // Store owner object pointer
+    LuaMailbox* mailbox;    // engine mailbox (NULL: call Lua directly)
+    int mailbox_slot;
+    unsigned int mailbox_gen;
 } ClockUD;
 
-// Clock callback bridge - called by Max scheduler
-static void clock_callback_bridge(ClockUD* clock_ud) {
-    if (clock_ud == NULL || clock_ud->L == NULL || clock_ud->callback_ref == LUA_NOREF) {
+// Run the Lua callback (on the thread that holds the Lua state)
+static void clock_run_callback(void* p) {
+    ClockUD* clock_ud = (ClockUD*)p;
+    if (clock_ud->L == NULL || clock_ud->callback_ref == LUA_NOREF) {
         return;
     }
 
@@ -32,11 +37,20 @@ static void clock_callback_bridge(ClockUD* clock_ud) {
     // Call the callback with no arguments
     if (lua_pcall(L, 0, 0, 0) != LUA_OK) {
         const char* err = lua_tostring(L, -1);
-        error("Clock callback error: %s", err);
+        api_error_any("Clock callback error: %s", err);
         lua_pop(L, 1);
     }
 }
 
+// Clock callback bridge - called by Max scheduler
+static void clock_callback_bridge(ClockUD* clock_ud) {
+    if (clock_ud == NULL) {
+        return;
+    }
+    mailbox_dispatch(clock_ud->mailbox, clock_ud->mailbox_slot, clock_ud->mailbox_gen,
+                     clock_run_callback, clock_ud);
+}
+
 // Clock constructor: Clock(owner_ptr, callback)
 static int Clock_new(lua_State* L) {
     if (lua_gettop(L) < 2) {
@@ -58,13 +72,22 @@ static int Clock_new(lua_State* L) {
     ud->L = L;
     ud->callback_ref = LUA_NOREF;
     ud->owner = (void*)(intptr_t)lua_tonumber(L, 1);
+    ud->mailbox = mailbox_get(L);
+    ud->mailbox_slot = -1;
+    ud->mailbox_gen = 0;
+    if (ud->mailbox) {
+        ud->mailbox_slot = mailbox_add_source(ud->mailbox, clock_run_callback, ud, &ud->mailbox_gen);
+        if (ud->mailbox_slot < 0) {
+            return luaL_error(L, "Clock(): too many clocks and qelems (max %d)", MAILBOX_MAX_SOURCES);
+        }
+    }
 
     // Store callback in registry
     lua_pushvalue(L, 2);  // Push callback function
     ud->callback_ref = luaL_ref(L, LUA_REGISTRYINDEX);
 
-    // Create Max clock
-    ud->clock = clock_new(ud->owner, (method)clock_callback_bridge);
+    // Create Max clock; the bridge receives the userdata, not the owner
+    ud->clock = clock_new(ud, (method)clock_callback_bridge);
     ud->owns_clock = true;
 
     // Set metatable
@@ -132,6 +155,11 @@ static int Clock_gc(lua_State* L) {
         ud->clock = NULL;
     }
 
+    if (ud->mailbox) {
+        mailbox_remove_source(ud->mailbox, ud->mailbox_slot);
+        ud->mailbox = NULL;
+    }
+
     // Release callback reference
     if (ud->callback_ref != LUA_NOREF) {
         luaL_unref(L, LUA_REGISTRYINDEX, ud->callback_ref);
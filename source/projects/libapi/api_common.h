@@ -17,6 +17,7 @@
 #include "ext_database.h"
 #include "ext_itm.h"
 #include "ext_proto.h"
+#include "ext_systhread.h"
 
 // Lua includes
 #include <lua.h>
@@ -25,6 +26,9 @@
 
 // Standard C includes
 #include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
 
 // Utility macros for Lua C functions
 #define LUA_CHECK_ARGS(L, n) \
@@ -90,4 +94,61 @@ static inline void lua_pushatomarray(lua_State* L, long argc, t_atom* argv) {
     }
 }
 
+// ----------------------------------------------------------------------------
+// Side effects off the Max threads
+//
+// Lua code can run on the audio thread (the DSP function, and clock and qelem
+// callbacks drained at the start of a block) or on a pipeline worker. Outlets
+// and the console are deferred to the main thread from there.
+
+#define API_CONSOLE_CHARS 1024
+
+// True on the audio thread or a worker, where Max messages must not be sent
+static inline bool api_off_max_thread(void) {
+    return !systhread_ismainthread() && !systhread_istimerthread();
+}
+
+static void api_console_deferred(char* text, t_symbol* s, short ac, t_atom* av) {
+    if (s == gensym("error")) {
+        error("%s", text);
+    } else {
+        post("%s", text);
+    }
+    sysmem_freeptr(text);
+}
+
+static void api_console_v(bool is_error, const char* fmt, va_list args) {
+    char text[API_CONSOLE_CHARS];
+    vsnprintf(text, sizeof(text), fmt, args);
+    if (!api_off_max_thread()) {
+        if (is_error) {
+            error("%s", text);
+        } else {
+            post("%s", text);
+        }
+        return;
+    }
+    size_t len = strlen(text) + 1;
+    char* copy = (char*)sysmem_newptr((long)len);
+    if (copy) {
+        memcpy(copy, text, len);
+        defer_low(copy, (method)api_console_deferred, gensym(is_error ? "error" : "post"), 0, NULL);
+    }
+}
+
+// post() and error() that are safe from any thread
+static void api_post_any(const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    api_console_v(false, fmt, args);
+    va_end(args);
+}
+
+static void api_error_any(const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    api_console_v(true, fmt, args);
+    va_end(args);
+}
+
 #endif // LUAJIT_API_COMMON_H
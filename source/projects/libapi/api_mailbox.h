@@ -0,0 +1,419 @@
+// api_mailbox.h
+// Per-engine mailbox that runs clock and qelem callbacks between blocks of
+// the DSP function sharing their lua_State
+
+#ifndef LUAJIT_API_MAILBOX_H
+#define LUAJIT_API_MAILBOX_H
+
+#include <stdlib.h>
+
+#include "api_common.h"
+
+// ----------------------------------------------------------------------------
+// A lua_State is not thread safe, but in luajit~ the audio thread runs the DSP
+// function while clocks fire on the scheduler thread and qelems on the main
+// thread. An engine that attaches a mailbox makes every Clock, Qelem and timer
+// wheel callback (and the engine's own parameter and function changes) go
+// through it instead of calling into Lua directly:
+//
+//   - the call is pushed to a lock-free single-producer ring, one for the
+//     main thread and one for the scheduler thread
+//   - while DSP is running, the audio thread drains both rings at the start
+//     of each block, before the DSP function; it never waits for a lock
+//   - when DSP is off (no block for MAILBOX_IDLE_MS), the posting thread
+//     drains its own ring, holding the VM so that no other thread enters.
+//     Calls left behind when DSP stops are drained by a kick clock (scheduler
+//     ring) and qelem (main ring) on their own threads
+//
+// Callbacks drained by the audio thread reach Max through deferred outlets
+// and the console helpers of api_common.h. Without a mailbox (the luajit
+// message object) callbacks run directly, as before. Callbacks are
+// identified by a source slot and a generation, so a queued call whose Clock
+// or Qelem was collected in the meantime is skipped.
+//
+// Main-thread code that cannot be queued (reloading the script) takes the VM
+// with mailbox_enter(); blocks that start meanwhile output silence, which is
+// what a reload did before the mailbox.
+
+#define MAILBOX_SIZE 1024           // queued calls per ring (power of two)
+#define MAILBOX_MAX_SOURCES 256     // live Clock/Qelem objects per state
+#define MAILBOX_IDLE_MS 250.0       // no block for this long: DSP is off
+#define MAILBOX_KEY "luajit.mailbox"
+
+// Who is running Lua
+enum {
+    MAILBOX_FREE = 0,
+    MAILBOX_AUDIO,      // the DSP thread, for one block
+    MAILBOX_HOST        // a main or scheduler thread, DSP off or reloading
+};
+
+// Producer rings
+enum {
+    MAILBOX_MAIN = 0,
+    MAILBOX_SCHEDULER,
+    MAILBOX_RINGS
+};
+
+typedef void (*mailbox_run_func)(void* ud);
+typedef void (*mailbox_call_func)(void* ud, t_symbol* s, double value);
+
+typedef struct {
+    mailbox_call_func call;     // engine call, or NULL for a source callback
+    void* ud;
+    t_symbol* s;
+    double value;
+    int slot;
+    unsigned int gen;
+    double posted;              // systimer_gettime() at post
+} MailboxCell;
+
+typedef struct {
+    MailboxCell cells[MAILBOX_SIZE];
+    unsigned int head;          // producer
+    unsigned int tail;          // the thread holding the VM
+    bool busy;                  // keeps a stray second producer out
+} MailboxRing;
+
+typedef struct {
+    mailbox_run_func run;
+    void* ud;
+    unsigned int gen;           // bumped when the source goes away
+} MailboxSource;
+
+typedef struct {
+    MailboxRing rings[MAILBOX_RINGS];
+    int owner;                  // MAILBOX_FREE / AUDIO / HOST
+    t_systhread holder;         // thread of the current owner
+    double last_block;          // systimer_gettime() of the last DSP block
+
+    t_clock* kick;              // drains rings left behind when DSP stops
+    t_qelem* kick_main;
+    int kick_armed;
+
+    MailboxSource sources[MAILBOX_MAX_SOURCES];
+
+    // Statistics: dropped and skipped are atomic, the rest belong to the VM holder
+    unsigned int dropped;       // calls lost to a full ring
+    unsigned int skipped;       // blocks silenced while a host held the VM
+    unsigned long executed;
+    double latency_sum;         // ms from post to run
+    double latency_max;
+} LuaMailbox;
+
+static void mailbox_kick_tick(LuaMailbox* mb);
+static void mailbox_kick_main(LuaMailbox* mb);
+
+// Main thread
+static LuaMailbox* mailbox_new(void) {
+    LuaMailbox* mb = (LuaMailbox*)calloc(1, sizeof(LuaMailbox));
+    if (!mb) {
+        return NULL;
+    }
+    mb->last_block = -MAILBOX_IDLE_MS;
+    mb->kick = (t_clock*)clock_new(mb, (method)mailbox_kick_tick);
+    mb->kick_main = (t_qelem*)qelem_new(mb, (method)mailbox_kick_main);
+    return mb;
+}
+
+// After lua_close(), since collecting a Clock or Qelem releases its source
+static void mailbox_free(LuaMailbox* mb) {
+    if (!mb) {
+        return;
+    }
+    if (mb->kick) {
+        clock_unset(mb->kick);
+        freeobject((t_object*)mb->kick);
+    }
+    if (mb->kick_main) {
+        qelem_unset(mb->kick_main);
+        qelem_free(mb->kick_main);
+    }
+    free(mb);
+}
+
+// Make the mailbox visible to Clock(), Qelem() and the timer wheel
+static void mailbox_attach(lua_State* L, LuaMailbox* mb) {
+    lua_pushlightuserdata(L, mb);
+    lua_setfield(L, LUA_REGISTRYINDEX, MAILBOX_KEY);
+}
+
+static LuaMailbox* mailbox_get(lua_State* L) {
+    lua_getfield(L, LUA_REGISTRYINDEX, MAILBOX_KEY);
+    LuaMailbox* mb = (LuaMailbox*)lua_touserdata(L, -1);
+    lua_pop(L, 1);
+    return mb;
+}
+
+// Register a callback source (Lua thread). Returns its slot, or -1 when the
+// table is full; the caller must then fail, since an untracked source could
+// be collected while a call for it is queued.
+static int mailbox_add_source(LuaMailbox* mb, mailbox_run_func run, void* ud, unsigned int* gen) {
+    for (int i = 0; i < MAILBOX_MAX_SOURCES; i++) {
+        if (mb->sources[i].run == NULL) {
+            mb->sources[i].run = run;
+            mb->sources[i].ud = ud;
+            *gen = mb->sources[i].gen;
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Forget a source (Lua thread); queued calls for it are skipped
+static void mailbox_remove_source(LuaMailbox* mb, int slot) {
+    if (slot >= 0 && slot < MAILBOX_MAX_SOURCES) {
+        mb->sources[slot].run = NULL;
+        mb->sources[slot].ud = NULL;
+        mb->sources[slot].gen++;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Rings
+
+static int mailbox_ring_of_thread(void) {
+    return systhread_ismainthread() ? MAILBOX_MAIN : MAILBOX_SCHEDULER;
+}
+
+// Producer side. Each ring has one producer thread; the busy flag only
+// matters if some other thread fires a clock, and never involves the audio
+// thread. Returns false when the ring is full.
+static bool mailbox_push(LuaMailbox* mb, MailboxRing* r, const MailboxCell* c) {
+    while (__atomic_test_and_set(&r->busy, __ATOMIC_ACQUIRE)) {
+    }
+    unsigned int head = r->head;
+    unsigned int tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+    bool ok = head - tail < MAILBOX_SIZE;
+    if (ok) {
+        r->cells[head & (MAILBOX_SIZE - 1)] = *c;
+        __atomic_store_n(&r->head, head + 1, __ATOMIC_RELEASE);
+    } else {
+        __atomic_fetch_add(&mb->dropped, 1, __ATOMIC_RELAXED);
+    }
+    __atomic_clear(&r->busy, __ATOMIC_RELEASE);
+    return ok;
+}
+
+static bool mailbox_ring_empty(MailboxRing* r) {
+    return __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE) == __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+}
+
+// VM holder: run one call
+static void mailbox_run(LuaMailbox* mb, const MailboxCell* c, double now) {
+    if (c->call) {
+        c->call(c->ud, c->s, c->value);
+    } else {
+        MailboxSource* src = &mb->sources[c->slot];
+        if (!src->run || src->gen != c->gen) {
+            return;
+        }
+        src->run(src->ud);
+    }
+    double latency = now - c->posted;
+    mb->executed++;
+    mb->latency_sum += latency;
+    if (latency > mb->latency_max) {
+        mb->latency_max = latency;
+    }
+}
+
+// VM holder: run the calls queued so far. Calls posted by these calls wait
+// for the next drain.
+static void mailbox_drain_ring(LuaMailbox* mb, MailboxRing* r) {
+    unsigned int tail = r->tail;
+    unsigned int end = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+    if (tail == end) {
+        return;
+    }
+    double now = systimer_gettime();
+    while (tail != end) {
+        MailboxCell c = r->cells[tail & (MAILBOX_SIZE - 1)];
+        __atomic_store_n(&r->tail, ++tail, __ATOMIC_RELEASE);
+        mailbox_run(mb, &c, now);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// VM ownership
+
+static bool mailbox_acquire(LuaMailbox* mb, int who) {
+    int expected = MAILBOX_FREE;
+    if (!__atomic_compare_exchange_n(&mb->owner, &expected, who, false,
+                                     __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        return false;
+    }
+    __atomic_store_n(&mb->holder, systhread_self(), __ATOMIC_RELAXED);
+    return true;
+}
+
+static void mailbox_release(LuaMailbox* mb) {
+    __atomic_store_n(&mb->holder, (t_systhread)NULL, __ATOMIC_RELAXED);
+    __atomic_store_n(&mb->owner, MAILBOX_FREE, __ATOMIC_RELEASE);
+}
+
+// The holder field is only ever set to the current thread by itself
+static bool mailbox_held_here(LuaMailbox* mb) {
+    return __atomic_load_n(&mb->owner, __ATOMIC_ACQUIRE) != MAILBOX_FREE &&
+           __atomic_load_n(&mb->holder, __ATOMIC_RELAXED) == systhread_self();
+}
+
+static bool mailbox_audio_active(LuaMailbox* mb) {
+    double last;
+    __atomic_load(&mb->last_block, &last, __ATOMIC_ACQUIRE);
+    return systimer_gettime() - last < MAILBOX_IDLE_MS;
+}
+
+// DSP thread, before the block's Lua calls: take the VM and run what was
+// posted. Returns false only while a host thread holds the VM (a reload, or
+// the first block after DSP starts); the block must then stay out of Lua.
+// On success, call mailbox_end_block() after the block.
+static bool mailbox_begin_block(LuaMailbox* mb) {
+    double now = systimer_gettime();
+    __atomic_store(&mb->last_block, &now, __ATOMIC_RELEASE);
+    if (!mailbox_acquire(mb, MAILBOX_AUDIO)) {
+        __atomic_fetch_add(&mb->skipped, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+    for (int i = 0; i < MAILBOX_RINGS; i++) {
+        mailbox_drain_ring(mb, &mb->rings[i]);
+    }
+    return true;
+}
+
+static void mailbox_end_block(LuaMailbox* mb) {
+    mailbox_release(mb);
+}
+
+// Main thread, for work that cannot be queued: take the VM, waiting for a
+// running block to end. Returns false when this thread already holds it;
+// only a true return is paired with mailbox_leave().
+static bool mailbox_enter(LuaMailbox* mb) {
+    if (mailbox_held_here(mb)) {
+        return false;
+    }
+    while (!mailbox_acquire(mb, MAILBOX_HOST)) {
+        systhread_sleep(0);
+    }
+    return true;
+}
+
+static void mailbox_leave(LuaMailbox* mb) {
+    mailbox_release(mb);
+}
+
+// ----------------------------------------------------------------------------
+// Posting
+
+// DSP off: drain a ring on this thread. Whatever is left (DSP running, or
+// another host holding the VM) is picked up by the audio thread or the kick.
+static void mailbox_host_drain(LuaMailbox* mb, int ring) {
+    MailboxRing* r = &mb->rings[ring];
+    while (!mailbox_audio_active(mb) && mailbox_acquire(mb, MAILBOX_HOST)) {
+        mailbox_drain_ring(mb, r);
+        mailbox_release(mb);
+        if (mailbox_ring_empty(r)) {
+            return;
+        }
+    }
+    if (!mailbox_ring_empty(r) && !__atomic_exchange_n(&mb->kick_armed, 1, __ATOMIC_ACQ_REL)) {
+        clock_fdelay(mb->kick, MAILBOX_IDLE_MS);
+    }
+}
+
+// Kick clock: DSP may have stopped with calls still queued
+static void mailbox_kick_tick(LuaMailbox* mb) {
+    __atomic_store_n(&mb->kick_armed, 0, __ATOMIC_RELEASE);
+    int ring = mailbox_ring_of_thread();
+    mailbox_host_drain(mb, ring);
+    if (ring != MAILBOX_MAIN && !mailbox_ring_empty(&mb->rings[MAILBOX_MAIN])) {
+        qelem_set(mb->kick_main);
+    }
+}
+
+static void mailbox_kick_main(LuaMailbox* mb) {
+    mailbox_host_drain(mb, MAILBOX_MAIN);
+}
+
+static void mailbox_post(LuaMailbox* mb, MailboxCell* c) {
+    // A call made while this thread holds the VM (an outlet leading back
+    // into the object during a drain or a reload) runs at once
+    if (mailbox_held_here(mb)) {
+        mailbox_run(mb, c, c->posted);
+        return;
+    }
+    int ring = mailbox_ring_of_thread();
+    mailbox_push(mb, &mb->rings[ring], c);
+    mailbox_host_drain(mb, ring);
+}
+
+// Clock, Qelem and timer bridges: queue the callback of a source
+static void mailbox_dispatch(LuaMailbox* mb, int slot, unsigned int gen, mailbox_run_func run,
+                             void* ud) {
+    if (!mb) {
+        run(ud);
+        return;
+    }
+    if (slot < 0) {
+        return;     // never registered: nothing guards ud
+    }
+    MailboxCell c = { NULL, NULL, NULL, 0.0, slot, gen, systimer_gettime() };
+    mailbox_post(mb, &c);
+}
+
+// Engine work that touches Lua (parameters, function changes, dsp_prepare):
+// queue call(ud, s, value). ud must outlive the mailbox.
+static void mailbox_call(LuaMailbox* mb, mailbox_call_func call, void* ud, t_symbol* s,
+                         double value) {
+    if (!mb) {
+        call(ud, s, value);
+        return;
+    }
+    MailboxCell c = { call, ud, s, value, -1, 0, systimer_gettime() };
+    mailbox_post(mb, &c);
+}
+
+// api.mailbox_stats() -> pending, executed, dropped, mean_ms, max_ms, skipped_blocks
+// api.mailbox_stats(true) also resets the counters
+static int api_mailbox_stats(lua_State* L) {
+    LuaMailbox* mb = mailbox_get(L);
+    if (!mb) {
+        return 0;
+    }
+    unsigned int pending = 0;
+    for (int i = 0; i < MAILBOX_RINGS; i++) {
+        MailboxRing* r = &mb->rings[i];
+        pending += __atomic_load_n(&r->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+    }
+    lua_pushinteger(L, (lua_Integer)pending);
+    lua_pushnumber(L, (lua_Number)mb->executed);
+    lua_pushinteger(L, (lua_Integer)__atomic_load_n(&mb->dropped, __ATOMIC_RELAXED));
+    lua_pushnumber(L, mb->executed ? mb->latency_sum / (double)mb->executed : 0.0);
+    lua_pushnumber(L, mb->latency_max);
+    lua_pushinteger(L, (lua_Integer)__atomic_load_n(&mb->skipped, __ATOMIC_RELAXED));
+
+    if (lua_toboolean(L, 1)) {
+        mb->executed = 0;
+        mb->latency_sum = 0.0;
+        mb->latency_max = 0.0;
+        __atomic_store_n(&mb->dropped, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&mb->skipped, 0, __ATOMIC_RELAXED);
+    }
+    return 6;
+}
+
+static void register_mailbox_functions(lua_State* L) {
+    lua_getglobal(L, "api");
+    if (!lua_istable(L, -1)) {
+        lua_pop(L, 1);
+        lua_newtable(L);
+        lua_pushvalue(L, -1);
+        lua_setglobal(L, "api");
+    }
+
+    lua_pushcfunction(L, api_mailbox_stats);
+    lua_setfield(L, -2, "mailbox_stats");
+
+    lua_pop(L, 1);  // Pop api table
+}
+
+#endif // LUAJIT_API_MAILBOX_H
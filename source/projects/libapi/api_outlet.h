@@ -15,6 +15,250 @@ typedef struct {
     bool owns_outlet;
 } OutletUD;
 
+// ----------------------------------------------------------------------------
+// Sending
+//
+// On the main or scheduler thread messages go out at once. From the audio
+// thread or a pipeline worker (the DSP function, or a callback drained at the
+// start of a block) they are deferred to the main thread, atoms copied.
+
+static void outlet_deferred(t_outlet* o, t_symbol* s, short ac, t_atom* av) {
+    if (s == gensym("bang")) {
+        outlet_bang(o);
+    } else if (s == gensym("int") && ac == 1) {
+        outlet_int(o, atom_getlong(av));
+    } else if (s == gensym("float") && ac == 1) {
+        outlet_float(o, atom_getfloat(av));
+    } else if (s == gensym("list")) {
+        outlet_list(o, NULL, ac, av);
+    } else {
+        outlet_anything(o, s, ac, av);
+    }
+}
+
+static void outlet_send_bang(t_outlet* o) {
+    if (api_off_max_thread()) {
+        defer_low(o, (method)outlet_deferred, gensym("bang"), 0, NULL);
+    } else {
+        outlet_bang(o);
+    }
+}
+
+static void outlet_send_int(t_outlet* o, t_atom_long value) {
+    if (api_off_max_thread()) {
+        t_atom a;
+        atom_setlong(&a, value);
+        defer_low(o, (method)outlet_deferred, gensym("int"), 1, &a);
+    } else {
+        outlet_int(o, value);
+    }
+}
+
+static void outlet_send_float(t_outlet* o, double value) {
+    if (api_off_max_thread()) {
+        t_atom a;
+        atom_setfloat(&a, value);
+        defer_low(o, (method)outlet_deferred, gensym("float"), 1, &a);
+    } else {
+        outlet_float(o, value);
+    }
+}
+
+static void outlet_send_list(t_outlet* o, t_symbol* s, short ac, t_atom* av) {
+    if (api_off_max_thread()) {
+        defer_low(o, (method)outlet_deferred, gensym("list"), ac, av);
+    } else {
+        outlet_list(o, s, ac, av);
+    }
+}
+
+static void outlet_send_anything(t_outlet* o, t_symbol* s, short ac, t_atom* av) {
+    if (api_off_max_thread()) {
+        defer_low(o, (method)outlet_deferred, s, ac, av);
+    } else {
+        outlet_anything(o, s, ac, av);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Atom buffers for list and anything messages
+//
+// Messages of up to OUTLET_STACK_ATOMS atoms are converted into a buffer on
+// the C stack. Longer ones use an arena shared by every outlet of a Lua state,
+// which grows when needed and is never shrunk, so steady-state output does not
+// allocate. outlet_list() can re-enter the same state (a patch cord leading
+// back to this object); the arena is used as a stack, and a nested call that
+// would need to grow it while an outer message still holds its atoms gets a
+// temporary block instead.
+
+#define OUTLET_STACK_ATOMS 32
+#define OUTLET_ARENA_MT "Max.OutletArena"
+#define OUTLET_ARENA_KEY "luajit.outlet_arena"
+
+typedef struct {
+    t_atom* atoms;
+    long size;
+    long top;   // atoms in use by the messages being sent
+} OutletArena;
+
+static int OutletArena_gc(lua_State* L) {
+    OutletArena* a = (OutletArena*)lua_touserdata(L, 1);
+    if (a->atoms) {
+        sysmem_freeptr(a->atoms);
+        a->atoms = NULL;
+    }
+    return 0;
+}
+
+// Push the state's arena, creating it on first use
+static void outlet_arena_push(lua_State* L) {
+    lua_getfield(L, LUA_REGISTRYINDEX, OUTLET_ARENA_KEY);
+    if (!lua_isnil(L, -1)) {
+        return;
+    }
+    lua_pop(L, 1);
+
+    OutletArena* a = (OutletArena*)lua_newuserdata(L, sizeof(OutletArena));
+    a->atoms = NULL;
+    a->size = 0;
+    a->top = 0;
+    if (luaL_newmetatable(L, OUTLET_ARENA_MT)) {
+        lua_pushcfunction(L, OutletArena_gc);
+        lua_setfield(L, -2, "__gc");
+    }
+    lua_setmetatable(L, -2);
+    lua_pushvalue(L, -1);
+    lua_setfield(L, LUA_REGISTRYINDEX, OUTLET_ARENA_KEY);
+}
+
+// n atoms from the arena; *mark is what outlet_arena_release() restores,
+// or -1 for a temporary block. Returns NULL when out of memory.
+static t_atom* outlet_arena_take(OutletArena* a, long n, long* mark) {
+    if (a->top + n > a->size) {
+        if (a->top > 0) {
+            *mark = -1;
+            return (t_atom*)sysmem_newptr(n * sizeof(t_atom));
+        }
+        long size = a->size * 2 > n ? a->size * 2 : n;
+        t_atom* atoms = (t_atom*)sysmem_newptr(size * sizeof(t_atom));
+        if (!atoms) {
+            return NULL;
+        }
+        if (a->atoms) {
+            sysmem_freeptr(a->atoms);
+        }
+        a->atoms = atoms;
+        a->size = size;
+    }
+    *mark = a->top;
+    a->top += n;
+    return a->atoms + *mark;
+}
+
+static void outlet_arena_release(OutletArena* a, t_atom* av, long mark) {
+    if (mark < 0) {
+        sysmem_freeptr(av);
+    } else {
+        a->top = mark;
+    }
+}
+
+// Atoms for one call: the stack buffer when it is large enough
+typedef struct {
+    t_atom stack[OUTLET_STACK_ATOMS];
+    t_atom* av;
+    long mark;
+    OutletArena* arena;     // NULL when av is the stack buffer
+} OutletAtoms;
+
+static t_atom* outlet_atoms_begin(lua_State* L, OutletAtoms* b, long n) {
+    if (n <= OUTLET_STACK_ATOMS) {
+        b->av = b->stack;
+        b->arena = NULL;
+        return b->av;
+    }
+    b->arena = (OutletArena*)lua_touserdata(L, lua_upvalueindex(1));
+    b->av = outlet_arena_take(b->arena, n, &b->mark);
+    if (!b->av) {
+        luaL_error(L, "Failed to allocate memory for atoms");
+    }
+    return b->av;
+}
+
+static void outlet_atoms_end(OutletAtoms* b) {
+    if (b->arena) {
+        outlet_arena_release(b->arena, b->av, b->mark);
+        b->arena = NULL;
+    }
+}
+
+// Convert the array part of the table at idx; raises after releasing b
+static void outlet_atoms_convert(lua_State* L, OutletAtoms* b, int idx, t_atom* av, long ac) {
+    for (long i = 0; i < ac; i++) {
+        lua_rawgeti(L, idx, i + 1);
+        if (!lua_toatom(L, -1, &av[i])) {
+            outlet_atoms_end(b);
+            luaL_error(L, "Table element %d is not a valid atom type", (int)(i + 1));
+        }
+        lua_pop(L, 1);
+    }
+}
+
+// Send the table at idx as a list, or as sel followed by its elements
+static int outlet_send_table(lua_State* L, t_outlet* outlet, t_symbol* sel, int idx) {
+    luaL_checktype(L, idx, LUA_TTABLE);
+
+    long ac = (long)lua_objlen(L, idx);
+    OutletAtoms b;
+    t_atom* av = outlet_atoms_begin(L, &b, ac);
+    outlet_atoms_convert(L, &b, idx, av, ac);
+
+    if (sel) {
+        outlet_send_anything(outlet, sel, (short)ac, av);
+    } else {
+        outlet_send_list(outlet, NULL, (short)ac, av);
+    }
+    outlet_atoms_end(&b);
+    return 0;
+}
+
+// Send the tables at first .. top in order. All of them are converted before
+// the first is sent, into one block laid out as [count, atoms...] per message.
+// A table whose first element is a string goes out as that message
+// ({"note", 60, 100} -> note 60 100), like the message box.
+static int outlet_send_many(lua_State* L, t_outlet* outlet, int first) {
+    int top = lua_gettop(L);
+    long total = 0;
+    for (int i = first; i <= top; i++) {
+        luaL_checktype(L, i, LUA_TTABLE);
+        total += 1 + (long)lua_objlen(L, i);
+    }
+
+    OutletAtoms b;
+    t_atom* av = outlet_atoms_begin(L, &b, total);
+    t_atom* p = av;
+    for (int i = first; i <= top; i++) {
+        long ac = (long)lua_objlen(L, i);
+        atom_setlong(p, ac);
+        outlet_atoms_convert(L, &b, i, p + 1, ac);
+        p += 1 + ac;
+    }
+
+    p = av;
+    for (int i = first; i <= top; i++) {
+        long ac = (long)atom_getlong(p);
+        t_atom* msg = p + 1;
+        if (ac > 0 && atom_gettype(msg) == A_SYM) {
+            outlet_send_anything(outlet, atom_getsym(msg), (short)(ac - 1), msg + 1);
+        } else {
+            outlet_send_list(outlet, NULL, (short)ac, msg);
+        }
+        p += 1 + ac;
+    }
+    outlet_atoms_end(&b);
+    return 0;
+}
+
 // Outlet constructor: Outlet(owner_ptr, type_string)
 static int Outlet_new(lua_State* L) {
     if (lua_gettop(L) < 2) {
@@ -44,7 +288,7 @@ static int Outlet_bang(lua_State* L) {
         return luaL_error(L, "Outlet is null");
     }
 
-    outlet_bang((t_outlet*)ud->outlet);
+    outlet_send_bang((t_outlet*)ud->outlet);
     return 0;
 }
 
@@ -57,7 +301,7 @@ static int Outlet_int(lua_State* L) {
     }
 
     t_atom_long value = (t_atom_long)luaL_checknumber(L, 2);
-    outlet_int((t_outlet*)ud->outlet, value);
+    outlet_send_int((t_outlet*)ud->outlet, value);
 
     return 0;
 }
@@ -71,7 +315,7 @@ static int Outlet_float(lua_State* L) {
     }
 
     double value = luaL_checknumber(L, 2);
-    outlet_float((t_outlet*)ud->outlet, value);
+    outlet_send_float((t_outlet*)ud->outlet, value);
 
     return 0;
 }
@@ -86,7 +330,7 @@ static int Outlet_symbol(lua_State* L) {
 
     const char* str = luaL_checkstring(L, 2);
     t_symbol* sym = gensym(str);
-    outlet_anything((t_outlet*)ud->outlet, sym, 0, NULL);
+    outlet_send_anything((t_outlet*)ud->outlet, sym, 0, NULL);
 
     return 0;
 }
@@ -99,30 +343,7 @@ static int Outlet_list(lua_State* L) {
         return luaL_error(L, "Outlet is null");
     }
 
-    luaL_checktype(L, 2, LUA_TTABLE);
-
-    // Convert Lua table to atom array
-    long ac = (long)lua_objlen(L, 2);
-    t_atom* av = (t_atom*)sysmem_newptr(ac * sizeof(t_atom));
-
-    if (!av) {
-        return luaL_error(L, "Failed to allocate memory for atoms");
-    }
-
-    for (long i = 0; i < ac; i++) {
-        lua_rawgeti(L, 2, i + 1);
-        if (!lua_toatom(L, -1, &av[i])) {
-            sysmem_freeptr(av);
-            return luaL_error(L, "Table element %d is not a valid atom type", (int)(i + 1));
-        }
-        lua_pop(L, 1);
-    }
-
-    outlet_list((t_outlet*)ud->outlet, NULL, (short)ac, av);
-
-    sysmem_freeptr(av);
-
-    return 0;
+    return outlet_send_table(L, (t_outlet*)ud->outlet, NULL, 2);
 }
 
 // Outlet.anything(symbol, table_of_values)
@@ -136,30 +357,18 @@ static int Outlet_anything(lua_State* L) {
     const char* sym_str = luaL_checkstring(L, 2);
     t_symbol* sym = gensym(sym_str);
 
-    luaL_checktype(L, 3, LUA_TTABLE);
-
-    // Convert Lua table to atom array
-    long ac = (long)lua_objlen(L, 3);
-    t_atom* av = (t_atom*)sysmem_newptr(ac * sizeof(t_atom));
+    return outlet_send_table(L, (t_outlet*)ud->outlet, sym, 3);
+}
 
-    if (!av) {
-        return luaL_error(L, "Failed to allocate memory for atoms");
-    }
+// Outlet.list_many(table1, table2, ...) - Several lists in one call
+static int Outlet_list_many(lua_State* L) {
+    OutletUD* ud = (OutletUD*)luaL_checkudata(L, 1, OUTLET_MT);
 
-    for (long i = 0; i < ac; i++) {
-        lua_rawgeti(L, 3, i + 1);
-        if (!lua_toatom(L, -1, &av[i])) {
-            sysmem_freeptr(av);
-            return luaL_error(L, "Table element %d is not a valid atom type", (int)(i + 1));
-        }
-        lua_pop(L, 1);
+    if (ud->outlet == NULL) {
+        return luaL_error(L, "Outlet is null");
     }
 
-    outlet_anything((t_outlet*)ud->outlet, sym, (short)ac, av);
-
-    sysmem_freeptr(av);
-
-    return 0;
+    return outlet_send_many(L, (t_outlet*)ud->outlet, 2);
 }
 
 // Outlet.pointer()
@@ -207,12 +416,19 @@ static void register_outlet_type(lua_State* L) {
     lua_pushcfunction(L, Outlet_symbol);
     lua_setfield(L, -2, "symbol");
 
-    lua_pushcfunction(L, Outlet_list);
+    // The message senders share the state's atom arena as upvalue 1
+    outlet_arena_push(L);
+    lua_pushcclosure(L, Outlet_list, 1);
     lua_setfield(L, -2, "list");
 
-    lua_pushcfunction(L, Outlet_anything);
+    outlet_arena_push(L);
+    lua_pushcclosure(L, Outlet_anything, 1);
     lua_setfield(L, -2, "anything");
 
+    outlet_arena_push(L);
+    lua_pushcclosure(L, Outlet_list_many, 1);
+    lua_setfield(L, -2, "list_many");
+
     lua_pushcfunction(L, Outlet_pointer);
     lua_setfield(L, -2, "pointer");
 
@@ -253,7 +469,7 @@ static int OutletWrapper_bang(lua_State* L) {
     if (*outlet_ptr == NULL) {
         return luaL_error(L, "Outlet is null");
     }
-    outlet_bang((t_outlet*)*outlet_ptr);
+    outlet_send_bang((t_outlet*)*outlet_ptr);
     return 0;
 }
 
@@ -263,7 +479,7 @@ static int OutletWrapper_int(lua_State* L) {
         return luaL_error(L, "Outlet is null");
     }
     t_atom_long value = (t_atom_long)luaL_checknumber(L, 2);
-    outlet_int((t_outlet*)*outlet_ptr, value);
+    outlet_send_int((t_outlet*)*outlet_ptr, value);
     return 0;
 }
 
@@ -273,7 +489,7 @@ static int OutletWrapper_float(lua_State* L) {
         return luaL_error(L, "Outlet is null");
     }
     double value = luaL_checknumber(L, 2);
-    outlet_float((t_outlet*)*outlet_ptr, value);
+    outlet_send_float((t_outlet*)*outlet_ptr, value);
     return 0;
 }
 
@@ -284,7 +500,7 @@ static int OutletWrapper_symbol(lua_State* L) {
     }
     const char* str = luaL_checkstring(L, 2);
     t_symbol* sym = gensym(str);
-    outlet_anything((t_outlet*)*outlet_ptr, sym, 0, NULL);
+    outlet_send_anything((t_outlet*)*outlet_ptr, sym, 0, NULL);
     return 0;
 }
 
@@ -293,30 +509,7 @@ static int OutletWrapper_list(lua_State* L) {
     if (*outlet_ptr == NULL) {
         return luaL_error(L, "Outlet is null");
     }
-
-    luaL_checktype(L, 2, LUA_TTABLE);
-
-    // Convert Lua table to atom array
-    long ac = (long)lua_objlen(L, 2);
-    t_atom* av = (t_atom*)sysmem_newptr(ac * sizeof(t_atom));
-
-    if (!av) {
-        return luaL_error(L, "Failed to allocate memory for atoms");
-    }
-
-    for (long i = 0; i < ac; i++) {
-        lua_rawgeti(L, 2, i + 1);
-        if (!lua_toatom(L, -1, &av[i])) {
-            sysmem_freeptr(av);
-            return luaL_error(L, "Table element %d is not a valid atom type", (int)(i + 1));
-        }
-        lua_pop(L, 1);
-    }
-
-    outlet_list((t_outlet*)*outlet_ptr, NULL, (short)ac, av);
-    sysmem_freeptr(av);
-
-    return 0;
+    return outlet_send_table(L, (t_outlet*)*outlet_ptr, NULL, 2);
 }
 
 static int OutletWrapper_anything(lua_State* L) {
@@ -324,33 +517,17 @@ static int OutletWrapper_anything(lua_State* L) {
     if (*outlet_ptr == NULL) {
         return luaL_error(L, "Outlet is null");
     }
-
     const char* sym_str = luaL_checkstring(L, 2);
     t_symbol* sym = gensym(sym_str);
+    return outlet_send_table(L, (t_outlet*)*outlet_ptr, sym, 3);
+}
 
-    luaL_checktype(L, 3, LUA_TTABLE);
-
-    // Convert Lua table to atom array
-    long ac = (long)lua_objlen(L, 3);
-    t_atom* av = (t_atom*)sysmem_newptr(ac * sizeof(t_atom));
-
-    if (!av) {
-        return luaL_error(L, "Failed to allocate memory for atoms");
-    }
-
-    for (long i = 0; i < ac; i++) {
-        lua_rawgeti(L, 3, i + 1);
-        if (!lua_toatom(L, -1, &av[i])) {
-            sysmem_freeptr(av);
-            return luaL_error(L, "Table element %d is not a valid atom type", (int)(i + 1));
-        }
-        lua_pop(L, 1);
+static int OutletWrapper_list_many(lua_State* L) {
+    void** outlet_ptr = (void**)luaL_checkudata(L, 1, OUTLET_WRAPPER_MT);
+    if (*outlet_ptr == NULL) {
+        return luaL_error(L, "Outlet is null");
     }
-
-    outlet_anything((t_outlet*)*outlet_ptr, sym, (short)ac, av);
-    sysmem_freeptr(av);
-
-    return 0;
+    return outlet_send_many(L, (t_outlet*)*outlet_ptr, 2);
 }
 
 static int OutletWrapper_tostring(lua_State* L) {
@@ -381,12 +558,19 @@ static void register_outlet_wrapper_type(lua_State* L) {
     lua_pushcfunction(L, OutletWrapper_symbol);
     lua_setfield(L, -2, "symbol");
 
-    lua_pushcfunction(L, OutletWrapper_list);
+    // The message senders share the state's atom arena as upvalue 1
+    outlet_arena_push(L);
+    lua_pushcclosure(L, OutletWrapper_list, 1);
     lua_setfield(L, -2, "list");
 
-    lua_pushcfunction(L, OutletWrapper_anything);
+    outlet_arena_push(L);
+    lua_pushcclosure(L, OutletWrapper_anything, 1);
     lua_setfield(L, -2, "anything");
 
+    outlet_arena_push(L);
+    lua_pushcclosure(L, OutletWrapper_list_many, 1);
+    lua_setfield(L, -2, "list_many");
+
     // Register metamethods
     lua_pushcfunction(L, OutletWrapper_tostring);
     lua_setfield(L, -2, "__tostring");
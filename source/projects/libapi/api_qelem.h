@@ -5,7 +5,13 @@
 #ifndef LUAJIT_API_QELEM_H
 #define LUAJIT_API_QELEM_H
 
+#include <stdlib.h>
+#include <string.h>
+
 #include "api_common.h"
+#include "api_mailbox.h"
+#include "api_outlet.h"
+#include "api_symbol.h"
 
 // Metatable name for Qelem userdata
 #define QELEM_MT "Max.Qelem"
@@ -17,11 +23,15 @@ typedef struct {
     int callback_ref;       // Lua registry reference to callback
     int userdata_ref;       // Lua registry reference to userdata (optional)
     bool is_set;
+    LuaMailbox* mailbox;    // engine mailbox (NULL: call Lua directly)
+    int mailbox_slot;
+    unsigned int mailbox_gen;
 } QelemUD;
 
-// Callback wrapper that executes Lua callback
-static void qelem_callback_wrapper(QelemUD* ud) {
-    if (!ud || !ud->L || ud->callback_ref == LUA_NOREF) {
+// Run the Lua callback (on the thread that holds the Lua state)
+static void qelem_run_callback(void* p) {
+    QelemUD* ud = (QelemUD*)p;
+    if (!ud->L || ud->callback_ref == LUA_NOREF) {
         return;
     }
 
@@ -41,7 +51,7 @@ static void qelem_callback_wrapper(QelemUD* ud) {
     if (lua_pcall(L, nargs, 0, 0) != 0) {
         // Error in callback
         const char* err = lua_tostring(L, -1);
-        error("Qelem callback error: %s", err);
+        api_error_any("Qelem callback error: %s", err);
         lua_pop(L, 1);
     }
 
@@ -49,6 +59,14 @@ static void qelem_callback_wrapper(QelemUD* ud) {
     ud->is_set = false;
 }
 
+// Callback wrapper - called by Max on the main thread
+static void qelem_callback_wrapper(QelemUD* ud) {
+    if (!ud) {
+        return;
+    }
+    mailbox_dispatch(ud->mailbox, ud->mailbox_slot, ud->mailbox_gen, qelem_run_callback, ud);
+}
+
 // Qelem constructor: Qelem(callback, userdata)
 static int Qelem_new(lua_State* L) {
     if (lua_gettop(L) < 1) {
@@ -65,6 +83,15 @@ static int Qelem_new(lua_State* L) {
     ud->callback_ref = LUA_NOREF;
     ud->userdata_ref = LUA_NOREF;
     ud->is_set = false;
+    ud->mailbox = mailbox_get(L);
+    ud->mailbox_slot = -1;
+    ud->mailbox_gen = 0;
+    if (ud->mailbox) {
+        ud->mailbox_slot = mailbox_add_source(ud->mailbox, qelem_run_callback, ud, &ud->mailbox_gen);
+        if (ud->mailbox_slot < 0) {
+            return luaL_error(L, "Qelem(): too many clocks and qelems (max %d)", MAILBOX_MAX_SOURCES);
+        }
+    }
 
     // Store callback in registry
     lua_pushvalue(L, 1);
@@ -86,6 +113,9 @@ static int Qelem_new(lua_State* L) {
         if (ud->userdata_ref != LUA_NOREF) {
             luaL_unref(L, LUA_REGISTRYINDEX, ud->userdata_ref);
         }
+        if (ud->mailbox) {
+            mailbox_remove_source(ud->mailbox, ud->mailbox_slot);
+        }
         return luaL_error(L, "Failed to create qelem");
     }
 
@@ -168,6 +198,11 @@ static int Qelem_gc(lua_State* L) {
         ud->qelem = NULL;
     }
 
+    if (ud->mailbox) {
+        mailbox_remove_source(ud->mailbox, ud->mailbox_slot);
+        ud->mailbox = NULL;
+    }
+
     // Free Lua registry references
     if (ud->callback_ref != LUA_NOREF) {
         luaL_unref(L, LUA_REGISTRYINDEX, ud->callback_ref);
@@ -195,6 +230,401 @@ static int Qelem_tostring(lua_State* L) {
     return 1;
 }
 
+// ----------------------------------------------------------------------------
+// Updates: coalescing UI channel
+//
+// ui:set(key, outlet, ...) stores the message for key and sets a qelem; a
+// later set() of the same key before the qelem runs replaces the message.
+// The qelem sends every pending message in one pass, in the order their keys
+// first became pending, so UI traffic follows the main thread (and an
+// optional minimum interval) rather than the script's event rate.
+//
+// The flush is plain C and does not enter Lua, so it bypasses the engine
+// mailbox. Writers may be the audio thread in luajit~; entries are shared
+// under a spinlock held only to copy atoms in set() and out in the flush.
+// Nothing allocates or frees with the lock held. The first set() of a key
+// allocates its entry (and its key table slot) unless Updates(ms, keys)
+// reserved room for it, so new keys must not appear on the audio thread.
+// Strings go through gensym(), which allocates for a new symbol: off the
+// main and scheduler threads set() takes symbols made by api.gensym() on the
+// main thread, and rejects strings.
+
+#define UPDATES_MT "Max.Updates"
+#define UPDATES_MAX_ATOMS 16
+#define UPDATES_NOT_PENDING (-2)
+
+typedef struct {
+    t_outlet* outlet;
+    t_symbol* sel;          // NULL: list (or int/float for one number)
+    short ac;
+    t_atom av[UPDATES_MAX_ATOMS];
+    int next;               // pending list link, UPDATES_NOT_PENDING if idle
+} UpdateEntry;
+
+typedef struct {
+    UpdateEntry* entries;   // one per key, guarded by lock
+    int count;
+    int capacity;
+    int head, tail;         // pending keys, first-come order
+    int pending;
+    bool lock;
+
+    UpdateEntry* out;       // flush copy, main thread only
+    int out_capacity;
+
+    t_qelem* qelem;
+    t_clock* clock;         // defers the qelem when interval is not up
+    double interval;        // ms, 0 = every qelem run
+    double last_flush;
+    int keys_ref;           // key -> entry index
+
+    unsigned long updates, coalesced, sent, flushes;
+    unsigned long dropped;  // pending messages lost to a failed allocation
+} UpdatesUD;
+
+static void updates_lock(UpdatesUD* u) {
+    while (__atomic_test_and_set(&u->lock, __ATOMIC_ACQUIRE)) {
+    }
+}
+
+static void updates_unlock(UpdatesUD* u) {
+    __atomic_clear(&u->lock, __ATOMIC_RELEASE);
+}
+
+// Main thread: send everything pending
+static void updates_flush(UpdatesUD* u) {
+    if (u->interval > 0.0) {
+        double now = systimer_gettime();
+        double wait = u->last_flush + u->interval - now;
+        if (wait > 0.0) {
+            clock_fdelay(u->clock, wait);
+            return;
+        }
+        u->last_flush = now;
+    }
+
+    // Grow the flush copy outside the lock; keys that become pending in
+    // between are left for the next run
+    updates_lock(u);
+    int pending = u->pending;
+    updates_unlock(u);
+    bool grown = true;
+    if (pending > u->out_capacity) {
+        UpdateEntry* out = (UpdateEntry*)realloc(u->out, sizeof(UpdateEntry) * (size_t)pending);
+        if (out) {
+            u->out = out;
+            u->out_capacity = pending;
+        } else {
+            grown = false;
+        }
+    }
+
+    updates_lock(u);
+    int n = 0;
+    int dropped = 0;
+    while (u->head >= 0) {
+        UpdateEntry* e = &u->entries[u->head];
+        if (n < u->out_capacity) {
+            u->out[n++] = *e;
+        } else if (!grown) {
+            dropped++;  // no room to send it: drop it rather than retry forever
+        } else {
+            break;
+        }
+        u->head = e->next;
+        e->next = UPDATES_NOT_PENDING;
+    }
+    if (u->head < 0) {
+        u->tail = -1;
+    }
+    u->pending -= n + dropped;
+    bool more = u->pending > 0;
+    u->sent += (unsigned long)n;
+    u->dropped += (unsigned long)dropped;
+    u->flushes++;
+    updates_unlock(u);
+
+    for (int i = 0; i < n; i++) {
+        UpdateEntry* e = &u->out[i];
+        if (e->sel) {
+            outlet_anything(e->outlet, e->sel, e->ac, e->av);
+        } else if (e->ac == 1 && atom_gettype(e->av) == A_LONG) {
+            outlet_int(e->outlet, atom_getlong(e->av));
+        } else if (e->ac == 1 && atom_gettype(e->av) == A_FLOAT) {
+            outlet_float(e->outlet, atom_getfloat(e->av));
+        } else {
+            outlet_list(e->outlet, NULL, e->ac, e->av);
+        }
+    }
+    if (more) {
+        qelem_set(u->qelem);
+    }
+}
+
+static void updates_clock_tick(UpdatesUD* u) {
+    qelem_set(u->qelem);
+}
+
+// api.Outlet, an injected outlet, or an outlet pointer
+static t_outlet* updates_check_outlet(lua_State* L, int idx) {
+    if (lua_isnumber(L, idx)) {
+        return (t_outlet*)(intptr_t)lua_tonumber(L, idx);
+    }
+    void* p = lua_touserdata(L, idx);
+    if (p && lua_getmetatable(L, idx)) {
+        luaL_getmetatable(L, OUTLET_MT);
+        bool is_outlet = lua_rawequal(L, -1, -2);
+        lua_pop(L, 1);
+        luaL_getmetatable(L, OUTLET_WRAPPER_MT);
+        bool is_wrapper = lua_rawequal(L, -1, -2);
+        lua_pop(L, 2);
+        if (is_outlet) {
+            return (t_outlet*)((OutletUD*)p)->outlet;
+        }
+        if (is_wrapper) {
+            return (t_outlet*)*(void**)p;
+        }
+    }
+    luaL_argerror(L, idx, "outlet expected");
+    return NULL;
+}
+
+// Reserve entries for capacity keys (Lua thread). The new array is filled
+// and swapped in under the lock; allocation and free happen outside it.
+static bool updates_reserve(UpdatesUD* u, int capacity) {
+    if (capacity <= u->capacity) {
+        return true;
+    }
+    UpdateEntry* entries = (UpdateEntry*)malloc(sizeof(UpdateEntry) * (size_t)capacity);
+    if (!entries) {
+        return false;
+    }
+    updates_lock(u);
+    UpdateEntry* old = u->entries;
+    if (old) {
+        memcpy(entries, old, sizeof(UpdateEntry) * (size_t)u->count);
+    }
+    u->entries = entries;
+    u->capacity = capacity;
+    updates_unlock(u);
+    free(old);
+    return true;
+}
+
+// Updates([interval_ms [, keys]])
+// keys reserves room for that many keys, so their first set() does not allocate
+static int Updates_new(lua_State* L) {
+    double interval = luaL_optnumber(L, 1, 0.0);
+    int keys = (int)luaL_optinteger(L, 2, 0);
+
+    UpdatesUD* u = (UpdatesUD*)lua_newuserdata(L, sizeof(UpdatesUD));
+    memset(u, 0, sizeof(UpdatesUD));
+    u->head = -1;
+    u->tail = -1;
+    u->interval = interval > 0.0 ? interval : 0.0;
+    u->keys_ref = LUA_NOREF;
+
+    lua_createtable(L, 0, keys > 0 ? keys : 0);
+    u->keys_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+
+    if (keys > 0 && !updates_reserve(u, keys)) {
+        luaL_unref(L, LUA_REGISTRYINDEX, u->keys_ref);
+        u->keys_ref = LUA_NOREF;
+        return luaL_error(L, "Failed to allocate memory for updates");
+    }
+
+    u->qelem = qelem_new(u, (method)updates_flush);
+    if (!u->qelem) {
+        luaL_unref(L, LUA_REGISTRYINDEX, u->keys_ref);
+        u->keys_ref = LUA_NOREF;
+        free(u->entries);
+        u->entries = NULL;
+        return luaL_error(L, "Failed to create qelem");
+    }
+    u->clock = clock_new(u, (method)updates_clock_tick);
+
+    luaL_getmetatable(L, UPDATES_MT);
+    lua_setmetatable(L, -2);
+    return 1;
+}
+
+// The t_symbol of an api.gensym() symbol, or NULL
+static t_symbol* updates_tosymbol(lua_State* L, int idx) {
+    void* p = lua_touserdata(L, idx);
+    if (p && lua_getmetatable(L, idx)) {
+        luaL_getmetatable(L, SYMBOL_MT);
+        bool is_symbol = lua_rawequal(L, -1, -2);
+        lua_pop(L, 2);
+        if (is_symbol) {
+            return ((SymbolUD*)p)->sym;
+        }
+    }
+    return NULL;
+}
+
+// One set() value: a number, boolean, string or api.gensym() symbol.
+// With interned_only (off the Max threads) strings raise an error, since
+// gensym() may allocate.
+static void updates_toatom(lua_State* L, int idx, t_atom* atom, bool interned_only) {
+    t_symbol* sym = updates_tosymbol(L, idx);
+    if (sym) {
+        atom_setsym(atom, sym);
+    } else if (lua_type(L, idx) == LUA_TSTRING && interned_only) {
+        luaL_argerror(L, idx, "strings allocate off the main thread; pass api.gensym() symbols");
+    } else if (!lua_toatom(L, idx, atom)) {
+        luaL_argerror(L, idx, "number, string, boolean or symbol expected");
+    }
+}
+
+// Updates:set(key, outlet, ...)
+// A leading string or symbol is the selector (set(k, o, "set", 1, 2) -> set 1 2);
+// otherwise the values go out as a list, or as int/float when there is one
+static int Updates_set(lua_State* L) {
+    UpdatesUD* u = (UpdatesUD*)luaL_checkudata(L, 1, UPDATES_MT);
+    if (lua_isnoneornil(L, 2)) {
+        return luaL_argerror(L, 2, "key expected");
+    }
+    if (!u->qelem) {
+        return luaL_error(L, "Updates is null");
+    }
+
+    UpdateEntry msg;
+    msg.outlet = updates_check_outlet(L, 3);
+    msg.sel = NULL;
+    int first = 4;
+    int top = lua_gettop(L);
+    bool interned_only = api_off_max_thread();
+    if (first <= top && (lua_type(L, first) == LUA_TSTRING || updates_tosymbol(L, first))) {
+        t_atom sel;
+        updates_toatom(L, first, &sel, interned_only);
+        msg.sel = atom_getsym(&sel);
+        first++;
+    }
+    if (top - first + 1 > UPDATES_MAX_ATOMS) {
+        return luaL_error(L, "Updates:set(): at most %d values", UPDATES_MAX_ATOMS);
+    }
+    msg.ac = 0;
+    for (int i = first; i <= top; i++) {
+        updates_toatom(L, i, &msg.av[msg.ac++], interned_only);
+    }
+
+    // Slot for the key, allocated on its first update
+    lua_rawgeti(L, LUA_REGISTRYINDEX, u->keys_ref);
+    lua_pushvalue(L, 2);
+    lua_rawget(L, -2);
+    int slot;
+    if (lua_isnumber(L, -1)) {
+        slot = (int)lua_tointeger(L, -1);
+        lua_pop(L, 2);
+    } else {
+        lua_pop(L, 1);
+        slot = u->count;
+        if (slot == u->capacity && !updates_reserve(u, u->capacity ? u->capacity * 2 : 16)) {
+            lua_pop(L, 1);
+            return luaL_error(L, "Failed to allocate memory for updates");
+        }
+        u->entries[slot].next = UPDATES_NOT_PENDING;
+        u->count++;
+        lua_pushvalue(L, 2);
+        lua_pushinteger(L, slot);
+        lua_rawset(L, -3);
+        lua_pop(L, 1);
+    }
+
+    updates_lock(u);
+    UpdateEntry* e = &u->entries[slot];
+    bool pending = e->next != UPDATES_NOT_PENDING;
+    int next = e->next;
+    *e = msg;
+    u->updates++;
+    if (pending) {
+        e->next = next;
+        u->coalesced++;
+    } else {
+        e->next = -1;
+        if (u->tail >= 0) {
+            u->entries[u->tail].next = slot;
+        } else {
+            u->head = slot;
+        }
+        u->tail = slot;
+        u->pending++;
+    }
+    bool first_pending = !pending && u->pending == 1;
+    updates_unlock(u);
+
+    if (first_pending) {
+        qelem_set(u->qelem);
+    }
+    return 0;
+}
+
+// Updates:interval(ms) - minimum time between flushes, 0 for none
+static int Updates_interval(lua_State* L) {
+    UpdatesUD* u = (UpdatesUD*)luaL_checkudata(L, 1, UPDATES_MT);
+    double ms = luaL_checknumber(L, 2);
+    u->interval = ms > 0.0 ? ms : 0.0;
+    return 0;
+}
+
+// Updates:stats([reset]) -> pending, updates, coalesced, sent, flushes, dropped
+static int Updates_stats(lua_State* L) {
+    UpdatesUD* u = (UpdatesUD*)luaL_checkudata(L, 1, UPDATES_MT);
+    updates_lock(u);
+    lua_pushinteger(L, u->pending);
+    lua_pushnumber(L, (lua_Number)u->updates);
+    lua_pushnumber(L, (lua_Number)u->coalesced);
+    lua_pushnumber(L, (lua_Number)u->sent);
+    lua_pushnumber(L, (lua_Number)u->flushes);
+    lua_pushnumber(L, (lua_Number)u->dropped);
+    if (lua_toboolean(L, 2)) {
+        u->updates = 0;
+        u->coalesced = 0;
+        u->sent = 0;
+        u->flushes = 0;
+        u->dropped = 0;
+    }
+    updates_unlock(u);
+    return 6;
+}
+
+static int Updates_gc(lua_State* L) {
+    UpdatesUD* u = (UpdatesUD*)luaL_checkudata(L, 1, UPDATES_MT);
+
+    if (u->clock) {
+        clock_unset(u->clock);
+        freeobject((t_object*)u->clock);
+        u->clock = NULL;
+    }
+    if (u->qelem) {
+        qelem_unset(u->qelem);
+        qelem_free(u->qelem);
+        u->qelem = NULL;
+    }
+
+    updates_lock(u);
+    UpdateEntry* entries = u->entries;
+    u->entries = NULL;
+    u->count = 0;
+    u->capacity = 0;
+    updates_unlock(u);
+    free(entries);
+    free(u->out);
+    u->out = NULL;
+
+    if (u->keys_ref != LUA_NOREF) {
+        luaL_unref(L, LUA_REGISTRYINDEX, u->keys_ref);
+        u->keys_ref = LUA_NOREF;
+    }
+    return 0;
+}
+
+static int Updates_tostring(lua_State* L) {
+    UpdatesUD* u = (UpdatesUD*)luaL_checkudata(L, 1, UPDATES_MT);
+    lua_pushfstring(L, "Updates(keys=%d, pending=%d)", u->count, u->pending);
+    return 1;
+}
+
 // Register Qelem type
 static void register_qelem_type(lua_State* L) {
     // Create metatable
@@ -232,6 +662,29 @@ static void register_qelem_type(lua_State* L) {
 
     lua_pop(L, 1);  // Pop metatable
 
+    // Updates metatable
+    luaL_newmetatable(L, UPDATES_MT);
+
+    lua_pushcfunction(L, Updates_set);
+    lua_setfield(L, -2, "set");
+
+    lua_pushcfunction(L, Updates_interval);
+    lua_setfield(L, -2, "interval");
+
+    lua_pushcfunction(L, Updates_stats);
+    lua_setfield(L, -2, "stats");
+
+    lua_pushcfunction(L, Updates_gc);
+    lua_setfield(L, -2, "__gc");
+
+    lua_pushcfunction(L, Updates_tostring);
+    lua_setfield(L, -2, "__tostring");
+
+    lua_pushvalue(L, -1);
+    lua_setfield(L, -2, "__index");
+
+    lua_pop(L, 1);  // Pop metatable
+
     // Register constructor in api module
     lua_getglobal(L, "api");
     if (!lua_istable(L, -1)) {
@@ -244,6 +697,9 @@ static void register_qelem_type(lua_State* L) {
     lua_pushcfunction(L, Qelem_new);
     lua_setfield(L, -2, "Qelem");
 
+    lua_pushcfunction(L, Updates_new);
+    lua_setfield(L, -2, "Updates");
+
     lua_pop(L, 1);  // Pop api table
 }
 
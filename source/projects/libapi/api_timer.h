@@ -0,0 +1,533 @@
+// api_timer.h
+// Timer wheel for luajit-max API
+// Many scheduled Lua callbacks on one Max clock per state
+
+#ifndef LUAJIT_API_TIMER_H
+#define LUAJIT_API_TIMER_H
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "api_common.h"
+#include "api_mailbox.h"
+#include "api_time.h"
+#include "api_timer_wheel.h"
+
+// ----------------------------------------------------------------------------
+// Every api.Clock owns a Max clock and a callback bridge. For patches that keep
+// thousands of events pending, api.schedule() puts them in a hierarchical
+// timing wheel instead (api_timer_wheel.h, 1 ms per tick) driven by a single
+// Max clock: the clock is armed for the next occupied slot; when it fires,
+// every event due by then is collected into one batch and called in due order.
+//
+// The wheel is created on first use and stored in the registry. In luajit~ and
+// luajit.stk~ its clock goes through the engine mailbox like any Clock.
+// An event holds either a callback function or a sleeping task (see Tasks).
+
+#define TIMER_RESOLUTION_MS 1.0
+
+#define TIMER_MT "luajit.timer_wheel"
+#define TIMER_KEY "luajit.timer_wheel"
+#define TIMER_CALLBACKS_KEY "luajit.timer_callbacks"
+#define TIMER_STATE_KEY "luajit.timer_state"     // main lua_State, callbacks run there
+#define TASKS_KEY "luajit.tasks"                  // thread -> logical time (ms)
+#define TASK_EVENTS_KEY "luajit.task_events"      // thread -> pending event id
+
+typedef struct {
+    TimerWheel wheel;
+    double origin;          // scheduler time of tick 0
+    double armed;           // scheduler time the clock is set for, -1 if unset
+
+    t_clock* clock;
+    lua_State* L;
+    LuaMailbox* mailbox;
+    int mailbox_slot;
+    unsigned int mailbox_gen;
+
+    unsigned long fired;
+    int max_batch;
+} LuaTimer;
+
+static double timer_clock_now(void) {
+    double t;
+    clock_getftime(&t);
+    return t;
+}
+
+// ----------------------------------------------------------------------------
+// Clock
+
+// Set the clock for the next tick with work, unless it is already set earlier
+static void timer_arm(LuaTimer* t) {
+    uint64_t tick = timer_next_tick(&t->wheel);
+    if (tick == UINT64_MAX) {
+        if (t->armed >= 0.0) {
+            clock_unset(t->clock);
+            t->armed = -1.0;
+        }
+        return;
+    }
+    double when = t->origin + (double)tick * TIMER_RESOLUTION_MS;
+    if (t->armed >= 0.0 && t->armed <= when) {
+        return;
+    }
+    double delay = when - timer_clock_now();
+    clock_fdelay(t->clock, delay > 0.0 ? delay : 0.0);
+    t->armed = when;
+}
+
+static void task_wake(lua_State* L, double due_ms);
+
+// Run the due batch (on the thread that holds the Lua state)
+static void timer_run(void* p) {
+    LuaTimer* t = (LuaTimer*)p;
+    TimerWheel* w = &t->wheel;
+    lua_State* L = t->L;
+    t->armed = -1.0;
+
+    // The clock fires at a tick boundary; allow for rounding below it
+    double elapsed = (timer_clock_now() - t->origin) / TIMER_RESOLUTION_MS + 1e-6;
+    if (elapsed >= 0.0) {
+        timer_advance(w, (uint64_t)elapsed);
+    }
+
+    lua_getfield(L, LUA_REGISTRYINDEX, TIMER_CALLBACKS_KEY);
+    int callbacks = lua_gettop(L);
+    int batch = 0;
+
+    // Callbacks may schedule (into the wheel) or cancel (also from the batch)
+    while (w->heads[TIMER_BATCH_LIST] >= 0) {
+        int i = w->heads[TIMER_BATCH_LIST];
+        double due_ms = w->events[i].due_ms;
+        lua_rawgeti(L, callbacks, i);
+        lua_pushnil(L);
+        lua_rawseti(L, callbacks, i);
+        timer_release(w, i);
+        t->fired++;
+        batch++;
+
+        if (lua_isthread(L, -1)) {
+            task_wake(L, due_ms);
+            continue;
+        }
+        lua_pushnumber(L, due_ms);
+        if (lua_pcall(L, 1, 0, 0) != LUA_OK) {
+            const char* err = lua_tostring(L, -1);
+            api_error_any("Timer callback error: %s", err);
+            lua_pop(L, 1);
+        }
+    }
+    lua_pop(L, 1);  // Pop callbacks table
+
+    if (batch > t->max_batch) {
+        t->max_batch = batch;
+    }
+    timer_arm(t);
+}
+
+// Called by the Max scheduler
+static void timer_clock_bridge(LuaTimer* t) {
+    if (t == NULL) {
+        return;
+    }
+    mailbox_dispatch(t->mailbox, t->mailbox_slot, t->mailbox_gen, timer_run, t);
+}
+
+// ----------------------------------------------------------------------------
+// Per-state wheel
+
+static int timer_gc(lua_State* L) {
+    LuaTimer* t = (LuaTimer*)luaL_checkudata(L, 1, TIMER_MT);
+    if (t->clock) {
+        clock_unset(t->clock);
+        freeobject((t_object*)t->clock);
+        t->clock = NULL;
+    }
+    if (t->mailbox) {
+        mailbox_remove_source(t->mailbox, t->mailbox_slot);
+        t->mailbox = NULL;
+    }
+    timer_wheel_free(&t->wheel);
+    return 0;
+}
+
+static LuaTimer* timer_get(lua_State* L) {
+    lua_getfield(L, LUA_REGISTRYINDEX, TIMER_KEY);
+    LuaTimer* t = (LuaTimer*)lua_touserdata(L, -1);
+    lua_pop(L, 1);
+    if (t) {
+        return t;
+    }
+
+    t = (LuaTimer*)lua_newuserdata(L, sizeof(LuaTimer));
+    memset(t, 0, sizeof(LuaTimer));
+    t->mailbox = mailbox_get(L);
+    t->mailbox_slot = -1;
+    if (t->mailbox) {
+        t->mailbox_slot = mailbox_add_source(t->mailbox, timer_run, t, &t->mailbox_gen);
+        if (t->mailbox_slot < 0) {
+            luaL_error(L, "timer: too many clocks and qelems (max %d)", MAILBOX_MAX_SOURCES);
+        }
+    }
+    timer_wheel_init(&t->wheel);
+    t->armed = -1.0;
+    t->origin = timer_clock_now();
+
+    // Not L itself: the first schedule may come from a coroutine
+    lua_getfield(L, LUA_REGISTRYINDEX, TIMER_STATE_KEY);
+    t->L = (lua_State*)lua_touserdata(L, -1);
+    lua_pop(L, 1);
+    t->clock = clock_new(t, (method)timer_clock_bridge);
+
+    luaL_getmetatable(L, TIMER_MT);
+    lua_setmetatable(L, -2);
+    lua_setfield(L, LUA_REGISTRYINDEX, TIMER_KEY);
+
+    lua_newtable(L);
+    lua_setfield(L, LUA_REGISTRYINDEX, TIMER_CALLBACKS_KEY);
+    return t;
+}
+
+// Queue the value at (absolute) index value_idx for scheduler time when_ms.
+// Returns the event id, or 0 when the pool is exhausted.
+static double timer_add(lua_State* L, double when_ms, int value_idx) {
+    LuaTimer* t = timer_get(L);
+    TimerWheel* w = &t->wheel;
+    if (w->count == 0) {
+        // Nothing pending: jump to the present instead of walking idle ticks
+        double elapsed = (timer_clock_now() - t->origin) / TIMER_RESOLUTION_MS;
+        if (elapsed > (double)w->now) {
+            timer_set_now(w, (uint64_t)elapsed);
+        }
+    }
+
+    int i = timer_alloc(w);
+    if (i < 0) {
+        return 0.0;
+    }
+    double tick = ceil((when_ms - t->origin) / TIMER_RESOLUTION_MS);
+    w->events[i].due = tick > 0.0 ? (uint64_t)tick : 0;
+    w->events[i].due_ms = when_ms;
+    timer_place(w, i);
+
+    lua_getfield(L, LUA_REGISTRYINDEX, TIMER_CALLBACKS_KEY);
+    lua_pushvalue(L, value_idx);
+    lua_rawseti(L, -2, i);
+    lua_pop(L, 1);
+
+    timer_arm(t);
+    return timer_event_id(w, i);
+}
+
+// Like timer_add(), pushing the id or raising an error
+static int timer_schedule(lua_State* L, double when_ms, int value_idx) {
+    double id = timer_add(L, when_ms, value_idx);
+    if (id == 0.0) {
+        return luaL_error(L, "schedule: too many pending events");
+    }
+    lua_pushnumber(L, id);
+    return 1;
+}
+
+static bool timer_cancel(lua_State* L, double id) {
+    lua_getfield(L, LUA_REGISTRYINDEX, TIMER_KEY);
+    LuaTimer* t = (LuaTimer*)lua_touserdata(L, -1);
+    lua_pop(L, 1);
+
+    int i = t ? timer_lookup(&t->wheel, id) : -1;
+    if (i < 0) {
+        return false;
+    }
+    lua_getfield(L, LUA_REGISTRYINDEX, TIMER_CALLBACKS_KEY);
+    lua_pushnil(L);
+    lua_rawseti(L, -2, i);
+    lua_pop(L, 1);
+    timer_release(&t->wheel, i);
+    return true;
+}
+
+// Optional ITM argument: Max.ITM userdata, or the global transport
+static t_itm* timer_check_itm(lua_State* L, int idx) {
+    if (lua_isnoneornil(L, idx)) {
+        return (t_itm*)itm_getglobal();
+    }
+    ITMUD* ud = (ITMUD*)luaL_checkudata(L, idx, ITM_MT);
+    return ud->itm;
+}
+
+// api.schedule(ms, fn) -> id
+// fn(due_ms) runs ms from now; due_ms is the scheduler time it was due at
+static int api_schedule(lua_State* L) {
+    double ms = luaL_checknumber(L, 1);
+    luaL_checktype(L, 2, LUA_TFUNCTION);
+    return timer_schedule(L, timer_clock_now() + (ms > 0.0 ? ms : 0.0), 2);
+}
+
+// api.schedule_at(time_ms, fn) -> id
+// Absolute scheduler time, e.g. due_ms + period from inside a callback
+static int api_schedule_at(lua_State* L) {
+    double when = luaL_checknumber(L, 1);
+    luaL_checktype(L, 2, LUA_TFUNCTION);
+    return timer_schedule(L, when, 2);
+}
+
+// api.schedule_ticks(ticks, fn [, itm]) -> id
+// Delay in transport ticks (480 per quarter note) of the global or given ITM,
+// converted at the current tempo
+static int api_schedule_ticks(lua_State* L) {
+    double ticks = luaL_checknumber(L, 1);
+    luaL_checktype(L, 2, LUA_TFUNCTION);
+
+    t_itm* itm = timer_check_itm(L, 3);
+    if (!itm) {
+        return luaL_error(L, "schedule_ticks: ITM is null");
+    }
+
+    double ms = itm_tickstoms(itm, ticks);
+    return timer_schedule(L, timer_clock_now() + (ms > 0.0 ? ms : 0.0), 2);
+}
+
+// api.cancel(id) -> true if the event was still pending
+static int api_cancel(lua_State* L) {
+    double id = luaL_checknumber(L, 1);
+    lua_pushboolean(L, timer_cancel(L, id));
+    return 1;
+}
+
+// api.timer_stats([reset]) -> pending, fired, max_batch
+static int api_timer_stats(lua_State* L) {
+    lua_getfield(L, LUA_REGISTRYINDEX, TIMER_KEY);
+    LuaTimer* t = (LuaTimer*)lua_touserdata(L, -1);
+    lua_pop(L, 1);
+    if (!t) {
+        lua_pushinteger(L, 0);
+        lua_pushnumber(L, 0);
+        lua_pushinteger(L, 0);
+        return 3;
+    }
+    lua_pushinteger(L, t->wheel.count);
+    lua_pushnumber(L, (lua_Number)t->fired);
+    lua_pushinteger(L, t->max_batch);
+    if (lua_toboolean(L, 1)) {
+        t->fired = 0;
+        t->max_batch = 0;
+    }
+    return 3;
+}
+
+// ----------------------------------------------------------------------------
+// Tasks
+//
+// api.spawn(fn, ...) runs fn as a coroutine until it calls api.sleep(ms) or
+// api.wait_ticks(ticks), which put the coroutine itself in the wheel and
+// yield: a sequencing loop allocates no closure or Clock per step. Sleeps are
+// measured from the task's logical time (the due time of its last wakeup), so
+// a loop of sleeps does not drift; after a stall longer than the sleep, the
+// task resumes at once instead of catching up on missed steps.
+
+// key[thread at index t] = top of the stack (popped)
+static void task_store(lua_State* L, const char* key, int t) {
+    lua_getfield(L, LUA_REGISTRYINDEX, key);
+    lua_pushvalue(L, t);
+    lua_pushvalue(L, -3);
+    lua_rawset(L, -3);
+    lua_pop(L, 2);
+}
+
+// Push key[thread at index t]
+static void task_load(lua_State* L, const char* key, int t) {
+    lua_getfield(L, LUA_REGISTRYINDEX, key);
+    lua_pushvalue(L, t);
+    lua_rawget(L, -2);
+    lua_remove(L, -2);
+}
+
+static void task_forget(lua_State* L, int t) {
+    lua_pushnil(L);
+    task_store(L, TASKS_KEY, t);
+    lua_pushnil(L);
+    task_store(L, TASK_EVENTS_KEY, t);
+}
+
+// Resume the task at index t with nargs values already on its stack
+static void task_resume(lua_State* L, int t, int nargs) {
+    lua_State* co = lua_tothread(L, t);
+    int status = lua_resume(co, nargs);
+
+    if (status == LUA_YIELD) {
+        lua_settop(co, 0);
+        task_load(L, TASKS_KEY, t);
+        bool killed = lua_isnil(L, -1);     // by another task while it ran
+        lua_pop(L, 1);
+        task_load(L, TASK_EVENTS_KEY, t);
+        bool sleeping = !lua_isnil(L, -1);
+        double id = lua_tonumber(L, -1);
+        lua_pop(L, 1);
+        if (killed) {
+            if (sleeping) {
+                timer_cancel(L, id);
+            }
+            task_forget(L, t);
+            return;
+        }
+        if (sleeping) {
+            return;
+        }
+        // A plain coroutine.yield(): continue on the next tick
+        id = timer_add(L, timer_clock_now(), t);
+        if (id != 0.0) {
+            lua_pushnumber(L, id);
+            task_store(L, TASK_EVENTS_KEY, t);
+            return;
+        }
+        api_error_any("Task dropped: too many pending events");
+    } else if (status != LUA_OK) {
+        const char* err = lua_tostring(co, -1);
+        api_error_any("Task error: %s", err);
+    }
+    task_forget(L, t);
+}
+
+// From timer_run(): the task on top of the stack is due (popped)
+static void task_wake(lua_State* L, double due_ms) {
+    int t = lua_gettop(L);
+    lua_pushnil(L);
+    task_store(L, TASK_EVENTS_KEY, t);
+    lua_pushnumber(L, due_ms);
+    task_store(L, TASKS_KEY, t);
+
+    lua_pushnumber(lua_tothread(L, t), due_ms);   // returned by sleep()
+    task_resume(L, t, 1);
+    lua_pop(L, 1);
+}
+
+static int task_sleep(lua_State* L, double ms) {
+    lua_pushthread(L);
+    int t = lua_gettop(L);
+    task_load(L, TASKS_KEY, t);
+    if (lua_isnil(L, -1)) {
+        return luaL_error(L, "sleep: not called from a task started with api.spawn()");
+    }
+    double when = lua_tonumber(L, -1) + (ms > 0.0 ? ms : 0.0);
+    lua_pop(L, 1);
+
+    double now = timer_clock_now();
+    timer_schedule(L, when > now ? when : now, t);
+    task_store(L, TASK_EVENTS_KEY, t);
+    return lua_yield(L, 0);
+}
+
+// api.spawn(fn, ...) -> task
+// Runs fn(...) now, up to its first sleep
+static int api_spawn(lua_State* L) {
+    luaL_checktype(L, 1, LUA_TFUNCTION);
+    int nargs = lua_gettop(L) - 1;
+
+    lua_State* co = lua_newthread(L);
+    int t = lua_gettop(L);
+    lua_pushnumber(L, timer_clock_now());
+    task_store(L, TASKS_KEY, t);
+
+    for (int i = 1; i <= nargs + 1; i++) {
+        lua_pushvalue(L, i);
+    }
+    lua_xmove(L, co, nargs + 1);
+    task_resume(L, t, nargs);
+
+    lua_settop(L, t);
+    return 1;
+}
+
+// api.sleep(ms) -> due_ms
+// Inside a task: suspend for ms, measured from the task's logical time
+static int api_sleep(lua_State* L) {
+    return task_sleep(L, luaL_checknumber(L, 1));
+}
+
+// api.wait_ticks(ticks [, itm]) -> due_ms
+// Inside a task: suspend for transport ticks at the current tempo
+static int api_wait_ticks(lua_State* L) {
+    double ticks = luaL_checknumber(L, 1);
+    t_itm* itm = timer_check_itm(L, 2);
+    if (!itm) {
+        return luaL_error(L, "wait_ticks: ITM is null");
+    }
+    return task_sleep(L, itm_tickstoms(itm, ticks));
+}
+
+// api.kill(task) -> true if the task was still alive
+static int api_kill(lua_State* L) {
+    luaL_checktype(L, 1, LUA_TTHREAD);
+    if (lua_tothread(L, 1) == L) {
+        return luaL_error(L, "kill: a task cannot kill itself, return from it instead");
+    }
+
+    task_load(L, TASKS_KEY, 1);
+    bool alive = !lua_isnil(L, -1);
+    lua_pop(L, 1);
+
+    task_load(L, TASK_EVENTS_KEY, 1);
+    if (lua_isnumber(L, -1)) {
+        timer_cancel(L, lua_tonumber(L, -1));
+    }
+    lua_pop(L, 1);
+
+    task_forget(L, 1);
+    lua_pushboolean(L, alive);
+    return 1;
+}
+
+static void register_timer_functions(lua_State* L) {
+    lua_pushlightuserdata(L, L);
+    lua_setfield(L, LUA_REGISTRYINDEX, TIMER_STATE_KEY);
+
+    lua_newtable(L);
+    lua_setfield(L, LUA_REGISTRYINDEX, TASKS_KEY);
+    lua_newtable(L);
+    lua_setfield(L, LUA_REGISTRYINDEX, TASK_EVENTS_KEY);
+
+    luaL_newmetatable(L, TIMER_MT);
+    lua_pushcfunction(L, timer_gc);
+    lua_setfield(L, -2, "__gc");
+    lua_pop(L, 1);  // Pop metatable
+
+    lua_getglobal(L, "api");
+    if (!lua_istable(L, -1)) {
+        lua_pop(L, 1);
+        lua_newtable(L);
+        lua_pushvalue(L, -1);
+        lua_setglobal(L, "api");
+    }
+
+    lua_pushcfunction(L, api_schedule);
+    lua_setfield(L, -2, "schedule");
+
+    lua_pushcfunction(L, api_schedule_at);
+    lua_setfield(L, -2, "schedule_at");
+
+    lua_pushcfunction(L, api_schedule_ticks);
+    lua_setfield(L, -2, "schedule_ticks");
+
+    lua_pushcfunction(L, api_cancel);
+    lua_setfield(L, -2, "cancel");
+
+    lua_pushcfunction(L, api_timer_stats);
+    lua_setfield(L, -2, "timer_stats");
+
+    lua_pushcfunction(L, api_spawn);
+    lua_setfield(L, -2, "spawn");
+
+    lua_pushcfunction(L, api_sleep);
+    lua_setfield(L, -2, "sleep");
+
+    lua_pushcfunction(L, api_wait_ticks);
+    lua_setfield(L, -2, "wait_ticks");
+
+    lua_pushcfunction(L, api_kill);
+    lua_setfield(L, -2, "kill");
+
+    lua_pop(L, 1);  // Pop api table
+}
+
+#endif // LUAJIT_API_TIMER_H
@@ -0,0 +1,283 @@
+// api_timer_wheel.h
+// Hierarchical timing wheel behind api.schedule()
+// Plain C with no Max or Lua dependency, so it can be tested on its own
+
+#ifndef LUAJIT_API_TIMER_WHEEL_H
+#define LUAJIT_API_TIMER_WHEEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ----------------------------------------------------------------------------
+// 4 levels of 256 slots, one tick per slot at level 0 (~49 days of range at
+// 1 ms per tick):
+//
+//   - schedule and cancel are O(1): an event is linked into the slot of its
+//     due tick, relative to the wheel's current tick
+//   - when a level-0 rotation completes, the next slot of level 1 is cascaded
+//     down (and so on up), so an event moves at most three times
+//   - timer_advance() moves every event due by a tick into the batch list,
+//     in due order
+//
+// Invariant: every slot has been cascaded up to and including w->now, so all
+// events are placed relative to it and timer_next_tick() can search each
+// level from the slot after the current one.
+
+#define TIMER_LEVELS 4
+#define TIMER_SLOT_BITS 8
+#define TIMER_SLOTS (1 << TIMER_SLOT_BITS)
+#define TIMER_MASK (TIMER_SLOTS - 1)
+#define TIMER_BATCH_LIST (TIMER_LEVELS * TIMER_SLOTS)   // due events, in order
+#define TIMER_MAX_EVENTS (1 << 24)
+#define TIMER_ID_SCALE 16777216.0                       // id = gen * scale + index
+
+typedef struct {
+    int prev, next;
+    int list;               // slot list index, TIMER_BATCH_LIST, or -1 when free
+    uint64_t due;           // tick
+    double due_ms;          // scheduler time passed to the callback
+    unsigned int gen;       // bumped on every reuse, part of the id
+} TimerEvent;
+
+typedef struct {
+    TimerEvent* events;     // pool; free entries chained through next
+    int capacity;
+    int free_head;
+    int count;              // events in the wheel or the batch
+
+    int heads[TIMER_BATCH_LIST + 1];
+    int tails[TIMER_BATCH_LIST + 1];
+    uint32_t occupied[TIMER_LEVELS][TIMER_SLOTS / 32];
+
+    uint64_t now;           // first tick not yet processed
+} TimerWheel;
+
+static void timer_wheel_init(TimerWheel* w) {
+    memset(w, 0, sizeof(TimerWheel));
+    for (int i = 0; i <= TIMER_BATCH_LIST; i++) {
+        w->heads[i] = -1;
+        w->tails[i] = -1;
+    }
+    w->free_head = -1;
+}
+
+static void timer_wheel_free(TimerWheel* w) {
+    free(w->events);
+    w->events = NULL;
+    w->capacity = 0;
+}
+
+// ----------------------------------------------------------------------------
+// Lists and slots
+
+static void timer_link(TimerWheel* w, int list, int i) {
+    TimerEvent* e = &w->events[i];
+    e->list = list;
+    e->next = -1;
+    e->prev = w->tails[list];
+    if (e->prev >= 0) {
+        w->events[e->prev].next = i;
+    } else {
+        w->heads[list] = i;
+    }
+    w->tails[list] = i;
+    if (list < TIMER_BATCH_LIST) {
+        w->occupied[list / TIMER_SLOTS][(list & TIMER_MASK) >> 5] |= 1u << (list & 31);
+    }
+}
+
+static void timer_unlink(TimerWheel* w, int i) {
+    TimerEvent* e = &w->events[i];
+    int list = e->list;
+    if (e->prev >= 0) {
+        w->events[e->prev].next = e->next;
+    } else {
+        w->heads[list] = e->next;
+    }
+    if (e->next >= 0) {
+        w->events[e->next].prev = e->prev;
+    } else {
+        w->tails[list] = e->prev;
+    }
+    if (list < TIMER_BATCH_LIST && w->heads[list] < 0) {
+        w->occupied[list / TIMER_SLOTS][(list & TIMER_MASK) >> 5] &= ~(1u << (list & 31));
+    }
+    e->list = -1;
+}
+
+// Put an event in the slot for its due tick, relative to w->now
+static void timer_place(TimerWheel* w, int i) {
+    TimerEvent* e = &w->events[i];
+    if (e->due < w->now) {
+        e->due = w->now;
+    }
+    uint64_t delta = e->due - w->now;
+    int level = 0;
+    while (level < TIMER_LEVELS - 1 && delta >= ((uint64_t)1 << (TIMER_SLOT_BITS * (level + 1)))) {
+        level++;
+    }
+    uint64_t due = e->due;
+    if (level == TIMER_LEVELS - 1 && delta >> (TIMER_SLOT_BITS * TIMER_LEVELS)) {
+        due = w->now + ((uint64_t)1 << (TIMER_SLOT_BITS * TIMER_LEVELS)) - 1;  // clamp to range
+    }
+    int slot = (int)((due >> (TIMER_SLOT_BITS * level)) & TIMER_MASK);
+    timer_link(w, level * TIMER_SLOTS + slot, i);
+}
+
+// First occupied slot in [from, TIMER_SLOTS) of a level, or -1
+static int timer_find_slot(TimerWheel* w, int level, int from) {
+    for (int word = from >> 5; word < TIMER_SLOTS / 32; word++) {
+        uint32_t bits = w->occupied[level][word];
+        if (word == from >> 5) {
+            bits &= ~0u << (from & 31);
+        }
+        if (bits) {
+            int bit = 0;
+            while (!(bits & (1u << bit))) {
+                bit++;
+            }
+            return word * 32 + bit;
+        }
+    }
+    return -1;
+}
+
+static bool timer_level_empty(TimerWheel* w, int level) {
+    for (int word = 0; word < TIMER_SLOTS / 32; word++) {
+        if (w->occupied[level][word]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Earliest tick at which the wheel has work: a due level-0 slot or a cascade.
+// May be early (a wrap with nothing due), never late. UINT64_MAX when empty.
+static uint64_t timer_next_tick(TimerWheel* w) {
+    for (int level = 0; level < TIMER_LEVELS; level++) {
+        int shift = TIMER_SLOT_BITS * level;
+        int idx = (int)((w->now >> shift) & TIMER_MASK);
+        // The current upper slot was cascaded when w->now reached it
+        int from = level == 0 ? idx : idx + 1;
+        int found = from < TIMER_SLOTS ? timer_find_slot(w, level, from) : -1;
+        uint64_t base = (w->now >> (shift + TIMER_SLOT_BITS)) << (shift + TIMER_SLOT_BITS);
+        if (found >= 0) {
+            return base + ((uint64_t)found << shift);
+        }
+        if (!timer_level_empty(w, level)) {
+            return base + ((uint64_t)1 << (shift + TIMER_SLOT_BITS));   // after this level wraps
+        }
+    }
+    return UINT64_MAX;
+}
+
+static void timer_cascade(TimerWheel* w, int level, int slot) {
+    int list = level * TIMER_SLOTS + slot;
+    int i = w->heads[list];
+    while (i >= 0) {
+        int next = w->events[i].next;
+        timer_unlink(w, i);
+        timer_place(w, i);
+        i = next;
+    }
+}
+
+// Move the wheel to tick n (forward only). Reaching a rotation boundary
+// cascades the upper slots it opens, keeping the invariant above.
+static void timer_set_now(TimerWheel* w, uint64_t n) {
+    w->now = n;
+    if ((n & TIMER_MASK) != 0 || n == 0) {
+        return;
+    }
+    for (int level = 1; level < TIMER_LEVELS; level++) {
+        int slot = (int)((n >> (TIMER_SLOT_BITS * level)) & TIMER_MASK);
+        timer_cascade(w, level, slot);
+        if (slot != 0) {
+            break;
+        }
+    }
+}
+
+// Move every event due at or before target into the batch list
+static void timer_advance(TimerWheel* w, uint64_t target) {
+    while (w->now <= target) {
+        uint64_t n = w->now;
+        int idx = (int)(n & TIMER_MASK);
+
+        // Skip to the end of the rotation when level 0 has nothing left in it
+        if (timer_find_slot(w, 0, idx) < 0) {
+            uint64_t wrap = (n | TIMER_MASK) + 1;
+            timer_set_now(w, wrap <= target ? wrap : target + 1);
+            continue;
+        }
+
+        int i = w->heads[idx];
+        while (i >= 0) {
+            int next = w->events[i].next;
+            timer_unlink(w, i);
+            timer_link(w, TIMER_BATCH_LIST, i);
+            i = next;
+        }
+        timer_set_now(w, n + 1);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Event pool
+
+static int timer_alloc(TimerWheel* w) {
+    if (w->free_head < 0) {
+        int capacity = w->capacity ? w->capacity * 2 : 256;
+        if (capacity > TIMER_MAX_EVENTS) {
+            return -1;
+        }
+        TimerEvent* events = (TimerEvent*)realloc(w->events, sizeof(TimerEvent) * (size_t)capacity);
+        if (!events) {
+            return -1;
+        }
+        for (int i = w->capacity; i < capacity; i++) {
+            events[i].list = -1;
+            events[i].gen = 1;
+            events[i].next = i + 1 < capacity ? i + 1 : -1;
+        }
+        w->free_head = w->capacity;
+        w->events = events;
+        w->capacity = capacity;
+    }
+    int i = w->free_head;
+    w->free_head = w->events[i].next;
+    w->count++;
+    return i;
+}
+
+static void timer_release(TimerWheel* w, int i) {
+    if (w->events[i].list >= 0) {
+        timer_unlink(w, i);
+    }
+    w->events[i].gen++;
+    w->events[i].next = w->free_head;
+    w->free_head = i;
+    w->count--;
+}
+
+static double timer_event_id(TimerWheel* w, int i) {
+    return (double)w->events[i].gen * TIMER_ID_SCALE + (double)i;
+}
+
+// Index of a pending event, or -1 for a stale or bogus id
+static int timer_lookup(TimerWheel* w, double id) {
+    if (id < TIMER_ID_SCALE) {
+        return -1;
+    }
+    uint64_t bits = (uint64_t)id;
+    int i = (int)(bits & (TIMER_MAX_EVENTS - 1));
+    unsigned int gen = (unsigned int)(bits >> 24);
+    if (i >= w->capacity || w->events[i].list < 0 || w->events[i].gen != gen) {
+        return -1;
+    }
+    return i;
+}
+
+#endif // LUAJIT_API_TIMER_WHEEL_H
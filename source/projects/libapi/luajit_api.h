@@ -9,6 +9,7 @@
 #include "api_common.h"
 
 // Include API wrappers
+#include "api_mailbox.h"
 #include "api_symbol.h"
 #include "api_atom.h"
 #include "api_clock.h"
@@ -29,6 +30,7 @@
 #include "api_preset.h"
 #include "api_qelem.h"
 #include "api_linklist.h"
+#include "api_timer.h"
 
 // Forward declarations for future API modules
 
@@ -37,13 +39,13 @@
 
 static int api_post(lua_State* L) {
     const char* msg = luaL_checkstring(L, 1);
-    post("%s", msg);
+    api_post_any("%s", msg);
     return 0;
 }
 
 static int api_error(lua_State* L) {
     const char* msg = luaL_checkstring(L, 1);
-    error("%s", msg);
+    api_error_any("%s", msg);
     return 0;
 }
 
@@ -87,6 +89,8 @@ static void luajit_api_init(lua_State* L) {
     register_preset_type(L);
     register_qelem_type(L);
     register_linklist_type(L);
+    register_mailbox_functions(L);
+    register_timer_functions(L);
 
     // Register OutletWrapper type (for injection in luajit external)
     register_outlet_wrapper_type(L);
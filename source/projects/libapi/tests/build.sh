@@ -0,0 +1,3 @@
+
+# timer wheel against a reference list: ./test_timer_wheel [steps] [seed]
+gcc -std=c99 -O2 -Wall -I.. -o test_timer_wheel test_timer_wheel.c
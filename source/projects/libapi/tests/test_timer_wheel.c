@@ -0,0 +1,234 @@
+// test_timer_wheel.c
+// Randomised test of the api.schedule() timer wheel against a reference list
+//
+// Schedules, cancels and advances the wheel the way api_timer.h drives it
+// (advance to the tick the clock was armed for, or to an earlier one when the
+// clock fires late or the wheel is re-armed) and checks after every step:
+//
+//   - timer_next_tick() is never later than the earliest pending event
+//   - timer_advance() moves exactly the events due by the target into the
+//     batch, in due order
+//   - cancelled and fired ids no longer resolve
+//
+// Usage: ./test_timer_wheel [steps] [seed]
+// Exits non-zero on the first mismatch.
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "api_timer_wheel.h"
+
+#define MAX_PENDING 4096
+
+typedef struct {
+    double id;
+    uint64_t due;
+} RefEvent;
+
+static RefEvent pending[MAX_PENDING];
+static int npending;
+static uint64_t rng_state;
+
+static uint64_t rng(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static int fail(const char* what, uint64_t now, uint64_t a, uint64_t b) {
+    fprintf(stderr, "FAIL: %s (now %" PRIu64 ": %" PRIu64 " vs %" PRIu64 ")\n", what, now, a, b);
+    return 1;
+}
+
+// Delays spread over every level, with some in the past and on boundaries
+static uint64_t random_due(uint64_t now) {
+    switch (rng() % 8) {
+    case 0: return now > 10 ? now - rng() % 10 : 0;
+    case 1: return now + rng() % 4;
+    case 2:
+    case 3: return now + rng() % TIMER_SLOTS;
+    case 4: return ((now >> 8) + 1 + rng() % 4) << 8;
+    case 5: return now + rng() % ((uint64_t)1 << 16);
+    case 6: return now + rng() % ((uint64_t)1 << 20);
+    default: return now + rng() % ((uint64_t)1 << 25);
+    }
+}
+
+static uint64_t earliest_pending(void) {
+    uint64_t t = UINT64_MAX;
+    for (int k = 0; k < npending; k++) {
+        if (pending[k].due < t) {
+            t = pending[k].due;
+        }
+    }
+    return t;
+}
+
+static int schedule(TimerWheel* w) {
+    if (npending == MAX_PENDING) {
+        return 0;
+    }
+    int i = timer_alloc(w);
+    if (i < 0) {
+        return fail("alloc", w->now, 0, 0);
+    }
+    uint64_t due = random_due(w->now);
+    w->events[i].due = due;
+    w->events[i].due_ms = (double)due;
+    timer_place(w, i);
+    pending[npending].id = timer_event_id(w, i);
+    pending[npending].due = due < w->now ? w->now : due;
+    npending++;
+    return 0;
+}
+
+static int cancel(TimerWheel* w) {
+    if (npending == 0) {
+        return 0;
+    }
+    int k = (int)(rng() % (uint64_t)npending);
+    double id = pending[k].id;
+    int i = timer_lookup(w, id);
+    if (i < 0) {
+        return fail("pending id does not resolve", w->now, (uint64_t)id, 0);
+    }
+    timer_release(w, i);
+    pending[k] = pending[--npending];
+    if (timer_lookup(w, id) >= 0) {
+        return fail("cancelled id still resolves", w->now, (uint64_t)id, 0);
+    }
+    return 0;
+}
+
+static int advance(TimerWheel* w) {
+    uint64_t next = timer_next_tick(w);
+    uint64_t first = earliest_pending();
+    if (npending == 0 && next != UINT64_MAX) {
+        return fail("empty wheel has a next tick", w->now, next, first);
+    }
+    if (next > first) {
+        return fail("next tick later than earliest event", w->now, next, first);
+    }
+    if (npending == 0) {
+        return 0;
+    }
+
+    // The clock fires at the armed tick, or the wheel is serviced earlier
+    uint64_t target = next;
+    if (rng() % 4 == 0 && next > w->now) {
+        target = w->now + rng() % (next - w->now + 1);
+    } else if (rng() % 8 == 0) {
+        target = next + rng() % 1000;   // late clock
+    }
+    timer_advance(w, target);
+    if (w->now != target + 1) {
+        return fail("now after advance", w->now, target + 1, 0);
+    }
+
+    uint64_t last = 0;
+    while (w->heads[TIMER_BATCH_LIST] >= 0) {
+        int i = w->heads[TIMER_BATCH_LIST];
+        uint64_t due = w->events[i].due;
+        double id = timer_event_id(w, i);
+        if (due > target) {
+            return fail("batch event not due", w->now, due, target);
+        }
+        if (due < last) {
+            return fail("batch out of order", w->now, due, last);
+        }
+        last = due;
+
+        int k = 0;
+        while (k < npending && pending[k].id != id) {
+            k++;
+        }
+        if (k == npending) {
+            return fail("batch event not pending", w->now, due, 0);
+        }
+        if (pending[k].due != due) {
+            return fail("batch event moved", w->now, due, pending[k].due);
+        }
+        pending[k] = pending[--npending];
+        timer_release(w, i);
+        if (timer_lookup(w, id) >= 0) {
+            return fail("fired id still resolves", w->now, (uint64_t)id, 0);
+        }
+    }
+    for (int k = 0; k < npending; k++) {
+        if (pending[k].due <= target) {
+            return fail("due event left in the wheel", w->now, pending[k].due, target);
+        }
+    }
+    return 0;
+}
+
+// The clock fired on tick 255: the 300 event must not wait for level 1 to wrap
+static int test_boundary(void) {
+    TimerWheel w;
+    timer_wheel_init(&w);
+    uint64_t dues[] = { 100, 300 };
+    for (int k = 0; k < 2; k++) {
+        int i = timer_alloc(&w);
+        w.events[i].due = dues[k];
+        timer_place(&w, i);
+    }
+    timer_advance(&w, 255);
+    uint64_t next = timer_next_tick(&w);
+    timer_wheel_free(&w);
+    if (next != 300) {
+        return fail("next tick after a rotation boundary", 256, next, 300);
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    long steps = argc > 1 ? atol(argv[1]) : 200000;
+    rng_state = argc > 2 ? strtoull(argv[2], NULL, 10) : 0x9e3779b97f4a7c15ull;
+    if (rng_state == 0) {
+        rng_state = 1;
+    }
+
+    if (test_boundary()) {
+        return 1;
+    }
+
+    TimerWheel w;
+    timer_wheel_init(&w);
+    for (long s = 0; s < steps; s++) {
+        int r;
+        uint64_t op = rng() % 16;
+        if (op < 7) {
+            r = schedule(&w);
+        } else if (op < 9) {
+            r = cancel(&w);
+        } else if (op < 15) {
+            r = advance(&w);
+        } else {
+            // timer_add() on an idle wheel jumps to the present
+            r = 0;
+            if (w.count == 0) {
+                timer_set_now(&w, w.now + rng() % ((uint64_t)1 << 18));
+            }
+        }
+        if (r) {
+            fprintf(stderr, "step %ld\n", s);
+            timer_wheel_free(&w);
+            return 1;
+        }
+    }
+    while (npending > 0) {
+        if (advance(&w)) {
+            timer_wheel_free(&w);
+            return 1;
+        }
+    }
+    if (w.count != 0) {
+        fprintf(stderr, "FAIL: %d events leaked\n", w.count);
+        return 1;
+    }
+    timer_wheel_free(&w);
+    printf("timer wheel: %ld steps ok, now %" PRIu64 "\n", steps, w.now);
+    return 0;
+}
@@ -0,0 +1,174 @@
+// bench_fastmath.c
+// Error report and speed benchmark for the libdsp fast math tiers
+//
+// For every function and tier: maximum absolute and relative error against
+// libm over a dense sweep of the range audio code uses, and ns per sample
+// through the block API next to the libm loop it replaces. pow is swept over
+// a grid of (x, y): x log-spaced, one block call per exponent.
+//
+// Usage: ./bench_fastmath [samples] > fastmath.csv
+// Output is CSV on stdout.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "libdsp.h"
+
+typedef double (*unary_fn)(double);
+typedef void (*block_fn)(const double*, double*, size_t, fastmath_tier);
+
+typedef struct {
+    const char* name;
+    unary_fn ref;
+    unary_fn tier[3];
+    block_fn block;
+    double lo, hi;          // sweep range
+    int relative;           // report relative error (values span decades)
+} fm_case;
+
+static double ref_db_to_gain(double db) { return pow(10.0, db / 20.0); }
+static double ref_gain_to_db(double g) { return 20.0 * log10(g); }
+
+static const fm_case cases[] = {
+    { "exp2", exp2, { fast_exp2_low, fast_exp2_med, fast_exp2_high }, fast_exp2_block, -20.0, 20.0, 1 },
+    { "log2", log2, { fast_log2_low, fast_log2_med, fast_log2_high }, fast_log2_block, 1e-6, 1e6, 0 },
+    { "sin", sin, { fast_sin_low, fast_sin_med, fast_sin_high }, fast_sin_block, -100.0, 100.0, 0 },
+    { "cos", cos, { fast_cos_low, fast_cos_med, fast_cos_high }, fast_cos_block, -100.0, 100.0, 0 },
+    { "tanh", tanh, { fast_tanh_low, fast_tanh_med, fast_tanh_high }, fast_tanh_block, -10.0, 10.0, 0 },
+    { "db_to_gain", ref_db_to_gain, { fast_db_to_gain_low, fast_db_to_gain_med, fast_db_to_gain_high },
+      fast_db_to_gain_block, -120.0, 24.0, 1 },
+    { "gain_to_db", ref_gain_to_db, { fast_gain_to_db_low, fast_gain_to_db_med, fast_gain_to_db_high },
+      fast_gain_to_db_block, 1e-6, 16.0, 0 },
+};
+
+// pow: x over [POW_LO, POW_HI], log-spaced, for each exponent
+#define POW_LO 1e-3
+#define POW_HI 1e3
+static const double pow_exponents[] = { -3.0, -1.5, -0.5, 0.25, 0.5, 1.5, 2.0, 3.0 };
+#define POW_EXPONENTS (sizeof(pow_exponents) / sizeof(pow_exponents[0]))
+
+typedef double (*binary_fn)(double, double);
+static const binary_fn pow_tiers[3] = { fast_pow_low, fast_pow_med, fast_pow_high };
+
+static const char* tier_names[] = { "low", "med", "high" };
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+// Sweep input: log-spaced for log2/gain_to_db, linear otherwise
+static void fill_input(const fm_case* c, double* in, size_t n)
+{
+    int logspace = c->lo > 0.0 && c->hi / c->lo > 1000.0;
+    for (size_t i = 0; i < n; i++) {
+        double t = (double)i / (double)(n - 1);
+        in[i] = logspace ? c->lo * pow(c->hi / c->lo, t) : c->lo + (c->hi - c->lo) * t;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    size_t n = argc > 1 ? (size_t)atol(argv[1]) : 1000000;
+    if (n < 2) {
+        fprintf(stderr, "usage: %s [samples]\n", argv[0]);
+        return 1;
+    }
+
+    double* in = (double*)malloc(sizeof(double) * n);
+    double* out = (double*)malloc(sizeof(double) * n);
+    if (!in || !out) {
+        return 1;
+    }
+
+    printf("function,tier,max_abs_err,max_rel_err,ns_per_sample,speedup,checksum\n");
+
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        const fm_case* fc = &cases[c];
+        fill_input(fc, in, n);
+
+        double t0 = now_ns();
+        for (size_t i = 0; i < n; i++) {
+            out[i] = fc->ref(in[i]);
+        }
+        double ref_ns = (now_ns() - t0) / (double)n;
+        double sum = 0.0;
+        for (size_t i = 0; i < n; i++) {
+            sum += out[i];
+        }
+        printf("%s,libm,0,0,%.3f,1.00,%.6g\n", fc->name, ref_ns, sum);
+
+        for (int tier = 0; tier < 3; tier++) {
+            double max_abs = 0.0, max_rel = 0.0;
+            for (size_t i = 0; i < n; i++) {
+                double r = fc->ref(in[i]);
+                double err = fabs(fc->tier[tier](in[i]) - r);
+                if (err > max_abs) max_abs = err;
+                if (r != 0.0 && err / fabs(r) > max_rel) max_rel = err / fabs(r);
+            }
+
+            t0 = now_ns();
+            fc->block(in, out, n, (fastmath_tier)tier);
+            double ns = (now_ns() - t0) / (double)n;
+            sum = 0.0;
+            for (size_t i = 0; i < n; i++) {
+                sum += out[i];
+            }
+
+            printf("%s,%s,%.3g,%.3g,%.3f,%.2f,%.6g\n", fc->name, tier_names[tier],
+                   max_abs, max_rel, ns, ref_ns / ns, sum);
+        }
+    }
+
+    // pow over the (x, y) grid; errors are relative since results span decades
+    const fm_case pow_sweep = { "pow", NULL, { NULL }, NULL, POW_LO, POW_HI, 1 };
+    fill_input(&pow_sweep, in, n);
+
+    double ref_ns = 0.0, sum = 0.0;
+    for (size_t k = 0; k < POW_EXPONENTS; k++) {
+        double t0 = now_ns();
+        for (size_t i = 0; i < n; i++) {
+            out[i] = pow(in[i], pow_exponents[k]);
+        }
+        ref_ns += now_ns() - t0;
+        for (size_t i = 0; i < n; i++) {
+            sum += out[i];
+        }
+    }
+    ref_ns /= (double)(n * POW_EXPONENTS);
+    printf("pow,libm,0,0,%.3f,1.00,%.6g\n", ref_ns, sum);
+
+    for (int tier = 0; tier < 3; tier++) {
+        double max_abs = 0.0, max_rel = 0.0;
+        double ns = 0.0;
+        sum = 0.0;
+        for (size_t k = 0; k < POW_EXPONENTS; k++) {
+            double y = pow_exponents[k];
+            for (size_t i = 0; i < n; i++) {
+                double r = pow(in[i], y);
+                double err = fabs(pow_tiers[tier](in[i], y) - r);
+                if (err > max_abs) max_abs = err;
+                if (err / r > max_rel) max_rel = err / r;
+            }
+
+            double t0 = now_ns();
+            fast_pow_block(in, out, n, y, (fastmath_tier)tier);
+            ns += now_ns() - t0;
+            for (size_t i = 0; i < n; i++) {
+                sum += out[i];
+            }
+        }
+        ns /= (double)(n * POW_EXPONENTS);
+
+        printf("pow,%s,%.3g,%.3g,%.3f,%.2f,%.6g\n", tier_names[tier],
+               max_abs, max_rel, ns, ref_ns / ns, sum);
+    }
+
+    free(in);
+    free(out);
+    return 0;
+}
@@ -1,3 +1,4 @@
-gcc -shared -fPIC -o libdsp.dylib libdsp.c
-
+gcc -shared -fPIC -O3 -fno-trapping-math -o libdsp.dylib libdsp.c dsp_fft.c dsp_filter.c dsp_scale.c dsp_wavetable.c dsp_additive.c dsp_convolve.c dsp_delay.c dsp_envelope.c dsp_reverb.c dsp_fastmath.c dsp_dispatch.c
 
+# fast math error report and benchmark: ./bench_fastmath [samples] > fastmath.csv
+gcc -O3 -fno-trapping-math -o bench_fastmath bench_fastmath.c libdsp.c dsp_fft.c dsp_filter.c dsp_scale.c dsp_wavetable.c dsp_additive.c dsp_convolve.c dsp_delay.c dsp_envelope.c dsp_reverb.c dsp_fastmath.c dsp_dispatch.c
@@ -0,0 +1,231 @@
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libdsp.h"
+#include "dsp_dispatch.h"
+
+//------------------------------------------------------------------------------
+// Additive Oscillator Bank
+//
+// Every partial is a phasor rotated by a fixed complex step each sample
+// (four multiplies, no sin()), stored structure-of-arrays so the dispatched
+// kernel advances DSP_ADDITIVE_LANES partials per instruction. Setters only
+// record targets; additive_process_block() turns amplitude changes into
+// per-sample ramps across the block, and partials at or above Nyquist ramp
+// to silence instead of aliasing.
+//------------------------------------------------------------------------------
+
+#define ADDITIVE_ALIGN 64
+
+struct dsp_additive {
+    size_t capacity;        // multiple of DSP_ADDITIVE_LANES
+    size_t count;           // partials in use (highest index set + 1)
+
+    // SoA state, capacity entries each
+    double* re;             // phasor: sin(2*pi*phase) is im
+    double* im;
+    double* rot_re;         // cos / sin(2*pi*phase_inc)
+    double* rot_im;
+    double* amp;            // current amplitude
+    double* amp_step;       // per-sample ramp of the running block
+    double* target;         // amplitude set by the caller
+    double* inc;            // phase increment set by the caller
+};
+
+static size_t additive_round_up(size_t n)
+{
+    return (n + DSP_ADDITIVE_LANES - 1) / DSP_ADDITIVE_LANES * DSP_ADDITIVE_LANES;
+}
+
+static double* additive_array(size_t n)
+{
+    void* p = NULL;
+    if (posix_memalign(&p, ADDITIVE_ALIGN, sizeof(double) * n) != 0) {
+        return NULL;
+    }
+    return (double*)p;
+}
+
+// Create a bank for up to max_partials partials (all silent, phase 0)
+// Returns NULL on failure; release with additive_free()
+dsp_additive* additive_create(size_t max_partials)
+{
+    if (max_partials == 0) {
+        return NULL;
+    }
+
+    dsp_additive* a = (dsp_additive*)calloc(1, sizeof(dsp_additive));
+    if (!a) {
+        return NULL;
+    }
+
+    size_t cap = additive_round_up(max_partials);
+    a->capacity = cap;
+    a->re = additive_array(cap);
+    a->im = additive_array(cap);
+    a->rot_re = additive_array(cap);
+    a->rot_im = additive_array(cap);
+    a->amp = additive_array(cap);
+    a->amp_step = additive_array(cap);
+    a->target = additive_array(cap);
+    a->inc = additive_array(cap);
+    if (!a->re || !a->im || !a->rot_re || !a->rot_im || !a->amp || !a->amp_step ||
+        !a->target || !a->inc) {
+        additive_free(a);
+        return NULL;
+    }
+
+    for (size_t k = 0; k < cap; k++) {
+        a->rot_re[k] = 1.0;
+        a->rot_im[k] = 0.0;
+        a->inc[k] = 0.0;
+    }
+    additive_reset(a);
+    return a;
+}
+
+void additive_free(dsp_additive* a)
+{
+    if (!a) {
+        return;
+    }
+    free(a->re);
+    free(a->im);
+    free(a->rot_re);
+    free(a->rot_im);
+    free(a->amp);
+    free(a->amp_step);
+    free(a->target);
+    free(a->inc);
+    free(a);
+}
+
+size_t additive_capacity(const dsp_additive* a)
+{
+    return a->capacity;
+}
+
+// Silence every partial and reset all phases to 0 (frequencies are kept)
+void additive_reset(dsp_additive* a)
+{
+    for (size_t k = 0; k < a->capacity; k++) {
+        a->re[k] = 1.0;
+        a->im[k] = 0.0;
+        a->amp[k] = 0.0;
+        a->amp_step[k] = 0.0;
+        a->target[k] = 0.0;
+    }
+    a->count = 0;
+}
+
+static inline void additive_use(dsp_additive* a, size_t k)
+{
+    if (k >= a->count) {
+        a->count = k + 1;
+    }
+}
+
+// Frequency of partial k as phase increment (freq / samplerate)
+// Recomputes the rotation only when the increment changes.
+void additive_set_freq(dsp_additive* a, size_t k, double phase_inc)
+{
+    if (k >= a->capacity) {
+        return;
+    }
+    if (phase_inc != a->inc[k]) {
+        double w = 2.0 * M_PI * phase_inc;
+        a->inc[k] = phase_inc;
+        a->rot_re[k] = cos(w);
+        a->rot_im[k] = sin(w);
+    }
+    additive_use(a, k);
+}
+
+// Target amplitude of partial k, reached at the end of the next block
+void additive_set_amp(dsp_additive* a, size_t k, double amp)
+{
+    if (k >= a->capacity) {
+        return;
+    }
+    a->target[k] = amp;
+    additive_use(a, k);
+}
+
+// Jump partial k to a phase (0.0 - 1.0)
+void additive_set_phase(dsp_additive* a, size_t k, double phase)
+{
+    if (k >= a->capacity) {
+        return;
+    }
+    double w = 2.0 * M_PI * phase;
+    a->re[k] = cos(w);
+    a->im[k] = sin(w);
+    additive_use(a, k);
+}
+
+void additive_set_partial(dsp_additive* a, size_t k, double phase_inc, double amp)
+{
+    additive_set_freq(a, k, phase_inc);
+    additive_set_amp(a, k, amp);
+}
+
+// Set partials 0 .. count-1 from arrays; partials above count fade out
+void additive_set_partials(dsp_additive* a, const double* phase_inc, const double* amp, size_t count)
+{
+    if (count > a->capacity) {
+        count = a->capacity;
+    }
+    for (size_t k = 0; k < count; k++) {
+        additive_set_freq(a, k, phase_inc[k]);
+        a->target[k] = amp[k];
+    }
+    for (size_t k = count; k < a->count; k++) {
+        a->target[k] = 0.0;
+    }
+    if (count > a->count) {
+        a->count = count;
+    }
+}
+
+// Harmonic series: partial k at (k + 1) * phase_inc with amplitude amp[k]
+void additive_set_harmonics(dsp_additive* a, double phase_inc, const double* amp, size_t count)
+{
+    if (count > a->capacity) {
+        count = a->capacity;
+    }
+    for (size_t k = 0; k < count; k++) {
+        additive_set_freq(a, k, phase_inc * (double)(k + 1));
+        a->target[k] = amp[k];
+    }
+    for (size_t k = count; k < a->count; k++) {
+        a->target[k] = 0.0;
+    }
+    if (count > a->count) {
+        a->count = count;
+    }
+}
+
+// Render n samples of the sum of all partials into out (overwritten)
+void additive_process_block(dsp_additive* a, double* out, size_t n)
+{
+    if (n == 0) {
+        return;
+    }
+
+    size_t active = additive_round_up(a->count);
+    double inv_n = 1.0 / (double)n;
+    for (size_t k = 0; k < active; k++) {
+        double inc = fabs(a->inc[k]);
+        double target = inc < 0.5 ? a->target[k] : 0.0;
+        a->amp_step[k] = (target - a->amp[k]) * inv_n;
+    }
+
+    dsp_additive_render(a->re, a->im, a->rot_re, a->rot_im, a->amp, a->amp_step, active, out, n);
+
+    // Land exactly on the targets so ramps do not accumulate rounding error
+    for (size_t k = 0; k < active; k++) {
+        a->amp[k] = fabs(a->inc[k]) < 0.5 ? a->target[k] : 0.0;
+    }
+}
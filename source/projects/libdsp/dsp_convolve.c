@@ -0,0 +1,288 @@
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "libdsp.h"
+#include "dsp_fft.h"
+
+//------------------------------------------------------------------------------
+// Partitioned Convolution
+//
+// Zero-latency convolution with long impulse responses:
+//
+//   head   IR[0, B) as a direct FIR, so the first output sample already
+//          contains the dry-path response
+//   tail   IR[B, L) uniformly partitioned into blocks of B, convolved by
+//          overlap-save FFTs of size 2B with a frequency-domain delay line
+//
+// The FFT work for input block k yields tail output for block k + 1, which
+// is exactly the B-sample offset of the tail inside the IR, so no latency is
+// added. Larger partitions make the tail cheaper and the head dearer (B
+// multiply-adds per sample); 64-256 suits most IRs.
+//------------------------------------------------------------------------------
+
+#define CONVOLVER_DEFAULT_BLOCK 128
+#define CONVOLVER_MIN_BLOCK 16
+#define CONVOLVER_MAX_BLOCK 8192
+
+struct dsp_convolver {
+    size_t block;           // partition size B
+    size_t bins;            // B + 1
+    size_t ir_len;
+    dsp_fft* fft;           // 2B real FFT
+
+    // head FIR
+    size_t head_len;
+    double* head;           // IR[0, head_len) reversed
+    double* hist;           // 2 * head_len, every sample written twice
+    size_t hist_pos;
+
+    // tail
+    size_t parts;           // number of B-sized tail partitions
+    double* ir_re;          // parts * bins partition spectra
+    double* ir_im;
+    double* fdl_re;         // parts * bins input spectra, ring buffer
+    double* fdl_im;
+    size_t fdl_pos;
+    double* acc_re;         // bins
+    double* acc_im;
+    double* in_buf;         // 2B: previous block | current block
+    double* time;           // 2B scratch
+    double* tail_out;       // B tail samples for the current block
+    size_t pos;             // samples into the current block
+};
+
+static size_t conv_block_size(size_t requested)
+{
+    size_t b = CONVOLVER_MIN_BLOCK;
+    if (requested == 0) {
+        requested = CONVOLVER_DEFAULT_BLOCK;
+    }
+    while (b < requested && b < CONVOLVER_MAX_BLOCK) {
+        b <<= 1;
+    }
+    return b;
+}
+
+static dsp_convolver* conv_create(const void* ir, size_t frames, size_t stride, int is_float,
+                                  size_t block_size)
+{
+    if (!ir || frames == 0) {
+        return NULL;
+    }
+    if (stride == 0) {
+        stride = 1;
+    }
+
+    dsp_convolver* c = (dsp_convolver*)calloc(1, sizeof(dsp_convolver));
+    if (!c) {
+        return NULL;
+    }
+
+    size_t B = conv_block_size(block_size);
+    c->block = B;
+    c->bins = B + 1;
+    c->ir_len = frames;
+    c->head_len = frames < B ? frames : B;
+    c->parts = frames > B ? (frames - B + B - 1) / B : 0;
+
+    size_t spectra = (c->parts ? c->parts : 1) * c->bins;
+    c->fft = dsp_fft_create(2 * B);
+    c->head = (double*)malloc(sizeof(double) * c->head_len);
+    c->hist = (double*)calloc(2 * c->head_len, sizeof(double));
+    c->ir_re = (double*)calloc(spectra, sizeof(double));
+    c->ir_im = (double*)calloc(spectra, sizeof(double));
+    c->fdl_re = (double*)calloc(spectra, sizeof(double));
+    c->fdl_im = (double*)calloc(spectra, sizeof(double));
+    c->acc_re = (double*)malloc(sizeof(double) * c->bins);
+    c->acc_im = (double*)malloc(sizeof(double) * c->bins);
+    c->in_buf = (double*)calloc(2 * B, sizeof(double));
+    c->time = (double*)malloc(sizeof(double) * 2 * B);
+    c->tail_out = (double*)calloc(B, sizeof(double));
+    if (!c->fft || !c->head || !c->hist || !c->ir_re || !c->ir_im || !c->fdl_re ||
+        !c->fdl_im || !c->acc_re || !c->acc_im || !c->in_buf || !c->time || !c->tail_out) {
+        convolver_free(c);
+        return NULL;
+    }
+
+    // Reversed head so the FIR is a forward dot product over the history
+    for (size_t i = 0; i < c->head_len; i++) {
+        size_t j = c->head_len - 1 - i;
+        c->head[i] = is_float ? ((const float*)ir)[j * stride] : ((const double*)ir)[j * stride];
+    }
+
+    // Tail partition spectra: FFT of [IR segment (B), zeros (B)]
+    for (size_t p = 0; p < c->parts; p++) {
+        memset(c->time, 0, sizeof(double) * 2 * B);
+        for (size_t i = 0; i < B; i++) {
+            size_t j = B + p * B + i;
+            if (j >= frames) {
+                break;
+            }
+            c->time[i] = is_float ? ((const float*)ir)[j * stride] : ((const double*)ir)[j * stride];
+        }
+        dsp_fft_forward(c->fft, c->time, c->ir_re + p * c->bins, c->ir_im + p * c->bins);
+    }
+
+    return c;
+}
+
+// Create a convolver for an impulse response in doubles
+// (e.g. ffi.new("double[?]", n, buf:to_list(0)))
+// block_size: partition size, rounded up to a power of two (0 = 128)
+// Returns NULL on failure; release with convolver_free()
+dsp_convolver* convolver_create(const double* ir, size_t ir_len, size_t block_size)
+{
+    return conv_create(ir, ir_len, 1, 0, block_size);
+}
+
+// Create a convolver from float samples, e.g. one channel of buffer~ memory
+// stride: distance between frames in samples (the buffer~ channel count)
+dsp_convolver* convolver_create_float(const float* ir, size_t frames, size_t stride,
+                                      size_t block_size)
+{
+    return conv_create(ir, frames, stride, 1, block_size);
+}
+
+void convolver_free(dsp_convolver* c)
+{
+    if (!c) {
+        return;
+    }
+    dsp_fft_free(c->fft);
+    free(c->head);
+    free(c->hist);
+    free(c->ir_re);
+    free(c->ir_im);
+    free(c->fdl_re);
+    free(c->fdl_im);
+    free(c->acc_re);
+    free(c->acc_im);
+    free(c->in_buf);
+    free(c->time);
+    free(c->tail_out);
+    free(c);
+}
+
+// Clear all signal state (the IR is kept)
+void convolver_reset(dsp_convolver* c)
+{
+    size_t spectra = (c->parts ? c->parts : 1) * c->bins;
+    memset(c->hist, 0, sizeof(double) * 2 * c->head_len);
+    memset(c->fdl_re, 0, sizeof(double) * spectra);
+    memset(c->fdl_im, 0, sizeof(double) * spectra);
+    memset(c->in_buf, 0, sizeof(double) * 2 * c->block);
+    memset(c->tail_out, 0, sizeof(double) * c->block);
+    c->hist_pos = 0;
+    c->fdl_pos = 0;
+    c->pos = 0;
+}
+
+size_t convolver_ir_length(const dsp_convolver* c)
+{
+    return c->ir_len;
+}
+
+size_t convolver_block_size(const dsp_convolver* c)
+{
+    return c->block;
+}
+
+// Direct FIR over the first head_len IR samples
+static inline double conv_head(dsp_convolver* c, double x)
+{
+    size_t h = c->head_len;
+    size_t p = c->hist_pos;
+    c->hist[p] = x;
+    c->hist[p + h] = x;
+
+    // hist[p + 1 .. p + h] holds the last h inputs, oldest first
+    const double* window = c->hist + p + 1;
+    const double* head = c->head;
+    double y = 0.0;
+    for (size_t i = 0; i < h; i++) {
+        y += head[i] * window[i];
+    }
+
+    c->hist_pos = (p + 1 == h) ? 0 : p + 1;
+    return y;
+}
+
+// One overlap-save step at the end of an input block: computes the tail
+// output for the next block
+static void conv_tail_step(dsp_convolver* c)
+{
+    size_t B = c->block;
+    size_t bins = c->bins;
+
+    if (c->parts > 0) {
+        double* x_re = c->fdl_re + c->fdl_pos * bins;
+        double* x_im = c->fdl_im + c->fdl_pos * bins;
+        dsp_fft_forward(c->fft, c->in_buf, x_re, x_im);
+
+        // acc = sum over partitions p of X[k - p] * H[p]
+        memset(c->acc_re, 0, sizeof(double) * bins);
+        memset(c->acc_im, 0, sizeof(double) * bins);
+        size_t slot = c->fdl_pos;
+        for (size_t p = 0; p < c->parts; p++) {
+            const double* restrict xr = c->fdl_re + slot * bins;
+            const double* restrict xi = c->fdl_im + slot * bins;
+            const double* restrict hr = c->ir_re + p * bins;
+            const double* restrict hi = c->ir_im + p * bins;
+            double* restrict ar = c->acc_re;
+            double* restrict ai = c->acc_im;
+            for (size_t k = 0; k < bins; k++) {
+                ar[k] += xr[k] * hr[k] - xi[k] * hi[k];
+                ai[k] += xr[k] * hi[k] + xi[k] * hr[k];
+            }
+            slot = (slot == 0) ? c->parts - 1 : slot - 1;
+        }
+        c->fdl_pos = (c->fdl_pos + 1 == c->parts) ? 0 : c->fdl_pos + 1;
+
+        // The last B samples of the circular result are the valid linear part
+        dsp_fft_inverse(c->fft, c->acc_re, c->acc_im, c->time);
+        memcpy(c->tail_out, c->time + B, sizeof(double) * B);
+    }
+
+    memmove(c->in_buf, c->in_buf + B, sizeof(double) * B);
+}
+
+// One sample in, one sample out (wet signal only)
+double convolver_tick(dsp_convolver* c, double x)
+{
+    double y = conv_head(c, x) + c->tail_out[c->pos];
+    c->in_buf[c->block + c->pos] = x;
+    if (++c->pos == c->block) {
+        conv_tail_step(c);
+        c->pos = 0;
+    }
+    return y;
+}
+
+// Any block length; in and out may alias
+void convolver_process_block(dsp_convolver* c, const double* in, double* out, size_t n)
+{
+    size_t B = c->block;
+    size_t i = 0;
+    while (i < n) {
+        size_t chunk = B - c->pos;
+        if (chunk > n - i) {
+            chunk = n - i;
+        }
+
+        double* pending = c->in_buf + B + c->pos;
+        const double* tail = c->tail_out + c->pos;
+        for (size_t j = 0; j < chunk; j++) {
+            double x = in[i + j];
+            pending[j] = x;
+            out[i + j] = conv_head(c, x) + tail[j];
+        }
+
+        i += chunk;
+        c->pos += chunk;
+        if (c->pos == B) {
+            conv_tail_step(c);
+            c->pos = 0;
+        }
+    }
+}
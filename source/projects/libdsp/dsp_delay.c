@@ -0,0 +1,262 @@
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libdsp.h"
+
+//------------------------------------------------------------------------------
+// Delay Lines
+//
+// A power-of-two ring buffer: every index is masked instead of wrapped with
+// %, and the samples live in one malloc'd block outside the Lua heap.
+//
+// Delays are measured from the sample about to be written, so the usual
+// read-then-write order gives an exact delay:
+//
+//   y = delay_read(d, t)   -- input from t samples ago (t >= 1)
+//   delay_write(d, x + y * feedback)
+//
+// Fractional reads clamp the delay to the range they can serve:
+//   none, linear         [1, size - 1]
+//   cubic, lagrange      [2, size - 3]  (one newer and two older neighbours)
+//   allpass              [2, size - 3]
+//------------------------------------------------------------------------------
+
+#define DELAY_MIN_SIZE 16
+
+// Round up to a power of two large enough for max_delay plus the widest
+// interpolation kernel
+static size_t delay_size(size_t max_delay)
+{
+    size_t size = DELAY_MIN_SIZE;
+    while (size < max_delay + 4) {
+        size <<= 1;
+    }
+    return size;
+}
+
+// Create a delay line holding at least max_delay samples
+// When reading blocks, pass the longest delay plus the block size.
+// Returns NULL on failure; release with delay_free()
+dsp_delay* delay_create(size_t max_delay)
+{
+    dsp_delay* d = (dsp_delay*)malloc(sizeof(dsp_delay));
+    if (!d) {
+        return NULL;
+    }
+    d->size = delay_size(max_delay);
+    d->mask = d->size - 1;
+    d->buf = (double*)calloc(d->size, sizeof(double));
+    if (!d->buf) {
+        free(d);
+        return NULL;
+    }
+    d->write = 0;
+    d->ap_y1 = 0.0;
+    return d;
+}
+
+void delay_free(dsp_delay* d)
+{
+    if (!d) {
+        return;
+    }
+    free(d->buf);
+    free(d);
+}
+
+// Clear the buffer and the allpass state
+void delay_reset(dsp_delay* d)
+{
+    memset(d->buf, 0, sizeof(double) * d->size);
+    d->write = 0;
+    d->ap_y1 = 0.0;
+}
+
+void delay_write(dsp_delay* d, double x)
+{
+    d->buf[d->write] = x;
+    d->write = (d->write + 1) & d->mask;
+}
+
+// Write a block; samples are in time order (in[n - 1] is the newest)
+void delay_write_block(dsp_delay* d, const double* in, size_t n)
+{
+    size_t w = d->write;
+    for (size_t i = 0; i < n; i++) {
+        d->buf[w] = in[i];
+        w = (w + 1) & d->mask;
+    }
+    d->write = w;
+}
+
+//------------------------------------------------------------------------------
+// Reads
+//------------------------------------------------------------------------------
+
+// Sample written t samples before position now
+static inline double dl_at(const dsp_delay* d, size_t now, size_t t)
+{
+    return d->buf[(now - t) & d->mask];
+}
+
+static inline double dl_clamp(double t, double lo, double hi)
+{
+    return t < lo ? lo : (t > hi ? hi : t);
+}
+
+static inline double dl_none(const dsp_delay* d, size_t now, double t)
+{
+    t = dl_clamp(t, 1.0, (double)(d->size - 1));
+    return dl_at(d, now, (size_t)(t + 0.5));
+}
+
+static inline double dl_linear(const dsp_delay* d, size_t now, double t)
+{
+    t = dl_clamp(t, 1.0, (double)(d->size - 1));
+    size_t ti = (size_t)t;
+    double f = t - (double)ti;
+    double s0 = dl_at(d, now, ti);
+    double s1 = dl_at(d, now, ti + 1);
+    return s0 + (s1 - s0) * f;
+}
+
+// 4-point, 3rd-order Hermite (Catmull-Rom)
+static inline double dl_cubic(const dsp_delay* d, size_t now, double t)
+{
+    t = dl_clamp(t, 2.0, (double)(d->size - 3));
+    size_t ti = (size_t)t;
+    double f = t - (double)ti;
+    double sm1 = dl_at(d, now, ti - 1);
+    double s0 = dl_at(d, now, ti);
+    double s1 = dl_at(d, now, ti + 1);
+    double s2 = dl_at(d, now, ti + 2);
+    double c1 = 0.5 * (s1 - sm1);
+    double c2 = sm1 - 2.5 * s0 + 2.0 * s1 - 0.5 * s2;
+    double c3 = 0.5 * (s2 - sm1) + 1.5 * (s0 - s1);
+    return ((c3 * f + c2) * f + c1) * f + s0;
+}
+
+// 4-point, 3rd-order Lagrange: flatter passband than Hermite, less smooth
+// under fast modulation
+static inline double dl_lagrange(const dsp_delay* d, size_t now, double t)
+{
+    t = dl_clamp(t, 2.0, (double)(d->size - 3));
+    size_t ti = (size_t)t;
+    double f = t - (double)ti;
+    double sm1 = dl_at(d, now, ti - 1);
+    double s0 = dl_at(d, now, ti);
+    double s1 = dl_at(d, now, ti + 1);
+    double s2 = dl_at(d, now, ti + 2);
+    double fp1 = f + 1.0;
+    double fm1 = f - 1.0;
+    double fm2 = f - 2.0;
+    return -sm1 * f * fm1 * fm2 * (1.0 / 6.0)
+         + s0 * fp1 * fm1 * fm2 * 0.5
+         - s1 * fp1 * f * fm2 * 0.5
+         + s2 * fp1 * f * fm1 * (1.0 / 6.0);
+}
+
+static inline double dl_interp(const dsp_delay* d, size_t now, double t, delay_interp interp)
+{
+    switch (interp) {
+    case DELAY_LINEAR:
+        return dl_linear(d, now, t);
+    case DELAY_CUBIC:
+        return dl_cubic(d, now, t);
+    case DELAY_LAGRANGE:
+        return dl_lagrange(d, now, t);
+    default:
+        return dl_none(d, now, t);
+    }
+}
+
+// Integer delay (t = 1 is the last sample written)
+double delay_read(const dsp_delay* d, size_t t)
+{
+    if (t < 1) t = 1;
+    if (t > d->mask) t = d->mask;
+    return dl_at(d, d->write, t);
+}
+
+double delay_read_linear(const dsp_delay* d, double t)
+{
+    return dl_linear(d, d->write, t);
+}
+
+double delay_read_cubic(const dsp_delay* d, double t)
+{
+    return dl_cubic(d, d->write, t);
+}
+
+double delay_read_lagrange(const dsp_delay* d, double t)
+{
+    return dl_lagrange(d, d->write, t);
+}
+
+// First-order allpass interpolation: flat magnitude, so it suits feedback
+// loops (waveguides, comb filters) but not fast modulation. It is a filter,
+// so call it exactly once per sample with slowly changing t.
+// The fraction is kept in [0.5, 1.5) to stay clear of the pole at z = -1.
+double delay_read_allpass(dsp_delay* d, double t)
+{
+    t = dl_clamp(t, 2.0, (double)(d->size - 3));
+    size_t ti = (size_t)t;
+    double f = t - (double)ti;
+    if (f < 0.5) {
+        ti--;
+        f += 1.0;
+    }
+    double eta = (1.0 - f) / (1.0 + f);
+    double s0 = dl_at(d, d->write, ti);
+    double s1 = dl_at(d, d->write, ti + 1);
+    double y = eta * s0 + s1 - eta * d->ap_y1;
+    d->ap_y1 = y;
+    return y;
+}
+
+// Several taps at once, e.g. an early-reflection pattern
+// times: count delays in samples; out: count tap values
+void delay_read_taps(const dsp_delay* d, const double* times, double* out, size_t count,
+                     delay_interp interp)
+{
+    size_t now = d->write;
+    for (size_t i = 0; i < count; i++) {
+        out[i] = dl_interp(d, now, times[i], interp);
+    }
+}
+
+// Weighted sum of several taps
+double delay_read_taps_sum(const dsp_delay* d, const double* times, const double* gains,
+                           size_t count, delay_interp interp)
+{
+    size_t now = d->write;
+    double y = 0.0;
+    for (size_t i = 0; i < count; i++) {
+        y += gains[i] * dl_interp(d, now, times[i], interp);
+    }
+    return y;
+}
+
+// Read the last n samples written back, delayed by t: after
+// delay_write_block(d, in, n), out[i] is the input from t samples before in[i],
+// the same as calling delay_read_*(d, t) before each delay_write().
+// The buffer must hold t + n samples.
+void delay_read_block(const dsp_delay* d, double* out, size_t n, double t, delay_interp interp)
+{
+    size_t now = d->write - n;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = dl_interp(d, now + i, t, interp);
+    }
+}
+
+// Block read with one delay time per sample (chorus, flanger, vibrato)
+void delay_read_block_mod(const dsp_delay* d, const double* times, double* out, size_t n,
+                          delay_interp interp)
+{
+    size_t now = d->write - n;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = dl_interp(d, now + i, times[i], interp);
+    }
+}
@@ -0,0 +1,266 @@
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libdsp.h"
+#include "dsp_dispatch.h"
+
+//------------------------------------------------------------------------------
+// CPU Dispatch
+//
+// The kernels in dsp_kernels.h are compiled once per instruction set through
+// function target attributes, so a single (and on macOS, universal) build of
+// the library carries all of them:
+//
+//   x86-64   sse2 (baseline), avx2 (+fma), avx512 (f/dq/vl)
+//   arm64    neon (baseline)
+//
+// The best variant the CPU and OS support is picked when the library is
+// loaded. Set LIBDSP_ISA=<name> in the environment, or call dsp_set_isa(),
+// to force a variant for testing. Results can differ in the last bit between
+// variants because FMA targets fuse multiply-adds.
+//------------------------------------------------------------------------------
+
+typedef struct {
+    const char* isa;
+    void (*scale_linear_block)(const double*, double*, size_t, double, double, double, double);
+    void (*soft_clip_block)(const double*, double*, size_t, double);
+    void (*hard_clip_block)(const double*, double*, size_t, double);
+    void (*bit_crush_block)(const double*, double*, size_t, double);
+    void (*lerp_block)(const double*, const double*, double*, size_t, double);
+    void (*wavefold_block)(const double*, double*, size_t, double);
+    void (*ring_mod_block)(const double*, const double*, double*, size_t);
+    void (*clamp_block)(const double*, double*, size_t, double, double);
+    void (*osc_saw_block)(const double*, double*, size_t);
+    void (*osc_saw_bl_block)(const double*, double*, size_t, double);
+    void (*osc_square_block)(const double*, double*, size_t, double);
+    void (*osc_square_bl_block)(const double*, double*, size_t, double, double);
+    void (*osc_triangle_block)(const double*, double*, size_t);
+    void (*additive_render)(double*, double*, const double*, const double*, double*,
+                            const double*, size_t, double*, size_t);
+} dsp_kernel_table;
+
+#define DSP_CAT2(a, b) a##_##b
+#define DSP_CAT(a, b) DSP_CAT2(a, b)
+#define DSP_KERNEL(name) DSP_CAT(name, DSP_ISA)
+#define DSP_STR2(x) #x
+#define DSP_STR(x) DSP_STR2(x)
+
+#if defined(__x86_64__) || defined(_M_X64)
+
+#define DSP_ISA sse2
+#define DSP_TARGET
+#include "dsp_kernels.h"
+#undef DSP_ISA
+#undef DSP_TARGET
+
+#define DSP_ISA avx2
+#define DSP_TARGET __attribute__((target("avx2,fma")))
+#include "dsp_kernels.h"
+#undef DSP_ISA
+#undef DSP_TARGET
+
+#define DSP_ISA avx512
+#define DSP_TARGET __attribute__((target("avx512f,avx512dq,avx512vl,avx2,fma")))
+#include "dsp_kernels.h"
+#undef DSP_ISA
+#undef DSP_TARGET
+
+// Best first
+static const dsp_kernel_table* const dsp_variants[] = {
+    &dsp_kernels_avx512,
+    &dsp_kernels_avx2,
+    &dsp_kernels_sse2,
+};
+
+static int dsp_variant_supported(const dsp_kernel_table* k)
+{
+    __builtin_cpu_init();
+    if (k == &dsp_kernels_avx512) {
+        return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq") &&
+               __builtin_cpu_supports("avx512vl");
+    }
+    if (k == &dsp_kernels_avx2) {
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    }
+    return 1;
+}
+
+#elif defined(__aarch64__) || defined(_M_ARM64)
+
+// Advanced SIMD is part of the arm64 baseline, no target attribute needed
+#define DSP_ISA neon
+#define DSP_TARGET
+#include "dsp_kernels.h"
+#undef DSP_ISA
+#undef DSP_TARGET
+
+static const dsp_kernel_table* const dsp_variants[] = {
+    &dsp_kernels_neon,
+};
+
+static int dsp_variant_supported(const dsp_kernel_table* k)
+{
+    (void)k;
+    return 1;
+}
+
+#else
+
+#define DSP_ISA generic
+#define DSP_TARGET
+#include "dsp_kernels.h"
+#undef DSP_ISA
+#undef DSP_TARGET
+
+static const dsp_kernel_table* const dsp_variants[] = {
+    &dsp_kernels_generic,
+};
+
+static int dsp_variant_supported(const dsp_kernel_table* k)
+{
+    (void)k;
+    return 1;
+}
+
+#endif
+
+#define DSP_NUM_VARIANTS (sizeof(dsp_variants) / sizeof(dsp_variants[0]))
+
+// Lowest common denominator until the constructor has run
+static const dsp_kernel_table* dsp_active = NULL;
+
+static const dsp_kernel_table* dsp_best_variant(void)
+{
+    for (size_t i = 0; i < DSP_NUM_VARIANTS; i++) {
+        if (dsp_variant_supported(dsp_variants[i])) {
+            return dsp_variants[i];
+        }
+    }
+    return dsp_variants[DSP_NUM_VARIANTS - 1];
+}
+
+__attribute__((constructor))
+static void dsp_dispatch_init(void)
+{
+    dsp_active = dsp_best_variant();
+
+    const char* forced = getenv("LIBDSP_ISA");
+    if (forced && *forced) {
+        dsp_set_isa(forced);
+    }
+}
+
+static inline const dsp_kernel_table* dsp_kernels(void)
+{
+    return dsp_active ? dsp_active : dsp_variants[DSP_NUM_VARIANTS - 1];
+}
+
+// Name of the active kernel variant ("sse2", "avx2", "avx512", "neon", "generic")
+const char* dsp_isa(void)
+{
+    return dsp_kernels()->isa;
+}
+
+// Force a kernel variant by name; "auto" restores the best supported one
+// Returns 0 on success, -1 if the variant is unknown or unsupported here.
+// Not synchronised with running audio: switch before processing starts.
+int dsp_set_isa(const char* name)
+{
+    if (!name || strcmp(name, "auto") == 0) {
+        dsp_active = dsp_best_variant();
+        return 0;
+    }
+    for (size_t i = 0; i < DSP_NUM_VARIANTS; i++) {
+        if (strcmp(dsp_variants[i]->isa, name) == 0) {
+            if (!dsp_variant_supported(dsp_variants[i])) {
+                return -1;
+            }
+            dsp_active = dsp_variants[i];
+            return 0;
+        }
+    }
+    return -1;
+}
+
+//------------------------------------------------------------------------------
+// Public entry points (declared in libdsp.h)
+//------------------------------------------------------------------------------
+
+void scale_linear_block(const double* in, double* out, size_t n,
+                        double i_min, double i_max, double o_min, double o_max)
+{
+    dsp_kernels()->scale_linear_block(in, out, n, i_min, i_max, o_min, o_max);
+}
+
+void soft_clip_block(const double* in, double* out, size_t n, double drive)
+{
+    dsp_kernels()->soft_clip_block(in, out, n, drive);
+}
+
+void hard_clip_block(const double* in, double* out, size_t n, double threshold)
+{
+    dsp_kernels()->hard_clip_block(in, out, n, threshold);
+}
+
+void bit_crush_block(const double* in, double* out, size_t n, double bits)
+{
+    dsp_kernels()->bit_crush_block(in, out, n, bits);
+}
+
+void lerp_block(const double* a, const double* b, double* out, size_t n, double t)
+{
+    dsp_kernels()->lerp_block(a, b, out, n, t);
+}
+
+void wavefold_block(const double* in, double* out, size_t n, double threshold)
+{
+    dsp_kernels()->wavefold_block(in, out, n, threshold);
+}
+
+void ring_mod_block(const double* in, const double* mod, double* out, size_t n)
+{
+    dsp_kernels()->ring_mod_block(in, mod, out, n);
+}
+
+void clamp_block(const double* in, double* out, size_t n, double min, double max)
+{
+    dsp_kernels()->clamp_block(in, out, n, min, max);
+}
+
+void osc_saw_block(const double* in, double* out, size_t n)
+{
+    dsp_kernels()->osc_saw_block(in, out, n);
+}
+
+void osc_saw_bl_block(const double* in, double* out, size_t n, double phase_inc)
+{
+    dsp_kernels()->osc_saw_bl_block(in, out, n, phase_inc);
+}
+
+void osc_square_block(const double* in, double* out, size_t n, double pulse_width)
+{
+    dsp_kernels()->osc_square_block(in, out, n, pulse_width);
+}
+
+void osc_square_bl_block(const double* in, double* out, size_t n, double pulse_width, double phase_inc)
+{
+    dsp_kernels()->osc_square_bl_block(in, out, n, pulse_width, phase_inc);
+}
+
+void osc_triangle_block(const double* in, double* out, size_t n)
+{
+    dsp_kernels()->osc_triangle_block(in, out, n);
+}
+
+//------------------------------------------------------------------------------
+// Internal entry points (declared in dsp_dispatch.h)
+//------------------------------------------------------------------------------
+
+void dsp_additive_render(double* re, double* im, const double* rot_re, const double* rot_im,
+                         double* amp, const double* amp_step, size_t count,
+                         double* out, size_t n)
+{
+    dsp_kernels()->additive_render(re, im, rot_re, rot_im, amp, amp_step, count, out, n);
+}
@@ -0,0 +1,22 @@
+// dsp_dispatch.h
+// Internal entry points into the ISA-dispatched kernels that are not part of
+// the FFI API (the public *_block wrappers are declared in libdsp.h)
+
+#ifndef DSP_DISPATCH_H
+#define DSP_DISPATCH_H
+
+#include <stddef.h>
+
+// Partials per group in the additive kernel: four AVX2 / two AVX-512 vectors,
+// enough independent chains to keep the FMA units busy. Counts passed to
+// dsp_additive_render() must be a multiple of it.
+#define DSP_ADDITIVE_LANES 16
+
+// Render count partials held as rotating phasors (re, im) for n samples,
+// overwriting out with their sum. Advances re/im by rot_re/rot_im and amp by
+// amp_step every sample, then renormalises the phasors.
+void dsp_additive_render(double* re, double* im, const double* rot_re, const double* rot_im,
+                         double* amp, const double* amp_step, size_t count,
+                         double* out, size_t n);
+
+#endif // DSP_DISPATCH_H
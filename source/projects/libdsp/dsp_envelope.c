@@ -0,0 +1,97 @@
+
+#include <math.h>
+#include <string.h>
+
+#include "libdsp.h"
+
+//------------------------------------------------------------------------------
+// ADSR Envelope
+//
+// Linear segments with the stage logic of the worp Adsr module, so a patch
+// sounds the same on either path:
+//
+//   attack    rises by 1 / (A * samplerate) per sample until the level is 1
+//   decay     falls by 1 / (D * samplerate) until it drops below sustain
+//   sustain   holds
+//   release   falls by 1 / (R * samplerate) to 0
+//
+// The output is the level times the velocity of the last note on. Changing
+// A, D or R takes effect at the next stage change.
+//------------------------------------------------------------------------------
+
+void adsr_init(dsp_adsr* e)
+{
+    memset(e, 0, sizeof(dsp_adsr));
+    e->stage = ADSR_IDLE;
+    e->attack = -1.0;   // force the first adsr_set() to compute the slopes
+}
+
+// Back to idle at level 0
+void adsr_reset(dsp_adsr* e)
+{
+    e->stage = ADSR_IDLE;
+    e->level = 0.0;
+    e->step = 0.0;
+}
+
+// attack, decay, release: segment times in seconds (0 = one sample)
+// sustain: level 0.0 - 1.0
+void adsr_set(dsp_adsr* e, double attack, double decay, double sustain, double release,
+              double samplerate)
+{
+    e->sustain = sustain;
+    if (e->attack == attack && e->decay == decay && e->release == release &&
+        e->samplerate == samplerate) {
+        return;
+    }
+    e->attack = attack;
+    e->decay = decay;
+    e->release = release;
+    e->samplerate = samplerate;
+
+    // 1 / 0 is inf, so zero times clamp to a full-scale step
+    e->step_a = fmin(1.0 / (samplerate * attack), 1.0);
+    e->step_d = fmax(-1.0 / (samplerate * decay), -1.0);
+    e->step_r = fmax(-1.0 / (samplerate * release), -1.0);
+}
+
+// Note on for velocity > 0 (restarts the attack from the current level),
+// note off for velocity == 0
+void adsr_gate(dsp_adsr* e, double velocity)
+{
+    if (velocity > 0.0) {
+        e->velocity = velocity;
+        e->stage = ADSR_ATTACK;
+        e->step = e->step_a;
+    } else if (velocity == 0.0) {
+        e->stage = ADSR_RELEASE;
+        e->step = e->step_r;
+    }
+}
+
+static inline double adsr_advance(dsp_adsr* e)
+{
+    if (e->stage == ADSR_ATTACK && e->level >= 1.0) {
+        e->stage = ADSR_DECAY;
+        e->step = e->step_d;
+    } else if (e->stage == ADSR_DECAY && e->level < e->sustain) {
+        e->stage = ADSR_SUSTAIN;
+        e->step = 0.0;
+    }
+    double v = e->level + e->step;
+    v = v < 0.0 ? 0.0 : (v > 1.0 ? 1.0 : v);
+    e->level = v;
+    return v * e->velocity;
+}
+
+double adsr_tick(dsp_adsr* e)
+{
+    return adsr_advance(e);
+}
+
+void adsr_process_block(dsp_adsr* e, double* out, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        out[i] = adsr_advance(e);
+    }
+}
@@ -0,0 +1,324 @@
+
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "libdsp.h"
+
+//------------------------------------------------------------------------------
+// Fast Math Approximations
+//
+// Every function comes in three accuracy tiers so the trade-off is chosen
+// explicitly at the call site (maximum error over the range audio code uses,
+// measured by bench_fastmath.c):
+//
+//   _low     cheapest, ~1e-3 (tanh ~2e-2), for modulation and control signals
+//   _med     ~1e-7 relative, below single precision, transparent for audio
+//   _high    ~1e-13 relative, close to libm double precision
+//
+// The *_block() variants take the tier as an argument and resolve it once per
+// call. None of the functions touch errno or the FP environment, and they do
+// not handle NaN specially.
+//------------------------------------------------------------------------------
+
+#define FM_LOG2E   1.4426950408889634074
+#define FM_LN2     0.6931471805599453094
+#define FM_DB2LOG2 0.16609640474436811739   // log2(10) / 20
+#define FM_LOG22DB 6.0205999132796239042    // 20 / log2(10)
+#define FM_ROUND   6755399441055744.0         // 1.5 * 2^52: x + FM_ROUND rounds x to an integer
+#define FM_TWO52   4503599627370496.0         // 2^52
+
+static inline double fm_bits_to_double(uint64_t u)
+{
+    double d;
+    memcpy(&d, &u, sizeof(d));
+    return d;
+}
+
+static inline uint64_t fm_double_to_bits(double d)
+{
+    uint64_t u;
+    memcpy(&u, &d, sizeof(u));
+    return u;
+}
+
+// Helpers are written without libm calls, int/double conversions or branches
+// (selects only), so the block loops auto-vectorise with plain SSE2/NEON.
+
+// Round to nearest integer, |x| < 2^51
+static inline double fm_round(double x)
+{
+    return (x + FM_ROUND) - FM_ROUND;
+}
+
+//------------------------------------------------------------------------------
+// exp2
+// 2^x = 2^i * 2^f with i = round(x), f in [-0.5, 0.5]; 2^i is built directly
+// in the exponent bits, 2^f = e^(f ln2) by a truncated Taylor series.
+//------------------------------------------------------------------------------
+
+static inline double fm_exp2_split(double x, double* f)
+{
+    x = x < -1022.0 ? -1022.0 : x;
+    x = x > 1023.0 ? 1023.0 : x;
+    double k = x + FM_ROUND;                    // low mantissa bits hold round(x)
+    *f = (x - (k - FM_ROUND)) * FM_LN2;
+    return fm_bits_to_double((fm_double_to_bits(k) + 1023) << 52);
+}
+
+double fast_exp2_low(double x)
+{
+    double t;
+    double scale = fm_exp2_split(x, &t);
+    return scale * (1.0 + t * (1.0 + t * (1.0 / 2 + t * (1.0 / 6))));
+}
+
+double fast_exp2_med(double x)
+{
+    double t;
+    double scale = fm_exp2_split(x, &t);
+    return scale * (1.0 + t * (1.0 + t * (1.0 / 2 + t * (1.0 / 6 + t * (1.0 / 24 + t * (1.0 / 120
+                   + t * (1.0 / 720)))))));
+}
+
+double fast_exp2_high(double x)
+{
+    double t;
+    double scale = fm_exp2_split(x, &t);
+    double p = 1.0 / 39916800;                  // 1/11!
+    p = 1.0 / 3628800 + t * p;
+    p = 1.0 / 362880 + t * p;
+    p = 1.0 / 40320 + t * p;
+    p = 1.0 / 5040 + t * p;
+    p = 1.0 / 720 + t * p;
+    p = 1.0 / 120 + t * p;
+    p = 1.0 / 24 + t * p;
+    p = 1.0 / 6 + t * p;
+    p = 1.0 / 2 + t * p;
+    p = 1.0 + t * p;
+    p = 1.0 + t * p;
+    return scale * p;
+}
+
+//------------------------------------------------------------------------------
+// log2
+// x = m * 2^e with m in [sqrt(1/2), sqrt(2)); log2(m) = 2/ln2 * atanh(s),
+// s = (m - 1) / (m + 1), |s| < 0.172, by the odd atanh series.
+// x <= 0 (and denormals) are treated as DBL_MIN.
+//------------------------------------------------------------------------------
+
+static inline double fm_log2_split(double x, double* s)
+{
+    x = x >= DBL_MIN ? x : DBL_MIN;
+    uint64_t u = fm_double_to_bits(x);
+    // biased exponent as a double: place it in the mantissa of 2^52
+    double e = fm_bits_to_double(0x4330000000000000ULL | (u >> 52)) - (FM_TWO52 + 1023.0);
+    double m = fm_bits_to_double((u & 0x000fffffffffffffULL) | 0x3ff0000000000000ULL);
+    int big = m > M_SQRT2;
+    m = big ? m * 0.5 : m;
+    e = big ? e + 1.0 : e;
+    *s = (m - 1.0) / (m + 1.0);
+    return e;
+}
+
+double fast_log2_low(double x)
+{
+    double s;
+    double e = fm_log2_split(x, &s);
+    double s2 = s * s;
+    return e + (2.0 * FM_LOG2E) * s * (1.0 + s2 * (1.0 / 3));
+}
+
+double fast_log2_med(double x)
+{
+    double s;
+    double e = fm_log2_split(x, &s);
+    double s2 = s * s;
+    return e + (2.0 * FM_LOG2E) * s * (1.0 + s2 * (1.0 / 3 + s2 * (1.0 / 5 + s2 * (1.0 / 7))));
+}
+
+double fast_log2_high(double x)
+{
+    double s;
+    double e = fm_log2_split(x, &s);
+    double s2 = s * s;
+    double p = 1.0 / 17;
+    p = 1.0 / 15 + s2 * p;
+    p = 1.0 / 13 + s2 * p;
+    p = 1.0 / 11 + s2 * p;
+    p = 1.0 / 9 + s2 * p;
+    p = 1.0 / 7 + s2 * p;
+    p = 1.0 / 5 + s2 * p;
+    p = 1.0 / 3 + s2 * p;
+    p = 1.0 + s2 * p;
+    return e + (2.0 * FM_LOG2E) * s * p;
+}
+
+//------------------------------------------------------------------------------
+// sin / cos (radians)
+// Reduced to [-pi, pi], then reflected to [-pi/2, pi/2] for the polynomials.
+//------------------------------------------------------------------------------
+
+static inline double fm_reduce_pi(double x)
+{
+    return x - (2.0 * M_PI) * fm_round(x * (0.5 / M_PI));
+}
+
+static inline double fm_reflect_half_pi(double x)
+{
+    double r = (x < 0.0 ? -M_PI : M_PI) - x;
+    return fabs(x) > M_PI_2 ? r : x;
+}
+
+// Parabola through 0, +-pi/2, +-pi with a second-order correction
+double fast_sin_low(double x)
+{
+    x = fm_reduce_pi(x);
+    double y = (4.0 / M_PI) * x - (4.0 / (M_PI * M_PI)) * x * fabs(x);
+    return y + 0.225 * (y * fabs(y) - y);
+}
+
+double fast_sin_med(double x)
+{
+    x = fm_reflect_half_pi(fm_reduce_pi(x));
+    double x2 = x * x;
+    return x * (1.0 - x2 * (1.0 / 6 - x2 * (1.0 / 120 - x2 * (1.0 / 5040 - x2 * (1.0 / 362880
+                - x2 * (1.0 / 39916800))))));
+}
+
+double fast_sin_high(double x)
+{
+    x = fm_reflect_half_pi(fm_reduce_pi(x));
+    double x2 = x * x;
+    double p = -1.0 / 121645100408832000.0;     // -1/19!
+    p = 1.0 / 355687428096000.0 + x2 * p;
+    p = -1.0 / 1307674368000.0 + x2 * p;
+    p = 1.0 / 6227020800.0 + x2 * p;
+    p = -1.0 / 39916800 + x2 * p;
+    p = 1.0 / 362880 + x2 * p;
+    p = -1.0 / 5040 + x2 * p;
+    p = 1.0 / 120 + x2 * p;
+    p = -1.0 / 6 + x2 * p;
+    p = 1.0 + x2 * p;
+    return x * p;
+}
+
+double fast_cos_low(double x)
+{
+    return fast_sin_low(x + M_PI_2);
+}
+
+double fast_cos_med(double x)
+{
+    return fast_sin_med(x + M_PI_2);
+}
+
+double fast_cos_high(double x)
+{
+    return fast_sin_high(x + M_PI_2);
+}
+
+//------------------------------------------------------------------------------
+// tanh
+//------------------------------------------------------------------------------
+
+// Pade (3,2) approximant, exact saturation at |x| >= 3
+double fast_tanh_low(double x)
+{
+    x = x > 3.0 ? 3.0 : x;
+    x = x < -3.0 ? -3.0 : x;
+    double x2 = x * x;
+    return x * (27.0 + x2) / (27.0 + 9.0 * x2);
+}
+
+// tanh(|x|) = 1 - 2 / (2^(2|x| log2 e) + 1); the odd series near 0 keeps the
+// relative error small where the subtraction would cancel
+static inline double fm_tanh_series(double x)
+{
+    double x2 = x * x;
+    return x * (1.0 - x2 * (1.0 / 3 - x2 * (2.0 / 15 - x2 * (17.0 / 315 - x2 * (62.0 / 2835)))));
+}
+
+double fast_tanh_med(double x)
+{
+    double ax = fabs(x);
+    ax = ax > 20.0 ? 20.0 : ax;
+    double y = 1.0 - 2.0 / (fast_exp2_med(2.0 * FM_LOG2E * ax) + 1.0);
+    y = x < 0.0 ? -y : y;
+    return ax < 0.0625 ? fm_tanh_series(x) : y;
+}
+
+double fast_tanh_high(double x)
+{
+    double ax = fabs(x);
+    ax = ax > 20.0 ? 20.0 : ax;
+    double y = 1.0 - 2.0 / (fast_exp2_high(2.0 * FM_LOG2E * ax) + 1.0);
+    y = x < 0.0 ? -y : y;
+    return ax < 0.0625 ? fm_tanh_series(x) : y;
+}
+
+//------------------------------------------------------------------------------
+// pow and decibels (built on exp2/log2 of the same tier)
+//------------------------------------------------------------------------------
+
+// x^y for x > 0 (x <= 0 is treated as DBL_MIN)
+double fast_pow_low(double x, double y)  { return fast_exp2_low(y * fast_log2_low(x)); }
+double fast_pow_med(double x, double y)  { return fast_exp2_med(y * fast_log2_med(x)); }
+double fast_pow_high(double x, double y) { return fast_exp2_high(y * fast_log2_high(x)); }
+
+// Decibels to linear gain
+double fast_db_to_gain_low(double db)  { return fast_exp2_low(db * FM_DB2LOG2); }
+double fast_db_to_gain_med(double db)  { return fast_exp2_med(db * FM_DB2LOG2); }
+double fast_db_to_gain_high(double db) { return fast_exp2_high(db * FM_DB2LOG2); }
+
+// Linear gain to decibels (gain <= 0 returns about -6153 dB)
+double fast_gain_to_db_low(double gain)  { return fast_log2_low(gain) * FM_LOG22DB; }
+double fast_gain_to_db_med(double gain)  { return fast_log2_med(gain) * FM_LOG22DB; }
+double fast_gain_to_db_high(double gain) { return fast_log2_high(gain) * FM_LOG22DB; }
+
+//------------------------------------------------------------------------------
+// Block Functions
+// tier: FASTMATH_LOW, FASTMATH_MED or FASTMATH_HIGH (in and out may alias)
+//------------------------------------------------------------------------------
+
+#define FM_BLOCK(name)                                                          \
+void fast_##name##_block(const double* in, double* out, size_t n,              \
+                         fastmath_tier tier)                                    \
+{                                                                               \
+    switch (tier) {                                                             \
+    case FASTMATH_LOW:                                                          \
+        for (size_t i = 0; i < n; i++) out[i] = fast_##name##_low(in[i]);       \
+        break;                                                                  \
+    case FASTMATH_MED:                                                          \
+        for (size_t i = 0; i < n; i++) out[i] = fast_##name##_med(in[i]);       \
+        break;                                                                  \
+    default:                                                                    \
+        for (size_t i = 0; i < n; i++) out[i] = fast_##name##_high(in[i]);      \
+        break;                                                                  \
+    }                                                                           \
+}
+
+FM_BLOCK(exp2)
+FM_BLOCK(log2)
+FM_BLOCK(sin)
+FM_BLOCK(cos)
+FM_BLOCK(tanh)
+FM_BLOCK(db_to_gain)
+FM_BLOCK(gain_to_db)
+
+// Block x^y with a constant exponent
+void fast_pow_block(const double* in, double* out, size_t n, double y, fastmath_tier tier)
+{
+    switch (tier) {
+    case FASTMATH_LOW:
+        for (size_t i = 0; i < n; i++) out[i] = fast_pow_low(in[i], y);
+        break;
+    case FASTMATH_MED:
+        for (size_t i = 0; i < n; i++) out[i] = fast_pow_med(in[i], y);
+        break;
+    default:
+        for (size_t i = 0; i < n; i++) out[i] = fast_pow_high(in[i], y);
+        break;
+    }
+}
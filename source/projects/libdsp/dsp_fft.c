@@ -0,0 +1,164 @@
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "dsp_fft.h"
+
+//------------------------------------------------------------------------------
+// Real FFT
+//
+// An n-point real transform is computed as an n/2-point complex FFT of the
+// even/odd samples packed as re/im, followed by a split step. One table of
+// n/2 twiddles W^k = e^(-2 pi i k / n) serves both the complex stages (as
+// W^(2j)) and the split step.
+//------------------------------------------------------------------------------
+
+struct dsp_fft {
+    size_t n;           // real size
+    size_t m;           // complex size (n / 2)
+    size_t* bitrev;     // m
+    double* w_re;       // m twiddles
+    double* w_im;
+    double* z_re;       // m scratch
+    double* z_im;
+};
+
+dsp_fft* dsp_fft_create(size_t n)
+{
+    if (n < 4 || (n & (n - 1)) != 0) {
+        return NULL;
+    }
+
+    dsp_fft* f = (dsp_fft*)calloc(1, sizeof(dsp_fft));
+    if (!f) {
+        return NULL;
+    }
+    f->n = n;
+    f->m = n / 2;
+    f->bitrev = (size_t*)malloc(sizeof(size_t) * f->m);
+    f->w_re = (double*)malloc(sizeof(double) * f->m);
+    f->w_im = (double*)malloc(sizeof(double) * f->m);
+    f->z_re = (double*)malloc(sizeof(double) * f->m);
+    f->z_im = (double*)malloc(sizeof(double) * f->m);
+    if (!f->bitrev || !f->w_re || !f->w_im || !f->z_re || !f->z_im) {
+        dsp_fft_free(f);
+        return NULL;
+    }
+
+    int bits = 0;
+    while (((size_t)1 << bits) < f->m) {
+        bits++;
+    }
+    for (size_t i = 0; i < f->m; i++) {
+        size_t r = 0;
+        for (int b = 0; b < bits; b++) {
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+        }
+        f->bitrev[i] = r;
+    }
+
+    for (size_t k = 0; k < f->m; k++) {
+        double a = -2.0 * M_PI * (double)k / (double)n;
+        f->w_re[k] = cos(a);
+        f->w_im[k] = sin(a);
+    }
+    return f;
+}
+
+void dsp_fft_free(dsp_fft* f)
+{
+    if (!f) {
+        return;
+    }
+    free(f->bitrev);
+    free(f->w_re);
+    free(f->w_im);
+    free(f->z_re);
+    free(f->z_im);
+    free(f);
+}
+
+size_t dsp_fft_size(const dsp_fft* f)
+{
+    return f->n;
+}
+
+// In-place complex FFT of size m on the scratch arrays (input in bit-reversed
+// order). sign: -1 forward, +1 inverse (unscaled).
+static void fft_complex(dsp_fft* f, double sign)
+{
+    double* re = f->z_re;
+    double* im = f->z_im;
+    size_t m = f->m;
+
+    for (size_t len = 2; len <= m; len <<= 1) {
+        size_t half = len / 2;
+        size_t step = 2 * (m / len);        // W^(2j) = e^(-2 pi i j / m)
+        for (size_t i = 0; i < m; i += len) {
+            for (size_t j = 0; j < half; j++) {
+                double wr = f->w_re[j * step];
+                double wi = sign < 0.0 ? f->w_im[j * step] : -f->w_im[j * step];
+                size_t a = i + j, b = a + half;
+                double tr = re[b] * wr - im[b] * wi;
+                double ti = re[b] * wi + im[b] * wr;
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] += tr;
+                im[a] += ti;
+            }
+        }
+    }
+}
+
+void dsp_fft_forward(dsp_fft* f, const double* x, double* re, double* im)
+{
+    size_t m = f->m;
+    for (size_t i = 0; i < m; i++) {
+        size_t r = f->bitrev[i];
+        f->z_re[r] = x[2 * i];
+        f->z_im[r] = x[2 * i + 1];
+    }
+    fft_complex(f, -1.0);
+
+    // Split: X[k] = E[k] + W^k O[k], with E/O recovered from Z[k] and Z[m-k]
+    re[0] = f->z_re[0] + f->z_im[0];
+    im[0] = 0.0;
+    re[m] = f->z_re[0] - f->z_im[0];
+    im[m] = 0.0;
+    for (size_t k = 1; k < m; k++) {
+        double zr = f->z_re[k], zi = f->z_im[k];
+        double cr = f->z_re[m - k], ci = -f->z_im[m - k];   // conj(Z[m-k])
+        double er = 0.5 * (zr + cr), ei = 0.5 * (zi + ci);
+        double dr = 0.5 * (zr - cr), di = 0.5 * (zi - ci);
+        double or_ = di, oi = -dr;                          // O = D / i
+        double wr = f->w_re[k], wi = f->w_im[k];
+        re[k] = er + wr * or_ - wi * oi;
+        im[k] = ei + wr * oi + wi * or_;
+    }
+}
+
+void dsp_fft_inverse(dsp_fft* f, const double* re, const double* im, double* x)
+{
+    size_t m = f->m;
+
+    // Merge: E[k] = (X[k] + conj(X[m-k])) / 2, O[k] = (X[k] - conj(X[m-k])) / (2 W^k),
+    // Z[k] = E[k] + i O[k], stored bit-reversed for the complex stages
+    for (size_t k = 0; k < m; k++) {
+        double xr = re[k], xi = im[k];
+        double cr = re[m - k], ci = -im[m - k];
+        double er = 0.5 * (xr + cr), ei = 0.5 * (xi + ci);
+        double dr = 0.5 * (xr - cr), di = 0.5 * (xi - ci);
+        double wr = f->w_re[k], wi = -f->w_im[k];           // 1 / W^k = conj(W^k)
+        double or_ = dr * wr - di * wi, oi = dr * wi + di * wr;
+        size_t r = f->bitrev[k];
+        f->z_re[r] = er - oi;
+        f->z_im[r] = ei + or_;
+    }
+    fft_complex(f, 1.0);
+
+    double scale = 1.0 / (double)m;
+    for (size_t i = 0; i < m; i++) {
+        x[2 * i] = f->z_re[i] * scale;
+        x[2 * i + 1] = f->z_im[i] * scale;
+    }
+}
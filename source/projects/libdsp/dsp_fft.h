@@ -0,0 +1,23 @@
+// dsp_fft.h
+// Internal real FFT shared by the libdsp modules (not part of the FFI API)
+
+#ifndef DSP_FFT_H
+#define DSP_FFT_H
+
+#include <stddef.h>
+
+typedef struct dsp_fft dsp_fft;
+
+// Plan for real transforms of n points (n a power of two, >= 4)
+// A plan owns scratch memory: use one plan per thread.
+dsp_fft* dsp_fft_create(size_t n);
+void dsp_fft_free(dsp_fft* f);
+size_t dsp_fft_size(const dsp_fft* f);
+
+// x: n samples -> re, im: n/2 + 1 bins (unscaled)
+void dsp_fft_forward(dsp_fft* f, const double* x, double* re, double* im);
+
+// re, im: n/2 + 1 bins -> x: n samples (scaled by 1/n, so inverse(forward(x)) == x)
+void dsp_fft_inverse(dsp_fft* f, const double* re, const double* im, double* x);
+
+#endif // DSP_FFT_H
@@ -0,0 +1,415 @@
+
+#include <math.h>
+#include <string.h>
+
+#include "libdsp.h"
+
+//------------------------------------------------------------------------------
+// Biquad (RBJ Audio EQ Cookbook, transposed direct form II)
+//------------------------------------------------------------------------------
+
+// Initialise to a pass-through filter with cleared state
+void biquad_init(dsp_biquad* f)
+{
+    memset(f, 0, sizeof(dsp_biquad));
+    f->b0 = 1.0;
+    f->type = -1;   // force the first biquad_set() to compute coefficients
+}
+
+// Clear the filter state, keeping coefficients
+void biquad_reset(dsp_biquad* f)
+{
+    f->z1 = 0.0;
+    f->z2 = 0.0;
+}
+
+// Design the filter
+// type: BIQUAD_LP, BIQUAD_HP, BIQUAD_BP, BIQUAD_BS, BIQUAD_LS, BIQUAD_HS, BIQUAD_EQ, BIQUAD_AP
+// freq: cutoff/centre frequency in Hz
+// q: resonance (0.1 - 100, 0.7071 = Butterworth)
+// gain_db: shelf/peak gain in dB (only used by LS, HS and EQ)
+void biquad_set(dsp_biquad* f, biquad_type type, double freq, double q, double gain_db, double samplerate)
+{
+    if (f->type == (int)type && f->freq == freq && f->q == q &&
+        f->gain == gain_db && f->samplerate == samplerate) {
+        return;
+    }
+    f->type = (int)type;
+    f->freq = freq;
+    f->q = q;
+    f->gain = gain_db;
+    f->samplerate = samplerate;
+
+    double w0 = 2.0 * M_PI * (freq / samplerate);
+    double cos_w0 = cos(w0);
+    double alpha = sin(w0) / (2.0 * q);
+    double A = pow(10.0, gain_db / 40.0);
+    double a0, a1, a2, b0, b1, b2;
+
+    switch (type) {
+    case BIQUAD_HP:
+        b0 = (1.0 + cos_w0) / 2.0; b1 = -(1.0 + cos_w0); b2 = (1.0 + cos_w0) / 2.0;
+        a0 = 1.0 + alpha; a1 = -2.0 * cos_w0; a2 = 1.0 - alpha;
+        break;
+    case BIQUAD_BP:
+        b0 = alpha; b1 = 0.0; b2 = -alpha;
+        a0 = 1.0 + alpha; a1 = -2.0 * cos_w0; a2 = 1.0 - alpha;
+        break;
+    case BIQUAD_BS:
+        b0 = 1.0; b1 = -2.0 * cos_w0; b2 = 1.0;
+        a0 = 1.0 + alpha; a1 = -2.0 * cos_w0; a2 = 1.0 - alpha;
+        break;
+    case BIQUAD_LS: {
+        double ap1 = A + 1.0, am1 = A - 1.0, tsAa = 2.0 * sqrt(A) * alpha;
+        b0 = A * (ap1 - am1 * cos_w0 + tsAa);
+        b1 = 2.0 * A * (am1 - ap1 * cos_w0);
+        b2 = A * (ap1 - am1 * cos_w0 - tsAa);
+        a0 = ap1 + am1 * cos_w0 + tsAa;
+        a1 = -2.0 * (am1 + ap1 * cos_w0);
+        a2 = ap1 + am1 * cos_w0 - tsAa;
+        break;
+    }
+    case BIQUAD_HS: {
+        double ap1 = A + 1.0, am1 = A - 1.0, tsAa = 2.0 * sqrt(A) * alpha;
+        b0 = A * (ap1 + am1 * cos_w0 + tsAa);
+        b1 = -2.0 * A * (am1 + ap1 * cos_w0);
+        b2 = A * (ap1 + am1 * cos_w0 - tsAa);
+        a0 = ap1 - am1 * cos_w0 + tsAa;
+        a1 = 2.0 * (am1 - ap1 * cos_w0);
+        a2 = ap1 - am1 * cos_w0 - tsAa;
+        break;
+    }
+    case BIQUAD_EQ:
+        b0 = 1.0 + alpha * A; b1 = -2.0 * cos_w0; b2 = 1.0 - alpha * A;
+        a0 = 1.0 + alpha / A; a1 = -2.0 * cos_w0; a2 = 1.0 - alpha / A;
+        break;
+    case BIQUAD_AP:
+        b0 = 1.0 - alpha; b1 = -2.0 * cos_w0; b2 = 1.0 + alpha;
+        a0 = 1.0 + alpha; a1 = -2.0 * cos_w0; a2 = 1.0 - alpha;
+        break;
+    case BIQUAD_LP:
+    default:
+        b0 = (1.0 - cos_w0) / 2.0; b1 = 1.0 - cos_w0; b2 = (1.0 - cos_w0) / 2.0;
+        a0 = 1.0 + alpha; a1 = -2.0 * cos_w0; a2 = 1.0 - alpha;
+        break;
+    }
+
+    f->b0 = b0 / a0;
+    f->b1 = b1 / a0;
+    f->b2 = b2 / a0;
+    f->a1 = a1 / a0;
+    f->a2 = a2 / a0;
+}
+
+double biquad_tick(dsp_biquad* f, double x)
+{
+    double y = f->b0 * x + f->z1;
+    f->z1 = f->b1 * x - f->a1 * y + f->z2;
+    f->z2 = f->b2 * x - f->a2 * y;
+    return y;
+}
+
+void biquad_process_block(dsp_biquad* f, const double* in, double* out, size_t n)
+{
+    double b0 = f->b0, b1 = f->b1, b2 = f->b2, a1 = f->a1, a2 = f->a2;
+    double z1 = f->z1, z2 = f->z2;
+    for (size_t i = 0; i < n; i++) {
+        double x = in[i];
+        double y = b0 * x + z1;
+        z1 = b1 * x - a1 * y + z2;
+        z2 = b2 * x - a2 * y;
+        out[i] = y;
+    }
+    f->z1 = z1;
+    f->z2 = z2;
+}
+
+//------------------------------------------------------------------------------
+// State-variable filter (Zavalishin TPT / Simper trapezoidal SVF)
+// Stays stable and keeps its tuning under fast modulation.
+//------------------------------------------------------------------------------
+
+void svf_init(dsp_svf* f)
+{
+    memset(f, 0, sizeof(dsp_svf));
+    f->mode = SVF_LP;
+}
+
+void svf_reset(dsp_svf* f)
+{
+    f->ic1eq = 0.0;
+    f->ic2eq = 0.0;
+    f->lp = f->bp = f->hp = 0.0;
+}
+
+// mode: output returned by svf_tick (lp/bp/hp of the last tick are always available)
+// freq: cutoff frequency in Hz (clamped below Nyquist)
+// q: resonance (0.5 = no peak, higher = more resonant)
+void svf_set(dsp_svf* f, svf_mode mode, double freq, double q, double samplerate)
+{
+    f->mode = (int)mode;
+    if (f->freq == freq && f->q == q && f->samplerate == samplerate) {
+        return;
+    }
+    f->freq = freq;
+    f->q = q;
+    f->samplerate = samplerate;
+
+    double fc = freq < samplerate * 0.49 ? freq : samplerate * 0.49;
+    f->g = tan(M_PI * fc / samplerate);
+    f->k = 1.0 / q;
+    f->a1 = 1.0 / (1.0 + f->g * (f->g + f->k));
+    f->a2 = f->g * f->a1;
+    f->a3 = f->g * f->a2;
+}
+
+// Select the output for a mode from the three core outputs
+static inline double svf_output(int mode, double k, double lp, double bp, double hp)
+{
+    switch (mode) {
+    case SVF_BP:    return bp;
+    case SVF_HP:    return hp;
+    case SVF_NOTCH: return lp + hp;
+    case SVF_PEAK:  return lp - hp;
+    case SVF_AP:    return lp + hp - k * bp;
+    case SVF_LP:
+    default:        return lp;
+    }
+}
+
+double svf_tick(dsp_svf* f, double x)
+{
+    double v3 = x - f->ic2eq;
+    double v1 = f->a1 * f->ic1eq + f->a2 * v3;
+    double v2 = f->ic2eq + f->a2 * f->ic1eq + f->a3 * v3;
+    f->ic1eq = 2.0 * v1 - f->ic1eq;
+    f->ic2eq = 2.0 * v2 - f->ic2eq;
+
+    f->lp = v2;
+    f->bp = v1;
+    f->hp = x - f->k * v1 - v2;
+    return svf_output(f->mode, f->k, f->lp, f->bp, f->hp);
+}
+
+void svf_process_block(dsp_svf* f, const double* in, double* out, size_t n)
+{
+    double a1 = f->a1, a2 = f->a2, a3 = f->a3, k = f->k;
+    double ic1eq = f->ic1eq, ic2eq = f->ic2eq;
+    double v1 = f->bp, v2 = f->lp, hp = f->hp;
+    int mode = f->mode;
+
+    for (size_t i = 0; i < n; i++) {
+        double x = in[i];
+        double v3 = x - ic2eq;
+        v1 = a1 * ic1eq + a2 * v3;
+        v2 = ic2eq + a2 * ic1eq + a3 * v3;
+        ic1eq = 2.0 * v1 - ic1eq;
+        ic2eq = 2.0 * v2 - ic2eq;
+        hp = x - k * v1 - v2;
+        out[i] = svf_output(mode, k, v2, v1, hp);
+    }
+
+    f->ic1eq = ic1eq;
+    f->ic2eq = ic2eq;
+    f->lp = v2;
+    f->bp = v1;
+    f->hp = hp;
+}
+
+//------------------------------------------------------------------------------
+// One-pole low/high pass
+//------------------------------------------------------------------------------
+
+void onepole_init(dsp_onepole* f)
+{
+    memset(f, 0, sizeof(dsp_onepole));
+    f->a0 = 1.0;
+    f->mode = -1;
+}
+
+void onepole_reset(dsp_onepole* f)
+{
+    f->x1 = 0.0;
+    f->y1 = 0.0;
+}
+
+// mode: ONEPOLE_LP or ONEPOLE_HP
+// freq: -3 dB frequency in Hz
+void onepole_set(dsp_onepole* f, onepole_mode mode, double freq, double samplerate)
+{
+    if (f->mode == (int)mode && f->freq == freq && f->samplerate == samplerate) {
+        return;
+    }
+    f->mode = (int)mode;
+    f->freq = freq;
+    f->samplerate = samplerate;
+
+    double b1 = exp(-2.0 * M_PI * freq / samplerate);
+    f->b1 = b1;
+    if (mode == ONEPOLE_HP) {
+        f->a0 = (1.0 + b1) / 2.0;
+        f->a1 = -(1.0 + b1) / 2.0;
+    } else {
+        f->a0 = 1.0 - b1;
+        f->a1 = 0.0;
+    }
+}
+
+double onepole_tick(dsp_onepole* f, double x)
+{
+    double y = f->a0 * x + f->a1 * f->x1 + f->b1 * f->y1;
+    f->x1 = x;
+    f->y1 = y;
+    return y;
+}
+
+void onepole_process_block(dsp_onepole* f, const double* in, double* out, size_t n)
+{
+    double a0 = f->a0, a1 = f->a1, b1 = f->b1;
+    double x1 = f->x1, y1 = f->y1;
+    for (size_t i = 0; i < n; i++) {
+        double x = in[i];
+        y1 = a0 * x + a1 * x1 + b1 * y1;
+        x1 = x;
+        out[i] = y1;
+    }
+    f->x1 = x1;
+    f->y1 = y1;
+}
+
+//------------------------------------------------------------------------------
+// One-zero filter
+//------------------------------------------------------------------------------
+
+void onezero_init(dsp_onezero* f)
+{
+    memset(f, 0, sizeof(dsp_onezero));
+    onezero_set(f, -1.0);   // zero at Nyquist: gentle low pass
+}
+
+void onezero_reset(dsp_onezero* f)
+{
+    f->x1 = 0.0;
+}
+
+// zero: position of the zero on the real axis (-1.0 - 1.0)
+// Gain is normalised to 1 at the frequency furthest from the zero.
+void onezero_set(dsp_onezero* f, double zero)
+{
+    f->zero = zero;
+    f->b0 = 1.0 / (1.0 + fabs(zero));
+    f->b1 = -zero * f->b0;
+}
+
+double onezero_tick(dsp_onezero* f, double x)
+{
+    double y = f->b0 * x + f->b1 * f->x1;
+    f->x1 = x;
+    return y;
+}
+
+void onezero_process_block(dsp_onezero* f, const double* in, double* out, size_t n)
+{
+    double b0 = f->b0, b1 = f->b1;
+    double x1 = f->x1;
+    for (size_t i = 0; i < n; i++) {
+        double x = in[i];
+        out[i] = b0 * x + b1 * x1;
+        x1 = x;
+    }
+    f->x1 = x1;
+}
+
+//------------------------------------------------------------------------------
+// DC blocker
+//------------------------------------------------------------------------------
+
+void dcblock_init(dsp_dcblock* f)
+{
+    memset(f, 0, sizeof(dsp_dcblock));
+    f->r = 0.995;
+}
+
+void dcblock_reset(dsp_dcblock* f)
+{
+    f->x1 = 0.0;
+    f->y1 = 0.0;
+}
+
+// freq: corner frequency in Hz (typically 5 - 30)
+void dcblock_set(dsp_dcblock* f, double freq, double samplerate)
+{
+    if (f->freq == freq && f->samplerate == samplerate) {
+        return;
+    }
+    f->freq = freq;
+    f->samplerate = samplerate;
+    f->r = exp(-2.0 * M_PI * freq / samplerate);
+}
+
+double dcblock_tick(dsp_dcblock* f, double x)
+{
+    double y = x - f->x1 + f->r * f->y1;
+    f->x1 = x;
+    f->y1 = y;
+    return y;
+}
+
+void dcblock_process_block(dsp_dcblock* f, const double* in, double* out, size_t n)
+{
+    double r = f->r;
+    double x1 = f->x1, y1 = f->y1;
+    for (size_t i = 0; i < n; i++) {
+        double x = in[i];
+        y1 = x - x1 + r * y1;
+        x1 = x;
+        out[i] = y1;
+    }
+    f->x1 = x1;
+    f->y1 = y1;
+}
+
+//------------------------------------------------------------------------------
+// Linkwitz-Riley crossover (LR4)
+//------------------------------------------------------------------------------
+
+void crossover_init(dsp_crossover* f)
+{
+    for (int i = 0; i < 2; i++) {
+        biquad_init(&f->lp[i]);
+        biquad_init(&f->hp[i]);
+    }
+}
+
+void crossover_reset(dsp_crossover* f)
+{
+    for (int i = 0; i < 2; i++) {
+        biquad_reset(&f->lp[i]);
+        biquad_reset(&f->hp[i]);
+    }
+}
+
+// freq: crossover frequency in Hz (both bands are -6 dB here)
+void crossover_set(dsp_crossover* f, double freq, double samplerate)
+{
+    for (int i = 0; i < 2; i++) {
+        biquad_set(&f->lp[i], BIQUAD_LP, freq, M_SQRT1_2, 0.0, samplerate);
+        biquad_set(&f->hp[i], BIQUAD_HP, freq, M_SQRT1_2, 0.0, samplerate);
+    }
+}
+
+void crossover_tick(dsp_crossover* f, double x, double* low, double* high)
+{
+    *low = biquad_tick(&f->lp[1], biquad_tick(&f->lp[0], x));
+    *high = biquad_tick(&f->hp[1], biquad_tick(&f->hp[0], x));
+}
+
+// low and high may not alias each other; either may alias in
+void crossover_process_block(dsp_crossover* f, const double* in, double* low, double* high, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        double x = in[i];
+        low[i] = biquad_tick(&f->lp[1], biquad_tick(&f->lp[0], x));
+        high[i] = biquad_tick(&f->hp[1], biquad_tick(&f->hp[0], x));
+    }
+}
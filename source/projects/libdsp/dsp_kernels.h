@@ -0,0 +1,289 @@
+// dsp_kernels.h
+// Element-wise block kernels, compiled once per instruction set
+//
+// Not a normal header: dsp_dispatch.c includes it several times, each time
+// with DSP_ISA (name suffix) and DSP_TARGET (function target attribute)
+// defined, producing e.g. soft_clip_block_avx2() and the table
+// dsp_kernels_avx2. Keep the loops branch-free (selects only) and free of
+// libm calls other than floor/round so every variant vectorises.
+
+#ifndef DSP_ISA
+#error "dsp_kernels.h is included by dsp_dispatch.c only"
+#endif
+
+// Block version of scale_linear
+static DSP_TARGET void
+DSP_KERNEL(scale_linear_block)(const double* restrict in, double* restrict out, size_t n,
+                               double i_min, double i_max, double o_min, double o_max)
+{
+    double slope = 1.0 * (o_max - o_min) / (i_max - i_min);
+    for (size_t i = 0; i < n; i++) {
+        out[i] = o_min + round(slope * (in[i] - i_min));
+    }
+}
+
+// Block version of soft_clip
+static DSP_TARGET void
+DSP_KERNEL(soft_clip_block)(const double* restrict in, double* restrict out, size_t n, double drive)
+{
+    for (size_t i = 0; i < n; i++) {
+        double shaped = in[i] * drive;
+        out[i] = shaped / (1.0 + fabs(shaped));
+    }
+}
+
+// Block version of hard_clip
+static DSP_TARGET void
+DSP_KERNEL(hard_clip_block)(const double* restrict in, double* restrict out, size_t n,
+                            double threshold)
+{
+    for (size_t i = 0; i < n; i++) {
+        double x = in[i];
+        x = (x > threshold) ? threshold : x;
+        out[i] = (x < -threshold) ? -threshold : x;
+    }
+}
+
+// Block version of bit_crush (quantisation step computed once per block)
+static DSP_TARGET void
+DSP_KERNEL(bit_crush_block)(const double* restrict in, double* restrict out, size_t n, double bits)
+{
+    if (bits <= 0 || bits >= 16) {
+        for (size_t i = 0; i < n; i++) {
+            out[i] = in[i];
+        }
+        return;
+    }
+
+    double step = 2.0 / exp2(bits);
+    double inv_step = 1.0 / step;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = floor(in[i] * inv_step) * step;
+    }
+}
+
+// Block version of lerp: out[i] = a[i] + t * (b[i] - a[i])
+static DSP_TARGET void
+DSP_KERNEL(lerp_block)(const double* restrict a, const double* restrict b, double* restrict out,
+                       size_t n, double t)
+{
+    for (size_t i = 0; i < n; i++) {
+        out[i] = a[i] + t * (b[i] - a[i]);
+    }
+}
+
+// Block version of wavefold
+// Uses the closed form of repeated reflection (a triangle wave of period
+// 4 * threshold), so the cost no longer grows with the input level.
+static DSP_TARGET void
+DSP_KERNEL(wavefold_block)(const double* restrict in, double* restrict out, size_t n,
+                           double threshold)
+{
+    if (threshold <= 0) {
+        for (size_t i = 0; i < n; i++) {
+            out[i] = in[i];
+        }
+        return;
+    }
+
+    double period = 4.0 * threshold;
+    double inv_period = 1.0 / period;
+    for (size_t i = 0; i < n; i++) {
+        double y = in[i] + threshold;
+        double m = y - period * floor(y * inv_period);
+        out[i] = ((m < 2.0 * threshold) ? m : period - m) - threshold;
+    }
+}
+
+// Block version of ring_mod: out[i] = in[i] * mod[i]
+static DSP_TARGET void
+DSP_KERNEL(ring_mod_block)(const double* restrict in, const double* restrict mod,
+                           double* restrict out, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        out[i] = in[i] * mod[i];
+    }
+}
+
+// Block version of clamp
+static DSP_TARGET void
+DSP_KERNEL(clamp_block)(const double* restrict in, double* restrict out, size_t n,
+                        double min, double max)
+{
+    for (size_t i = 0; i < n; i++) {
+        double x = in[i];
+        x = (x < min) ? min : x;
+        out[i] = (x > max) ? max : x;
+    }
+}
+
+// Block version of osc_saw (in: phases 0.0 - 1.0)
+static DSP_TARGET void
+DSP_KERNEL(osc_saw_block)(const double* restrict in, double* restrict out, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        out[i] = 2.0 * in[i] - 1.0;
+    }
+}
+
+// Block version of osc_saw_bl (in: phases 0.0 - 1.0)
+static DSP_TARGET void
+DSP_KERNEL(osc_saw_bl_block)(const double* restrict in, double* restrict out, size_t n,
+                             double phase_inc)
+{
+    double inv_inc = 1.0 / phase_inc;
+    for (size_t i = 0; i < n; i++) {
+        double phase = in[i];
+        double value = 2.0 * phase - 1.0;
+
+        // PolyBLEP residual, computed for both edges and selected
+        double t0 = phase * inv_inc;
+        double t1 = (phase - 1.0) * inv_inc;
+        double r0 = 2.0 * (t0 + t0 * (1.0 - t0));
+        double r1 = 2.0 * (t1 + t1 * (1.0 + t1));
+        double r = (phase > 1.0 - phase_inc) ? r1 : 0.0;
+        r = (phase < phase_inc) ? r0 : r;
+        value += r;
+
+        out[i] = value;
+    }
+}
+
+// Block version of osc_square (in: phases 0.0 - 1.0)
+static DSP_TARGET void
+DSP_KERNEL(osc_square_block)(const double* restrict in, double* restrict out, size_t n,
+                             double pulse_width)
+{
+    for (size_t i = 0; i < n; i++) {
+        out[i] = (in[i] < pulse_width) ? 1.0 : -1.0;
+    }
+}
+
+// Block version of osc_square_bl (in: phases 0.0 - 1.0)
+static DSP_TARGET void
+DSP_KERNEL(osc_square_bl_block)(const double* restrict in, double* restrict out, size_t n,
+                                double pulse_width, double phase_inc)
+{
+    double inv_inc = 1.0 / phase_inc;
+    for (size_t i = 0; i < n; i++) {
+        double phase = in[i];
+        double value = (phase < pulse_width) ? 1.0 : -1.0;
+
+        // PolyBLEP at rising edge (phase = 0)
+        double t = phase;
+        double a = t * inv_inc;
+        double b = (t - 1.0) * inv_inc;
+        double ra = 2.0 * (a - a * a - 1.0);
+        double rb = 2.0 * (b * b + b + 1.0);
+        double r = (t > 1.0 - phase_inc) ? rb : 0.0;
+        r = (t < phase_inc) ? ra : r;
+        value += r;
+
+        // PolyBLEP at falling edge (phase = pulse_width)
+        t = phase - pulse_width;
+        t = (t < 0.0) ? t + 1.0 : t;
+        a = t * inv_inc;
+        b = (t - 1.0) * inv_inc;
+        ra = 2.0 * (a - a * a - 1.0);
+        rb = 2.0 * (b * b + b + 1.0);
+        r = (t > 1.0 - phase_inc) ? rb : 0.0;
+        r = (t < phase_inc) ? ra : r;
+        value -= r;
+
+        out[i] = value;
+    }
+}
+
+// Block version of osc_triangle (in: phases 0.0 - 1.0)
+static DSP_TARGET void
+DSP_KERNEL(osc_triangle_block)(const double* restrict in, double* restrict out, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        double phase = in[i];
+        double rising = 4.0 * phase - 1.0;
+        double falling = -4.0 * phase + 3.0;
+        out[i] = (phase < 0.5) ? rising : falling;
+    }
+}
+
+// Additive bank (see dsp_additive.c): a group of DSP_ADDITIVE_LANES partials
+// rotates in parallel for a chunk of samples. Each lane is a serial
+// multiply chain, so the group has to span several vectors to hide its
+// latency. Lane sums are accumulated vertically and reduced once per sample
+// at the end of the chunk, keeping horizontal adds out of the inner loop.
+static DSP_TARGET void
+DSP_KERNEL(additive_render)(double* restrict re, double* restrict im,
+                            const double* restrict rot_re, const double* restrict rot_im,
+                            double* restrict amp, const double* restrict amp_step, size_t count,
+                            double* restrict out, size_t n)
+{
+    enum { L = DSP_ADDITIVE_LANES, CHUNK = 64 };
+    double acc[CHUNK][L];
+
+    for (size_t i0 = 0; i0 < n; i0 += CHUNK) {
+        size_t len = (n - i0 < CHUNK) ? n - i0 : CHUNK;
+        memset(acc, 0, sizeof(acc));
+
+        for (size_t k = 0; k < count; k += L) {
+            double r[L], s[L], cr[L], ci[L], a[L], da[L];
+            for (size_t j = 0; j < L; j++) {
+                r[j] = re[k + j];
+                s[j] = im[k + j];
+                cr[j] = rot_re[k + j];
+                ci[j] = rot_im[k + j];
+                a[j] = amp[k + j];
+                da[j] = amp_step[k + j];
+            }
+
+            for (size_t i = 0; i < len; i++) {
+                for (size_t j = 0; j < L; j++) {
+                    acc[i][j] += a[j] * s[j];
+                    double nr = r[j] * cr[j] - s[j] * ci[j];
+                    s[j] = r[j] * ci[j] + s[j] * cr[j];
+                    r[j] = nr;
+                    a[j] += da[j];
+                }
+            }
+
+            for (size_t j = 0; j < L; j++) {
+                re[k + j] = r[j];
+                im[k + j] = s[j];
+                amp[k + j] = a[j];
+            }
+        }
+
+        for (size_t i = 0; i < len; i++) {
+            double sum = 0.0;
+            for (size_t j = 0; j < L; j++) {
+                sum += acc[i][j];
+            }
+            out[i0 + i] = sum;
+        }
+    }
+
+    // One Newton step back onto the unit circle per call keeps the rounding
+    // drift of the rotation from growing
+    for (size_t k = 0; k < count; k++) {
+        double g = 1.5 - 0.5 * (re[k] * re[k] + im[k] * im[k]);
+        re[k] *= g;
+        im[k] *= g;
+    }
+}
+
+static const dsp_kernel_table DSP_KERNEL(dsp_kernels) = {
+    DSP_STR(DSP_ISA),
+    DSP_KERNEL(scale_linear_block),
+    DSP_KERNEL(soft_clip_block),
+    DSP_KERNEL(hard_clip_block),
+    DSP_KERNEL(bit_crush_block),
+    DSP_KERNEL(lerp_block),
+    DSP_KERNEL(wavefold_block),
+    DSP_KERNEL(ring_mod_block),
+    DSP_KERNEL(clamp_block),
+    DSP_KERNEL(osc_saw_block),
+    DSP_KERNEL(osc_saw_bl_block),
+    DSP_KERNEL(osc_square_block),
+    DSP_KERNEL(osc_square_bl_block),
+    DSP_KERNEL(osc_triangle_block),
+    DSP_KERNEL(additive_render),
+};
@@ -0,0 +1,239 @@
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libdsp.h"
+
+//------------------------------------------------------------------------------
+// Freeverb
+//
+// Jezar's public domain Schroeder/Moorer reverb: per channel, eight lowpass-
+// feedback combs in parallel followed by four allpasses in series. The right
+// channel's delays are 23 samples longer, which decorrelates the outputs.
+// Delay lengths are the original tunings for 44.1 kHz, scaled to the sample
+// rate given at creation. All 24 buffers share one allocation.
+//------------------------------------------------------------------------------
+
+#define REVERB_COMBS 8
+#define REVERB_ALLPASSES 4
+#define REVERB_SPREAD 23
+
+#define REVERB_FIXED_GAIN 0.015
+#define REVERB_SCALE_ROOM 0.28
+#define REVERB_OFFSET_ROOM 0.7
+#define REVERB_SCALE_DAMP 0.4
+#define REVERB_ALLPASS_FEEDBACK 0.5
+
+static const int comb_tuning[REVERB_COMBS] = { 1116, 1188, 1277, 1356, 1422, 1491, 1557, 1617 };
+static const int allpass_tuning[REVERB_ALLPASSES] = { 556, 441, 341, 225 };
+
+typedef struct {
+    double* buf;
+    size_t size;
+    size_t pos;
+    double store;       // damping lowpass state
+} rv_comb;
+
+typedef struct {
+    double* buf;
+    size_t size;
+    size_t pos;
+} rv_allpass;
+
+struct dsp_freeverb {
+    rv_comb comb[2][REVERB_COMBS];
+    rv_allpass allpass[2][REVERB_ALLPASSES];
+    double* mem;
+    size_t mem_size;
+
+    double feedback, damp1, damp2;  // derived
+    double wet1, wet2, dry;
+    double room, damp, wet, dry_gain, width;    // cached parameters
+    double allpass_feedback;
+    int lowpass;                    // 0: damping only scales the comb feedback
+};
+
+static size_t rv_length(int tuning, int channel, double samplerate)
+{
+    double n = (double)(tuning + channel * REVERB_SPREAD) * samplerate / 44100.0;
+    return n < 1.0 ? 1 : (size_t)(n + 0.5);
+}
+
+// Recirculating state decays into denormals once the input goes silent
+static inline double rv_flush(double x)
+{
+    return fabs(x) < 1e-30 ? 0.0 : x;
+}
+
+// Create a stereo reverb (room 0.5, damp 0.5, wet 1/3, dry 0, width 1)
+// Returns NULL on failure; release with freeverb_free()
+dsp_freeverb* freeverb_create(double samplerate)
+{
+    if (samplerate <= 0.0) {
+        return NULL;
+    }
+    dsp_freeverb* r = (dsp_freeverb*)calloc(1, sizeof(dsp_freeverb));
+    if (!r) {
+        return NULL;
+    }
+
+    size_t total = 0;
+    for (int c = 0; c < 2; c++) {
+        for (int i = 0; i < REVERB_COMBS; i++) {
+            total += rv_length(comb_tuning[i], c, samplerate);
+        }
+        for (int i = 0; i < REVERB_ALLPASSES; i++) {
+            total += rv_length(allpass_tuning[i], c, samplerate);
+        }
+    }
+    r->mem = (double*)calloc(total, sizeof(double));
+    if (!r->mem) {
+        free(r);
+        return NULL;
+    }
+    r->mem_size = total;
+
+    double* p = r->mem;
+    for (int c = 0; c < 2; c++) {
+        for (int i = 0; i < REVERB_COMBS; i++) {
+            r->comb[c][i].buf = p;
+            r->comb[c][i].size = rv_length(comb_tuning[i], c, samplerate);
+            p += r->comb[c][i].size;
+        }
+        for (int i = 0; i < REVERB_ALLPASSES; i++) {
+            r->allpass[c][i].buf = p;
+            r->allpass[c][i].size = rv_length(allpass_tuning[i], c, samplerate);
+            p += r->allpass[c][i].size;
+        }
+    }
+
+    r->allpass_feedback = REVERB_ALLPASS_FEEDBACK;
+    r->lowpass = 1;
+    r->room = -1.0;     // force freeverb_set() to derive the gains
+    freeverb_set(r, 0.5, 0.5, 1.0 / 3.0, 0.0, 1.0);
+    return r;
+}
+
+void freeverb_free(dsp_freeverb* r)
+{
+    if (!r) {
+        return;
+    }
+    free(r->mem);
+    free(r);
+}
+
+// Clear the tail, keeping the parameters
+void freeverb_reset(dsp_freeverb* r)
+{
+    memset(r->mem, 0, sizeof(double) * r->mem_size);
+    for (int c = 0; c < 2; c++) {
+        for (int i = 0; i < REVERB_COMBS; i++) {
+            r->comb[c][i].pos = 0;
+            r->comb[c][i].store = 0.0;
+        }
+        for (int i = 0; i < REVERB_ALLPASSES; i++) {
+            r->allpass[c][i].pos = 0;
+        }
+    }
+}
+
+// room: 0.0 - 1.0 (up to ~1.07 before the combs self-oscillate)
+// damp: 0.0 - 1.0 high frequency damping
+// wet, dry: output gains
+// width: stereo width of the wet signal, 0.0 (mono) - 1.0
+// Only rederives the gains when a parameter changes.
+void freeverb_set(dsp_freeverb* r, double room, double damp, double wet, double dry, double width)
+{
+    if (r->room == room && r->damp == damp && r->wet == wet && r->dry_gain == dry &&
+        r->width == width) {
+        return;
+    }
+    r->room = room;
+    r->damp = damp;
+    r->wet = wet;
+    r->dry_gain = dry;
+    r->width = width;
+
+    r->feedback = room * REVERB_SCALE_ROOM + REVERB_OFFSET_ROOM;
+    r->damp1 = damp * REVERB_SCALE_DAMP;
+    r->damp2 = 1.0 - r->damp1;
+    if (!r->lowpass) {
+        r->damp1 = 0.0;     // no filter memory: store = y * damp2
+    }
+    r->wet1 = wet * (width / 2.0 + 0.5);
+    r->wet2 = wet * ((1.0 - width) / 2.0);
+    r->dry = dry;
+}
+
+// Voicing of the diffusion stage and the comb damping. Freeverb proper (the
+// default) uses allpass feedback 0.5 and a one-pole lowpass in each comb;
+// lowpass 0 drops the filter memory so damping only scales the feedback.
+void freeverb_set_voicing(dsp_freeverb* r, double allpass_feedback, int lowpass)
+{
+    r->allpass_feedback = allpass_feedback;
+    r->lowpass = lowpass != 0;
+
+    double room = r->room;
+    r->room = -1.0;     // rederive damp1 with the current parameters
+    freeverb_set(r, room, r->damp, r->wet, r->dry_gain, r->width);
+}
+
+static inline double rv_comb_tick(rv_comb* cb, double x, double feedback, double damp1, double damp2)
+{
+    double y = cb->buf[cb->pos];
+    cb->store = rv_flush(y * damp2 + cb->store * damp1);
+    cb->buf[cb->pos] = x + cb->store * feedback;
+    if (++cb->pos == cb->size) {
+        cb->pos = 0;
+    }
+    return y;
+}
+
+static inline double rv_allpass_tick(rv_allpass* ap, double x, double feedback)
+{
+    double delayed = ap->buf[ap->pos];
+    ap->buf[ap->pos] = rv_flush(x + delayed * feedback);
+    if (++ap->pos == ap->size) {
+        ap->pos = 0;
+    }
+    return delayed - x;
+}
+
+static inline void rv_tick(dsp_freeverb* r, double in1, double in2, double* out1, double* out2)
+{
+    double input = (in1 + in2) * REVERB_FIXED_GAIN;
+    double y[2];
+    for (int c = 0; c < 2; c++) {
+        double acc = 0.0;
+        for (int i = 0; i < REVERB_COMBS; i++) {
+            acc += rv_comb_tick(&r->comb[c][i], input, r->feedback, r->damp1, r->damp2);
+        }
+        for (int i = 0; i < REVERB_ALLPASSES; i++) {
+            acc = rv_allpass_tick(&r->allpass[c][i], acc, r->allpass_feedback);
+        }
+        y[c] = acc;
+    }
+    *out1 = y[0] * r->wet1 + y[1] * r->wet2 + in1 * r->dry;
+    *out2 = y[1] * r->wet1 + y[0] * r->wet2 + in2 * r->dry;
+}
+
+// One stereo frame; feed the same sample to in1 and in2 for a mono source
+void freeverb_tick(dsp_freeverb* r, double in1, double in2, double* out1, double* out2)
+{
+    rv_tick(r, in1, in2, out1, out2);
+}
+
+// in2 may be NULL for a mono source; outputs may alias the inputs
+void freeverb_process_block(dsp_freeverb* r, const double* in1, const double* in2,
+                            double* out1, double* out2, size_t n)
+{
+    if (!in2) {
+        in2 = in1;
+    }
+    for (size_t i = 0; i < n; i++) {
+        double a = in1[i], b = in2[i];
+        rv_tick(r, a, b, &out1[i], &out2[i]);
+    }
+}
@@ -0,0 +1,193 @@
+
+#include <math.h>
+#include <string.h>
+
+#include "libdsp.h"
+
+//------------------------------------------------------------------------------
+// Scaler Objects
+//
+// The scale_* curves with their constants folded once per parameter change.
+// Every curve has the form
+//
+//   y = a * F(b * (x - d)) + c
+//
+//   SCALE_LINEAR    F = round           SCALE_EXP1/2    F = exp2
+//   SCALE_SINE1     F = cos             SCALE_LOG1/2    F = log2|.|   (b = 1)
+//   SCALE_SINE2     F = asin
+//
+// The exponential curves run in double precision (exp2 of a folded log2)
+// where scale_exp* calls powf, so the two agree to float precision only.
+// With a lookup table enabled, inputs are rounded to the nearest integer in
+// the table range (MIDI values, 7-bit controllers) and read back without
+// evaluating the curve.
+//------------------------------------------------------------------------------
+
+// Evaluate the folded curve (never the table)
+static double scaler_eval(const dsp_scaler* s, double x)
+{
+    double t = s->b * (x - s->d);
+    switch (s->curve) {
+    case SCALE_SINE1:
+        return s->a * cos(t) + s->c;
+    case SCALE_SINE2:
+        return s->a * asin(t) + s->c;
+    case SCALE_EXP1:
+    case SCALE_EXP2:
+        return s->a * exp2(t) + s->c;
+    case SCALE_LOG1:
+    case SCALE_LOG2:
+        return s->a * log2(fabs(t)) + s->c;
+    default:
+        return s->a * round(t) + s->c;
+    }
+}
+
+static void scaler_fold(dsp_scaler* s)
+{
+    double i_min = s->i_min, i_max = s->i_max;
+    double o_min = s->o_min, o_max = s->o_max;
+    double k = s->shape;
+
+    switch (s->curve) {
+    case SCALE_SINE1:
+        s->a = -(o_max - o_min) / 2.0;
+        s->b = M_PI / (i_max - i_min);
+        s->c = (o_max + o_min) / 2.0;
+        s->d = i_min;
+        break;
+    case SCALE_SINE2:
+        s->a = (o_max - o_min) / M_PI;
+        s->b = 2.0 / (i_max - i_min);
+        s->c = (o_max + o_min) / 2.0;
+        s->d = (i_min + i_max) / 2.0;
+        break;
+    case SCALE_EXP1:    // -k * |o_min - o_max - k|^((x - i_max) / (i_min - i_max)) + o_max + k
+        s->a = -k;
+        s->b = log2(fabs(o_min - o_max - k)) / (i_min - i_max);
+        s->c = o_max + k;
+        s->d = i_max;
+        break;
+    case SCALE_EXP2:    // k * |o_max - o_min + k|^((x - i_min) / (i_max - i_min)) + o_min - k
+        s->a = k;
+        s->b = log2(fabs(o_max - o_min + k)) / (i_max - i_min);
+        s->c = o_min - k;
+        s->d = i_min;
+        break;
+    case SCALE_LOG1:    // (o_max - o_min) * log|x - i_min + k| / log|i_max - i_min + k| + o_min
+        s->a = (o_max - o_min) / log2(fabs(i_max - i_min + k));
+        s->b = 1.0;
+        s->c = o_min;
+        s->d = i_min - k;
+        break;
+    case SCALE_LOG2:    // (o_min - o_max) * log|x - i_max - k| / log|i_min - i_max - k| + o_max
+        s->a = (o_min - o_max) / log2(fabs(i_min - i_max - k));
+        s->b = 1.0;
+        s->c = o_max;
+        s->d = i_max + k;
+        break;
+    default:            // o_min + round(slope * (x - i_min))
+        s->a = 1.0;
+        s->b = (o_max - o_min) / (i_max - i_min);
+        s->c = o_min;
+        s->d = i_min;
+        break;
+    }
+}
+
+static void scaler_fill_lut(dsp_scaler* s)
+{
+    for (int i = 0; i < s->lut_size; i++) {
+        s->lut[i] = scaler_eval(s, (double)(s->lut_first + i));
+    }
+}
+
+// Identity mapping 0..1 -> 0..1, no table
+void scaler_init(dsp_scaler* s)
+{
+    memset(s, 0, sizeof(dsp_scaler));
+    s->curve = SCALE_LINEAR;
+    s->i_max = 1.0;
+    s->o_max = 1.0;
+    scaler_fold(s);
+}
+
+// curve: SCALE_LINEAR .. SCALE_LOG2
+// shape: s of scale_exp* / p of scale_log*, ignored by the other curves
+// Only refolds (and refills the table) when a parameter changes.
+void scaler_set(dsp_scaler* s, scale_curve curve, double shape,
+                double i_min, double i_max, double o_min, double o_max)
+{
+    if ((int)curve == s->curve && shape == s->shape && i_min == s->i_min &&
+        i_max == s->i_max && o_min == s->o_min && o_max == s->o_max) {
+        return;
+    }
+    s->curve = curve;
+    s->shape = shape;
+    s->i_min = i_min;
+    s->i_max = i_max;
+    s->o_min = o_min;
+    s->o_max = o_max;
+    scaler_fold(s);
+    scaler_fill_lut(s);
+}
+
+// Tabulate the integer inputs first .. first + count - 1 (count up to
+// SCALER_LUT_SIZE, e.g. 0, 128 for MIDI); count 0 switches the table off
+void scaler_set_lut(dsp_scaler* s, int first, int count)
+{
+    if (count < 0) count = 0;
+    if (count > SCALER_LUT_SIZE) count = SCALER_LUT_SIZE;
+    s->lut_first = first;
+    s->lut_size = count;
+    scaler_fill_lut(s);
+}
+
+static inline double scaler_lut_read(const dsp_scaler* s, double x)
+{
+    double pos = x - (double)s->lut_first;
+    double last = (double)(s->lut_size - 1);
+    pos = pos < 0.0 ? 0.0 : (pos > last ? last : pos);
+    return s->lut[(int)(pos + 0.5)];
+}
+
+double scaler_map(const dsp_scaler* s, double x)
+{
+    if (s->lut_size > 0) {
+        return scaler_lut_read(s, x);
+    }
+    return scaler_eval(s, x);
+}
+
+// Map n values; in and out may be the same array
+void scaler_process_block(const dsp_scaler* s, const double* in, double* out, size_t n)
+{
+    if (s->lut_size > 0) {
+        for (size_t i = 0; i < n; i++) {
+            out[i] = scaler_lut_read(s, in[i]);
+        }
+        return;
+    }
+
+    // One loop per curve so each body is a single expression
+    double a = s->a, b = s->b, c = s->c, d = s->d;
+    switch (s->curve) {
+    case SCALE_SINE1:
+        for (size_t i = 0; i < n; i++) out[i] = a * cos(b * (in[i] - d)) + c;
+        break;
+    case SCALE_SINE2:
+        for (size_t i = 0; i < n; i++) out[i] = a * asin(b * (in[i] - d)) + c;
+        break;
+    case SCALE_EXP1:
+    case SCALE_EXP2:
+        for (size_t i = 0; i < n; i++) out[i] = a * exp2(b * (in[i] - d)) + c;
+        break;
+    case SCALE_LOG1:
+    case SCALE_LOG2:
+        for (size_t i = 0; i < n; i++) out[i] = a * log2(fabs(b * (in[i] - d))) + c;
+        break;
+    default:
+        for (size_t i = 0; i < n; i++) out[i] = a * round(b * (in[i] - d)) + c;
+        break;
+    }
+}
@@ -0,0 +1,337 @@
+
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libdsp.h"
+#include "dsp_fft.h"
+
+//------------------------------------------------------------------------------
+// Mipmapped Wavetables
+//
+// A table holds one cycle at WAVETABLE_SIZE points for each of WAVETABLE_LEVELS
+// octaves. Level l keeps harmonics 1 .. (WAVETABLE_SIZE / 2) >> l, so it is
+// alias-free for phase increments up to 2^l / WAVETABLE_SIZE. Every level has
+// one guard point (data[WAVETABLE_SIZE] == data[0]) so interpolation never
+// wraps its index.
+//------------------------------------------------------------------------------
+
+#define WAVETABLE_STRIDE (WAVETABLE_SIZE + 1)
+
+struct dsp_wavetable {
+    double data[WAVETABLE_LEVELS * WAVETABLE_STRIDE];
+};
+
+// Shared built-in tables, see wavetable_builtin()
+static dsp_wavetable* builtin_tables[WT_NUM_SHAPES];
+static pthread_once_t builtin_once = PTHREAD_ONCE_INIT;
+
+// Fill every level of wt from a forward spectrum (bins 0 .. WAVETABLE_SIZE/2)
+// Returns 0 on success, -1 if scratch memory could not be allocated
+static int wt_build_levels(dsp_wavetable* wt, const double* spec_re, const double* spec_im)
+{
+    const int n = WAVETABLE_SIZE;
+    dsp_fft* fft = dsp_fft_create(n);
+    double* re = (double*)malloc(sizeof(double) * (n / 2 + 1));
+    double* im = (double*)malloc(sizeof(double) * (n / 2 + 1));
+    if (!fft || !re || !im) {
+        dsp_fft_free(fft);
+        free(re);
+        free(im);
+        return -1;
+    }
+
+    for (int level = 0; level < WAVETABLE_LEVELS; level++) {
+        int harmonics = (n / 2) >> level;
+
+        for (int k = 0; k <= n / 2; k++) {
+            re[k] = k <= harmonics ? spec_re[k] : 0.0;
+            im[k] = k <= harmonics ? spec_im[k] : 0.0;
+        }
+
+        double* table = wt->data + level * WAVETABLE_STRIDE;
+        dsp_fft_inverse(fft, re, im, table);
+        table[n] = table[0];
+    }
+
+    dsp_fft_free(fft);
+    free(re);
+    free(im);
+    return 0;
+}
+
+// Build a table from one cycle of arbitrary length, linearly resampled
+static dsp_wavetable* wt_create_resampled(const void* samples, size_t frames, size_t stride, int is_float)
+{
+    const int n = WAVETABLE_SIZE;
+    if (frames == 0) {
+        return NULL;
+    }
+    if (stride == 0) {
+        stride = 1;
+    }
+
+    dsp_wavetable* wt = (dsp_wavetable*)malloc(sizeof(dsp_wavetable));
+    dsp_fft* fft = dsp_fft_create(n);
+    double* cycle = (double*)malloc(sizeof(double) * n);
+    double* re = (double*)malloc(sizeof(double) * (n / 2 + 1));
+    double* im = (double*)malloc(sizeof(double) * (n / 2 + 1));
+    if (!wt || !fft || !cycle || !re || !im) {
+        free(wt);
+        dsp_fft_free(fft);
+        free(cycle);
+        free(re);
+        free(im);
+        return NULL;
+    }
+
+    for (int i = 0; i < n; i++) {
+        double pos = (double)i * (double)frames / (double)n;
+        size_t i0 = (size_t)pos;
+        size_t i1 = (i0 + 1) % frames;
+        double frac = pos - (double)i0;
+        double a, b;
+        if (is_float) {
+            a = ((const float*)samples)[i0 * stride];
+            b = ((const float*)samples)[i1 * stride];
+        } else {
+            a = ((const double*)samples)[i0 * stride];
+            b = ((const double*)samples)[i1 * stride];
+        }
+        cycle[i] = a + (b - a) * frac;
+    }
+
+    dsp_fft_forward(fft, cycle, re, im);
+
+    if (wt_build_levels(wt, re, im) != 0) {
+        free(wt);
+        wt = NULL;
+    }
+    dsp_fft_free(fft);
+    free(cycle);
+    free(re);
+    free(im);
+    return wt;
+}
+
+// Create a table from one cycle of a waveform in doubles (e.g. a Lua table
+// copied into ffi.new("double[?]", n, t))
+// samples: one cycle, any length (resampled to WAVETABLE_SIZE)
+// Returns NULL on failure; release with wavetable_free()
+dsp_wavetable* wavetable_create(const double* samples, size_t n)
+{
+    return wt_create_resampled(samples, n, 1, 0);
+}
+
+// Create a table from float samples, e.g. one channel of buffer~ memory
+// frames: number of frames making up one cycle
+// stride: distance between frames in samples (the buffer~ channel count)
+dsp_wavetable* wavetable_create_float(const float* samples, size_t frames, size_t stride)
+{
+    return wt_create_resampled(samples, frames, stride, 1);
+}
+
+// Release a table created with wavetable_create*(); built-in tables are ignored
+void wavetable_free(dsp_wavetable* wt)
+{
+    for (int s = 0; s < WT_NUM_SHAPES; s++) {
+        if (wt == builtin_tables[s]) {
+            return;
+        }
+    }
+    free(wt);
+}
+
+//------------------------------------------------------------------------------
+// Built-in Tables
+//
+// Generated once per process from their Fourier series and shared by every
+// oscillator. Phase alignment matches osc_sine, osc_saw, osc_square (pulse
+// width 0.5) and osc_triangle.
+//------------------------------------------------------------------------------
+
+static void wt_build_builtins(void)
+{
+    const int n = WAVETABLE_SIZE;
+    double* re = (double*)malloc(sizeof(double) * (n / 2 + 1));
+    double* im = (double*)malloc(sizeof(double) * (n / 2 + 1));
+    if (!re || !im) {
+        free(re);
+        free(im);
+        return;
+    }
+
+    // Forward FFT bin of A*sin(2*pi*k*phase) is -i*A*n/2, of A*cos(...) is A*n/2
+    double half = n / 2.0;
+
+    for (int s = 0; s < WT_NUM_SHAPES; s++) {
+        memset(re, 0, sizeof(double) * (n / 2 + 1));
+        memset(im, 0, sizeof(double) * (n / 2 + 1));
+
+        for (int k = 1; k < n / 2; k++) {
+            switch (s) {
+            case WT_SINE:
+                if (k == 1) {
+                    im[k] = -half;
+                }
+                break;
+            case WT_SAW:        // 2*phase - 1 = -(2/pi) sum sin(k)/k
+                im[k] = half * 2.0 / (M_PI * k);
+                break;
+            case WT_SQUARE:     // (4/pi) sum_odd sin(k)/k
+                if (k & 1) {
+                    im[k] = -half * 4.0 / (M_PI * k);
+                }
+                break;
+            case WT_TRIANGLE:   // -(8/pi^2) sum_odd cos(k)/k^2
+                if (k & 1) {
+                    re[k] = -half * 8.0 / (M_PI * M_PI * k * k);
+                }
+                break;
+            }
+        }
+
+        dsp_wavetable* wt = (dsp_wavetable*)malloc(sizeof(dsp_wavetable));
+        if (wt && wt_build_levels(wt, re, im) != 0) {
+            free(wt);
+            wt = NULL;
+        }
+        builtin_tables[s] = wt;
+    }
+
+    free(re);
+    free(im);
+}
+
+// Shared built-in table (WT_SINE, WT_SAW, WT_SQUARE, WT_TRIANGLE)
+// Built on first use; never free the result.
+const dsp_wavetable* wavetable_builtin(wt_shape shape)
+{
+    if ((int)shape < 0 || shape >= WT_NUM_SHAPES) {
+        return NULL;
+    }
+    pthread_once(&builtin_once, wt_build_builtins);
+    return builtin_tables[shape];
+}
+
+//------------------------------------------------------------------------------
+// Lookup
+//------------------------------------------------------------------------------
+
+// Pick the mipmap level that is alias-free for this phase increment
+static inline const double* wt_level(const dsp_wavetable* wt, double phase_inc)
+{
+    int level = 0;
+    double h = fabs(phase_inc) * WAVETABLE_SIZE;
+    if (h > 1.0) {
+        frexp(h, &level);   // h <= 2^level
+        if (level >= WAVETABLE_LEVELS) {
+            level = WAVETABLE_LEVELS - 1;
+        }
+    }
+    return wt->data + level * WAVETABLE_STRIDE;
+}
+
+// Linear interpolation into one level (phase 0.0 - 1.0)
+static inline double wt_read(const double* table, double phase)
+{
+    double pos = phase * WAVETABLE_SIZE;
+    int i = (int)pos;
+    double frac = pos - i;
+    i &= WAVETABLE_SIZE - 1;    // phase rounded up to exactly 1.0
+    return table[i] + (table[i + 1] - table[i]) * frac;
+}
+
+static inline double wt_wrap(double phase)
+{
+    if (phase >= 1.0) phase -= 1.0;
+    if (phase < 0.0) phase += 1.0;
+    return phase;
+}
+
+// Stateless lookup, the band-limited counterpart of osc_sine() etc.
+// phase: 0.0 - 1.0 (normalized phase)
+// phase_inc: phase increment per sample, selects the mipmap level
+// Returns: interpolated sample
+double wavetable_lookup(const dsp_wavetable* wt, double phase, double phase_inc)
+{
+    return wt_read(wt_level(wt, phase_inc), osc_phase_wrap(phase));
+}
+
+//------------------------------------------------------------------------------
+// Wavetable Oscillator
+//------------------------------------------------------------------------------
+
+// Attach a table and reset the phase
+void wtosc_init(dsp_wtosc* o, const dsp_wavetable* table)
+{
+    o->table = table;
+    o->phase = 0.0;
+}
+
+// Swap tables without resetting the phase
+void wtosc_set_table(dsp_wtosc* o, const dsp_wavetable* table)
+{
+    o->table = table;
+}
+
+// Set the phase (0.0 - 1.0)
+void wtosc_reset(dsp_wtosc* o, double phase)
+{
+    o->phase = osc_phase_wrap(phase);
+}
+
+// One sample
+// phase_inc: freq / samplerate (negative runs backwards, |phase_inc| < 1)
+double wtosc_tick(dsp_wtosc* o, double phase_inc)
+{
+    double y = wt_read(wt_level(o->table, phase_inc), o->phase);
+    o->phase = wt_wrap(o->phase + phase_inc);
+    return y;
+}
+
+// Fixed frequency block: the mipmap level is picked once per call
+void wtosc_process_block(dsp_wtosc* o, double* out, size_t n, double phase_inc)
+{
+    const double* table = wt_level(o->table, phase_inc);
+    double phase = o->phase;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = wt_read(table, phase);
+        phase = wt_wrap(phase + phase_inc);
+    }
+    o->phase = phase;
+}
+
+// Audio-rate frequency block (FM, glides): one phase increment per sample
+void wtosc_process_block_fm(dsp_wtosc* o, const double* phase_inc, double* out, size_t n)
+{
+    const dsp_wavetable* wt = o->table;
+    double phase = o->phase;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = wt_read(wt_level(wt, phase_inc[i]), phase);
+        phase = wt_wrap(phase + phase_inc[i]);
+    }
+    o->phase = phase;
+}
+
+// Render and sum a whole bank of oscillators in one call
+// oscs: array of count oscillators (ffi.new("dsp_wtosc[?]", count))
+// phase_inc, amp: per-oscillator increment and gain
+// out: n samples, overwritten with the mix
+void wtosc_bank_process_block(dsp_wtosc* oscs, const double* phase_inc, const double* amp,
+                              size_t count, double* out, size_t n)
+{
+    memset(out, 0, sizeof(double) * n);
+    for (size_t v = 0; v < count; v++) {
+        const double* table = wt_level(oscs[v].table, phase_inc[v]);
+        double inc = phase_inc[v];
+        double gain = amp[v];
+        double phase = oscs[v].phase;
+        for (size_t i = 0; i < n; i++) {
+            out[i] += gain * wt_read(table, phase);
+            phase = wt_wrap(phase + inc);
+        }
+        oscs[v].phase = phase;
+    }
+}
@@ -1,7 +1,10 @@
 
 #include <math.h>
+#include <stddef.h>
 #include <stdint.h>
 
+#include "libdsp.h"
+
 // Scaling functions from: https://www.desmos.com/calculator/ewnq4hyrbz
 
 double scale_linear(double x, double i_min, double i_max, double o_min, double o_max)
@@ -73,7 +76,7 @@ double bit_crush(double x, double bits)
     if (bits <= 0) return x;
     if (bits >= 16) return x;
 
-    double levels = pow(2.0, bits);
+    double levels = exp2(bits);
     double step = 2.0 / levels;
     return floor(x / step) * step;
 }
@@ -259,3 +262,154 @@ double osc_phase_wrap(double phase)
     while (phase < 0.0) phase += 1.0;
     return phase;
 }
+
+
+//------------------------------------------------------------------------------
+// Block Functions
+//
+// Process a whole signal vector per call, so Lua makes one FFI call per block
+// instead of one per sample. Loops are branch-free with constants hoisted and
+// restrict-qualified pointers so the compiler can auto-vectorise them; `in`
+// and `out` may not alias unless noted. Stateful filters carry their state in
+// a caller-owned double so they can be resumed on the next block.
+//
+// The element-wise kernels (clipping, crushing, folding, mixing and the
+// non-sine oscillators) live in dsp_kernels.h and are built once per CPU
+// instruction set; dsp_dispatch.c picks the best one at load time.
+//------------------------------------------------------------------------------
+
+// Block version of scale_sine1
+void scale_sine1_block(const double* restrict in, double* restrict out, size_t n,
+                       double i_min, double i_max, double o_min, double o_max)
+{
+    double amp = -(o_max - o_min) / 2.0;
+    double offset = (o_max + o_min) / 2;
+    double k = M_PI / (i_min - i_max);
+    for (size_t i = 0; i < n; i++) {
+        out[i] = amp * cos(k * (i_min - in[i])) + offset;
+    }
+}
+
+// Block version of scale_sine2
+void scale_sine2_block(const double* restrict in, double* restrict out, size_t n,
+                       double i_min, double i_max, double o_min, double o_max)
+{
+    double amp = (o_max - o_min) / M_PI;
+    double offset = (o_max + o_min) / 2;
+    double k = 2 / (i_max - i_min);
+    double center = (i_min + i_max) / 2;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = amp * asin(k * (in[i] - center)) + offset;
+    }
+}
+
+// Block version of scale_exp1 (pow rewritten as exp of a hoisted log, in double precision)
+void scale_exp1_block(const double* restrict in, double* restrict out, size_t n,
+                      double s, double i_min, double i_max, double o_min, double o_max)
+{
+    double log_base = log(fabs(o_min - o_max - s));
+    double k = 1.0 / (i_min - i_max);
+    for (size_t i = 0; i < n; i++) {
+        out[i] = -s * exp(log_base * (in[i] - i_max) * k) + o_max + s;
+    }
+}
+
+// Block version of scale_exp2 (pow rewritten as exp of a hoisted log, in double precision)
+void scale_exp2_block(const double* restrict in, double* restrict out, size_t n,
+                      double s, double i_min, double i_max, double o_min, double o_max)
+{
+    double log_base = log(fabs(o_max - o_min + s));
+    double k = 1.0 / (i_max - i_min);
+    for (size_t i = 0; i < n; i++) {
+        out[i] = s * exp(log_base * (in[i] - i_min) * k) + o_min - s;
+    }
+}
+
+// Block version of scale_log1
+void scale_log1_block(const double* restrict in, double* restrict out, size_t n,
+                      double p, double i_min, double i_max, double o_min, double o_max)
+{
+    double k = (o_max - o_min) / log(fabs(i_max - i_min + p));
+    for (size_t i = 0; i < n; i++) {
+        out[i] = k * log(fabs(in[i] - i_min + p)) + o_min;
+    }
+}
+
+// Block version of scale_log2
+void scale_log2_block(const double* restrict in, double* restrict out, size_t n,
+                      double p, double i_min, double i_max, double o_min, double o_max)
+{
+    double k = (o_min - o_max) / log(fabs(i_min - i_max - p));
+    for (size_t i = 0; i < n; i++) {
+        out[i] = k * log(fabs(in[i] - i_max - p)) + o_max;
+    }
+}
+
+// Block version of lpf_1pole
+// state: previous output, updated on return
+void lpf_1pole_block(const double* restrict in, double* restrict out, size_t n,
+                     double cutoff, double* state)
+{
+    double prev = *state;
+    for (size_t i = 0; i < n; i++) {
+        prev = prev + cutoff * (in[i] - prev);
+        out[i] = prev;
+    }
+    *state = prev;
+}
+
+// Block version of hpf_1pole
+// state: [0] previous input, [1] previous output, updated on return
+void hpf_1pole_block(const double* restrict in, double* restrict out, size_t n,
+                     double cutoff, double* state)
+{
+    double prev_in = state[0];
+    double prev_out = state[1];
+    for (size_t i = 0; i < n; i++) {
+        double x = in[i];
+        prev_out = cutoff * (prev_out + x - prev_in);
+        prev_in = x;
+        out[i] = prev_out;
+    }
+    state[0] = prev_in;
+    state[1] = prev_out;
+}
+
+// Block version of envelope_follow
+// state: previous envelope value, updated on return
+void envelope_follow_block(const double* restrict in, double* restrict out, size_t n,
+                           double attack, double release, double* state)
+{
+    double prev = *state;
+    for (size_t i = 0; i < n; i++) {
+        double x = in[i];
+        double coeff = (x > prev) ? attack : release;
+        prev = prev + coeff * (x - prev);
+        out[i] = prev;
+    }
+    *state = prev;
+}
+
+// Phase ramp generator for the osc_*_block functions
+// out: receives n phase values (0.0 - 1.0) starting at phase
+// phase_inc: phase increment per sample (freq/samplerate)
+// Returns: next phase (wrapped), to pass in on the next block
+double osc_phase_block(double* restrict out, size_t n, double phase, double phase_inc)
+{
+    phase = osc_phase_wrap(phase);
+    for (size_t i = 0; i < n; i++) {
+        out[i] = phase;
+        phase += phase_inc;
+        phase -= floor(phase);
+    }
+    return phase;
+}
+
+// Block version of osc_sine (in: phases 0.0 - 1.0)
+void osc_sine_block(const double* restrict in, double* restrict out, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        out[i] = sin(in[i] * 2.0 * M_PI);
+    }
+}
+
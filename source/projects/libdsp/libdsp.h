@@ -0,0 +1,484 @@
+// libdsp.h
+// Public interface of libdsp (loaded from Lua via FFI, see examples/dsp_ffi.lua)
+//
+// Keep the declarations in examples/dsp_ffi.lua in sync with this file:
+// ffi.cdef cannot include headers, so struct layouts are duplicated there.
+
+#ifndef LIBDSP_H
+#define LIBDSP_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//------------------------------------------------------------------------------
+// Scaling Functions
+//------------------------------------------------------------------------------
+
+double scale_linear(double x, double i_min, double i_max, double o_min, double o_max);
+double scale_sine1(double x, double i_min, double i_max, double o_min, double o_max);
+double scale_sine2(double x, double i_min, double i_max, double o_min, double o_max);
+double scale_exp1(double x, double s, double i_min, double i_max, double o_min, double o_max);
+double scale_exp2(double x, double s, double i_min, double i_max, double o_min, double o_max);
+double scale_log1(double x, double p, double i_min, double i_max, double o_min, double o_max);
+double scale_log2(double x, double p, double i_min, double i_max, double o_min, double o_max);
+
+//------------------------------------------------------------------------------
+// Audio DSP Functions
+//------------------------------------------------------------------------------
+
+double soft_clip(double x, double drive);
+double hard_clip(double x, double threshold);
+double bit_crush(double x, double bits);
+double lpf_1pole(double x, double prev, double cutoff);
+double hpf_1pole(double x, double prev_in, double prev_out, double cutoff);
+double lerp(double a, double b, double t);
+double envelope_follow(double x, double prev, double attack, double release);
+double wavefold(double x, double threshold);
+double ring_mod(double x, double modulator);
+double clamp(double x, double min, double max);
+
+//------------------------------------------------------------------------------
+// Oscillator Functions
+//------------------------------------------------------------------------------
+
+double osc_sine(double phase);
+double osc_saw(double phase);
+double osc_saw_bl(double phase, double phase_inc);
+double osc_square(double phase, double pulse_width);
+double osc_square_bl(double phase, double pulse_width, double phase_inc);
+double osc_triangle(double phase);
+double osc_phase_inc(double freq, double sample_rate);
+double osc_phase_wrap(double phase);
+
+//------------------------------------------------------------------------------
+// Block Functions
+//------------------------------------------------------------------------------
+
+void scale_linear_block(const double* in, double* out, size_t n, double i_min, double i_max, double o_min, double o_max);
+void scale_sine1_block(const double* in, double* out, size_t n, double i_min, double i_max, double o_min, double o_max);
+void scale_sine2_block(const double* in, double* out, size_t n, double i_min, double i_max, double o_min, double o_max);
+void scale_exp1_block(const double* in, double* out, size_t n, double s, double i_min, double i_max, double o_min, double o_max);
+void scale_exp2_block(const double* in, double* out, size_t n, double s, double i_min, double i_max, double o_min, double o_max);
+void scale_log1_block(const double* in, double* out, size_t n, double p, double i_min, double i_max, double o_min, double o_max);
+void scale_log2_block(const double* in, double* out, size_t n, double p, double i_min, double i_max, double o_min, double o_max);
+
+void soft_clip_block(const double* in, double* out, size_t n, double drive);
+void hard_clip_block(const double* in, double* out, size_t n, double threshold);
+void bit_crush_block(const double* in, double* out, size_t n, double bits);
+void lpf_1pole_block(const double* in, double* out, size_t n, double cutoff, double* state);
+void hpf_1pole_block(const double* in, double* out, size_t n, double cutoff, double* state);
+void lerp_block(const double* a, const double* b, double* out, size_t n, double t);
+void envelope_follow_block(const double* in, double* out, size_t n, double attack, double release, double* state);
+void wavefold_block(const double* in, double* out, size_t n, double threshold);
+void ring_mod_block(const double* in, const double* mod, double* out, size_t n);
+void clamp_block(const double* in, double* out, size_t n, double min, double max);
+
+double osc_phase_block(double* out, size_t n, double phase, double phase_inc);
+void osc_sine_block(const double* in, double* out, size_t n);
+void osc_saw_block(const double* in, double* out, size_t n);
+void osc_saw_bl_block(const double* in, double* out, size_t n, double phase_inc);
+void osc_square_block(const double* in, double* out, size_t n, double pulse_width);
+void osc_square_bl_block(const double* in, double* out, size_t n, double pulse_width, double phase_inc);
+void osc_triangle_block(const double* in, double* out, size_t n);
+
+//------------------------------------------------------------------------------
+// Scaler Objects (dsp_scale.c)
+//
+// The scale_* curves with their constants precomputed into a caller-allocated
+// struct (ffi.new("dsp_scaler")), for mapping many control values per call.
+// scaler_set() caches like the filter *_set() functions. An optional lookup
+// table serves fixed integer input ranges such as MIDI 0..127.
+//------------------------------------------------------------------------------
+
+typedef enum {
+    SCALE_LINEAR = 0,
+    SCALE_SINE1,
+    SCALE_SINE2,
+    SCALE_EXP1,
+    SCALE_EXP2,
+    SCALE_LOG1,
+    SCALE_LOG2
+} scale_curve;
+
+enum {
+    SCALER_LUT_SIZE = 128       // table entries (one per integer input)
+};
+
+typedef struct {
+    double a, b, c, d;          // folded constants: y = a * F(b * (x - d)) + c
+    int curve;                  // cached parameters
+    double shape, i_min, i_max, o_min, o_max;
+    int lut_first, lut_size;    // tabulated integer inputs (lut_size 0 = off)
+    double lut[SCALER_LUT_SIZE];
+} dsp_scaler;
+
+void scaler_init(dsp_scaler* s);
+void scaler_set(dsp_scaler* s, scale_curve curve, double shape,
+                double i_min, double i_max, double o_min, double o_max);
+void scaler_set_lut(dsp_scaler* s, int first, int count);
+double scaler_map(const dsp_scaler* s, double x);
+void scaler_process_block(const dsp_scaler* s, const double* in, double* out, size_t n);
+
+//------------------------------------------------------------------------------
+// Filter Objects (dsp_filter.c)
+//
+// Plain structs that the caller allocates (e.g. ffi.new("dsp_biquad") in
+// Lua) and initialises with *_init(). Coefficients are cached: *_set()
+// only recomputes them when a parameter actually changes, so it is cheap
+// to call once per sample or block. *_process_block() may run in place
+// (in == out).
+//------------------------------------------------------------------------------
+
+// RBJ cookbook biquad (transposed direct form II)
+typedef enum {
+    BIQUAD_LP = 0,      // low pass
+    BIQUAD_HP,          // high pass
+    BIQUAD_BP,          // band pass (constant 0 dB peak gain)
+    BIQUAD_BS,          // band stop (notch)
+    BIQUAD_LS,          // low shelf
+    BIQUAD_HS,          // high shelf
+    BIQUAD_EQ,          // peaking EQ
+    BIQUAD_AP           // all pass
+} biquad_type;
+
+typedef struct {
+    double b0, b1, b2, a1, a2;  // normalised coefficients (a0 = 1)
+    double z1, z2;              // state
+    int type;                   // cached parameters
+    double freq, q, gain, samplerate;
+} dsp_biquad;
+
+void biquad_init(dsp_biquad* f);
+void biquad_reset(dsp_biquad* f);
+void biquad_set(dsp_biquad* f, biquad_type type, double freq, double q, double gain_db, double samplerate);
+double biquad_tick(dsp_biquad* f, double x);
+void biquad_process_block(dsp_biquad* f, const double* in, double* out, size_t n);
+
+// Topology-preserving-transform state-variable filter (trapezoidal integration)
+typedef enum {
+    SVF_LP = 0,
+    SVF_BP,
+    SVF_HP,
+    SVF_NOTCH,
+    SVF_PEAK,
+    SVF_AP
+} svf_mode;
+
+typedef struct {
+    double g, k, a1, a2, a3;    // coefficients
+    double ic1eq, ic2eq;        // integrator state
+    double lp, bp, hp;          // outputs of the last tick (all modes at once)
+    int mode;                   // output returned by svf_tick
+    double freq, q, samplerate; // cached parameters
+} dsp_svf;
+
+void svf_init(dsp_svf* f);
+void svf_reset(dsp_svf* f);
+void svf_set(dsp_svf* f, svf_mode mode, double freq, double q, double samplerate);
+double svf_tick(dsp_svf* f, double x);
+void svf_process_block(dsp_svf* f, const double* in, double* out, size_t n);
+
+// One-pole low/high pass (6 dB/oct)
+typedef enum {
+    ONEPOLE_LP = 0,
+    ONEPOLE_HP
+} onepole_mode;
+
+typedef struct {
+    double a0, a1, b1;          // y = a0*x + a1*x1 + b1*y1
+    double x1, y1;              // state
+    int mode;                   // cached parameters
+    double freq, samplerate;
+} dsp_onepole;
+
+void onepole_init(dsp_onepole* f);
+void onepole_reset(dsp_onepole* f);
+void onepole_set(dsp_onepole* f, onepole_mode mode, double freq, double samplerate);
+double onepole_tick(dsp_onepole* f, double x);
+void onepole_process_block(dsp_onepole* f, const double* in, double* out, size_t n);
+
+// One-zero filter: y = b0*x + b1*x1 (zero at z = zero, unity peak gain)
+typedef struct {
+    double b0, b1;
+    double x1;
+    double zero;                // cached parameter
+} dsp_onezero;
+
+void onezero_init(dsp_onezero* f);
+void onezero_reset(dsp_onezero* f);
+void onezero_set(dsp_onezero* f, double zero);
+double onezero_tick(dsp_onezero* f, double x);
+void onezero_process_block(dsp_onezero* f, const double* in, double* out, size_t n);
+
+// DC blocker: y = x - x1 + r*y1
+typedef struct {
+    double r;
+    double x1, y1;
+    double freq, samplerate;    // cached parameters
+} dsp_dcblock;
+
+void dcblock_init(dsp_dcblock* f);
+void dcblock_reset(dsp_dcblock* f);
+void dcblock_set(dsp_dcblock* f, double freq, double samplerate);
+double dcblock_tick(dsp_dcblock* f, double x);
+void dcblock_process_block(dsp_dcblock* f, const double* in, double* out, size_t n);
+
+// 4th-order Linkwitz-Riley crossover (two cascaded Butterworth sections per band)
+// The low and high outputs sum to an all-pass response.
+typedef struct {
+    dsp_biquad lp[2];
+    dsp_biquad hp[2];
+} dsp_crossover;
+
+void crossover_init(dsp_crossover* f);
+void crossover_reset(dsp_crossover* f);
+void crossover_set(dsp_crossover* f, double freq, double samplerate);
+void crossover_tick(dsp_crossover* f, double x, double* low, double* high);
+void crossover_process_block(dsp_crossover* f, const double* in, double* low, double* high, size_t n);
+
+//------------------------------------------------------------------------------
+// Wavetable Oscillators (dsp_wavetable.c)
+//
+// Tables are band-limited per octave (mipmapped) once at creation and can be
+// shared by any number of oscillators. The built-in shapes are generated on
+// first use and live for the whole process; user tables come from
+// wavetable_create*() and must outlive every oscillator using them.
+//------------------------------------------------------------------------------
+
+enum {
+    WAVETABLE_SIZE = 2048,      // points per cycle (power of two)
+    WAVETABLE_LEVELS = 11       // octaves: level l keeps (WAVETABLE_SIZE / 2) >> l harmonics
+};
+
+typedef enum {
+    WT_SINE = 0,
+    WT_SAW,
+    WT_SQUARE,
+    WT_TRIANGLE,
+    WT_NUM_SHAPES
+} wt_shape;
+
+typedef struct dsp_wavetable dsp_wavetable;    // opaque
+
+const dsp_wavetable* wavetable_builtin(wt_shape shape);
+dsp_wavetable* wavetable_create(const double* samples, size_t n);
+dsp_wavetable* wavetable_create_float(const float* samples, size_t frames, size_t stride);
+void wavetable_free(dsp_wavetable* wt);
+double wavetable_lookup(const dsp_wavetable* wt, double phase, double phase_inc);
+
+typedef struct {
+    const dsp_wavetable* table;
+    double phase;               // 0.0 - 1.0
+} dsp_wtosc;
+
+void wtosc_init(dsp_wtosc* o, const dsp_wavetable* table);
+void wtosc_set_table(dsp_wtosc* o, const dsp_wavetable* table);
+void wtosc_reset(dsp_wtosc* o, double phase);
+double wtosc_tick(dsp_wtosc* o, double phase_inc);
+void wtosc_process_block(dsp_wtosc* o, double* out, size_t n, double phase_inc);
+void wtosc_process_block_fm(dsp_wtosc* o, const double* phase_inc, double* out, size_t n);
+void wtosc_bank_process_block(dsp_wtosc* oscs, const double* phase_inc, const double* amp,
+                              size_t count, double* out, size_t n);
+
+//------------------------------------------------------------------------------
+// Additive Oscillator Bank (dsp_additive.c)
+//
+// Up to thousands of sine partials rendered a block per call. State is kept
+// structure-of-arrays and advanced by the dispatched SIMD kernels. Amplitude
+// changes ramp linearly over the next block; partials at or above Nyquist
+// fade out.
+//------------------------------------------------------------------------------
+
+typedef struct dsp_additive dsp_additive;   // opaque
+
+dsp_additive* additive_create(size_t max_partials);
+void additive_free(dsp_additive* a);
+size_t additive_capacity(const dsp_additive* a);
+void additive_reset(dsp_additive* a);
+void additive_set_freq(dsp_additive* a, size_t k, double phase_inc);
+void additive_set_amp(dsp_additive* a, size_t k, double amp);
+void additive_set_phase(dsp_additive* a, size_t k, double phase);
+void additive_set_partial(dsp_additive* a, size_t k, double phase_inc, double amp);
+void additive_set_partials(dsp_additive* a, const double* phase_inc, const double* amp, size_t count);
+void additive_set_harmonics(dsp_additive* a, double phase_inc, const double* amp, size_t count);
+void additive_process_block(dsp_additive* a, double* out, size_t n);
+
+//------------------------------------------------------------------------------
+// Fast Math (dsp_fastmath.c)
+//
+// Approximations of libm functions in three explicit accuracy tiers:
+// _low (~1e-3, control signals), _med (~1e-7, audio) and _high (~1e-13).
+// Block variants take the tier as an argument. Run bench_fastmath for the
+// measured error and speed of each tier.
+//------------------------------------------------------------------------------
+
+typedef enum {
+    FASTMATH_LOW = 0,
+    FASTMATH_MED,
+    FASTMATH_HIGH
+} fastmath_tier;
+
+double fast_exp2_low(double x);
+double fast_exp2_med(double x);
+double fast_exp2_high(double x);
+double fast_log2_low(double x);
+double fast_log2_med(double x);
+double fast_log2_high(double x);
+double fast_sin_low(double x);
+double fast_sin_med(double x);
+double fast_sin_high(double x);
+double fast_cos_low(double x);
+double fast_cos_med(double x);
+double fast_cos_high(double x);
+double fast_tanh_low(double x);
+double fast_tanh_med(double x);
+double fast_tanh_high(double x);
+double fast_pow_low(double x, double y);
+double fast_pow_med(double x, double y);
+double fast_pow_high(double x, double y);
+double fast_db_to_gain_low(double db);
+double fast_db_to_gain_med(double db);
+double fast_db_to_gain_high(double db);
+double fast_gain_to_db_low(double gain);
+double fast_gain_to_db_med(double gain);
+double fast_gain_to_db_high(double gain);
+
+void fast_exp2_block(const double* in, double* out, size_t n, fastmath_tier tier);
+void fast_log2_block(const double* in, double* out, size_t n, fastmath_tier tier);
+void fast_sin_block(const double* in, double* out, size_t n, fastmath_tier tier);
+void fast_cos_block(const double* in, double* out, size_t n, fastmath_tier tier);
+void fast_tanh_block(const double* in, double* out, size_t n, fastmath_tier tier);
+void fast_pow_block(const double* in, double* out, size_t n, double y, fastmath_tier tier);
+void fast_db_to_gain_block(const double* in, double* out, size_t n, fastmath_tier tier);
+void fast_gain_to_db_block(const double* in, double* out, size_t n, fastmath_tier tier);
+
+//------------------------------------------------------------------------------
+// Convolution (dsp_convolve.c)
+//
+// Zero-latency uniformly partitioned convolution for IR reverbs and cabinet
+// simulation: the first block of the IR runs as a direct FIR, the rest as
+// overlap-save FFT partitions. Mono; use one convolver per channel.
+//------------------------------------------------------------------------------
+
+typedef struct dsp_convolver dsp_convolver;   // opaque
+
+dsp_convolver* convolver_create(const double* ir, size_t ir_len, size_t block_size);
+dsp_convolver* convolver_create_float(const float* ir, size_t frames, size_t stride,
+                                      size_t block_size);
+void convolver_free(dsp_convolver* c);
+void convolver_reset(dsp_convolver* c);
+size_t convolver_ir_length(const dsp_convolver* c);
+size_t convolver_block_size(const dsp_convolver* c);
+double convolver_tick(dsp_convolver* c, double x);
+void convolver_process_block(dsp_convolver* c, const double* in, double* out, size_t n);
+
+//------------------------------------------------------------------------------
+// Delay Lines (dsp_delay.c)
+//
+// Power-of-two ring buffers for delays, combs, chorus and pitch shifting.
+// The struct is public so Lua can index buf directly ((write - t) & mask),
+// but it must come from delay_create(). A delay of t samples is measured
+// from the next write: read first, then write.
+//------------------------------------------------------------------------------
+
+typedef enum {
+    DELAY_NONE = 0,     // nearest sample
+    DELAY_LINEAR,
+    DELAY_CUBIC,        // 4-point Hermite
+    DELAY_LAGRANGE      // 4-point 3rd-order Lagrange
+} delay_interp;
+
+typedef struct {
+    double* buf;        // size samples
+    size_t size;        // power of two
+    size_t mask;        // size - 1
+    size_t write;       // index of the next write
+    double ap_y1;       // delay_read_allpass() state
+} dsp_delay;
+
+dsp_delay* delay_create(size_t max_delay);
+void delay_free(dsp_delay* d);
+void delay_reset(dsp_delay* d);
+void delay_write(dsp_delay* d, double x);
+void delay_write_block(dsp_delay* d, const double* in, size_t n);
+double delay_read(const dsp_delay* d, size_t t);
+double delay_read_linear(const dsp_delay* d, double t);
+double delay_read_cubic(const dsp_delay* d, double t);
+double delay_read_lagrange(const dsp_delay* d, double t);
+double delay_read_allpass(dsp_delay* d, double t);
+void delay_read_taps(const dsp_delay* d, const double* times, double* out, size_t count,
+                     delay_interp interp);
+double delay_read_taps_sum(const dsp_delay* d, const double* times, const double* gains,
+                           size_t count, delay_interp interp);
+void delay_read_block(const dsp_delay* d, double* out, size_t n, double t, delay_interp interp);
+void delay_read_block_mod(const dsp_delay* d, const double* times, double* out, size_t n,
+                          delay_interp interp);
+
+//------------------------------------------------------------------------------
+// Envelopes (dsp_envelope.c)
+//
+// ADSR generator with the stage logic of the worp Adsr module. Caller-
+// allocated like the filter objects; adsr_set() caches the segment slopes.
+//------------------------------------------------------------------------------
+
+typedef enum {
+    ADSR_IDLE = 0,
+    ADSR_ATTACK,
+    ADSR_DECAY,
+    ADSR_SUSTAIN,
+    ADSR_RELEASE
+} adsr_stage;
+
+typedef struct {
+    double level, velocity;     // output = level * velocity
+    double step;                // slope of the current stage
+    double step_a, step_d, step_r, sustain;
+    int stage;
+    double attack, decay, release, samplerate;  // cached parameters
+} dsp_adsr;
+
+void adsr_init(dsp_adsr* e);
+void adsr_reset(dsp_adsr* e);
+void adsr_set(dsp_adsr* e, double attack, double decay, double sustain, double release,
+              double samplerate);
+void adsr_gate(dsp_adsr* e, double velocity);
+double adsr_tick(dsp_adsr* e);
+void adsr_process_block(dsp_adsr* e, double* out, size_t n);
+
+//------------------------------------------------------------------------------
+// Reverb (dsp_reverb.c)
+//
+// Freeverb: stereo comb/allpass reverb with its delay buffers in C memory.
+// freeverb_set() caches like the filter *_set() functions.
+//------------------------------------------------------------------------------
+
+typedef struct dsp_freeverb dsp_freeverb;   // opaque
+
+dsp_freeverb* freeverb_create(double samplerate);
+void freeverb_free(dsp_freeverb* r);
+void freeverb_reset(dsp_freeverb* r);
+void freeverb_set(dsp_freeverb* r, double room, double damp, double wet, double dry, double width);
+void freeverb_set_voicing(dsp_freeverb* r, double allpass_feedback, int lowpass);
+void freeverb_tick(dsp_freeverb* r, double in1, double in2, double* out1, double* out2);
+void freeverb_process_block(dsp_freeverb* r, const double* in1, const double* in2,
+                            double* out1, double* out2, size_t n);
+
+//------------------------------------------------------------------------------
+// CPU Dispatch (dsp_dispatch.c)
+//
+// The element-wise *_block kernels are built for several instruction sets and
+// the best supported one is chosen when the library loads. LIBDSP_ISA=<name>
+// in the environment overrides the choice.
+//------------------------------------------------------------------------------
+
+const char* dsp_isa(void);
+int dsp_set_isa(const char* name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LIBDSP_H
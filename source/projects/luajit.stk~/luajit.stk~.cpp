@@ -3,10 +3,13 @@
     luajit.stk~: luajit+stk for Max
 */
 
+#include <atomic>
 #include <cstdlib>
 #include <cctype>
 
 #include "stk_bindings.h"  // STK bindings (includes lua.hpp, LuaBridge, and all STK headers)
+#include "stk_voices.h"    // Native polyphonic voice allocator
+#include "stk_pipeline.h"  // One-block-ahead worker thread (@pipeline 1)
 
 #include "ext.h"
 #include "ext_obex.h"
@@ -35,6 +38,14 @@ typedef struct _lstk {
     double param3;           // parameter 3 (rightmost) - legacy support
     long m_in;               // space for the inlet number used by all of the proxies
     void *inlets[MAX_INLET_INDEX];
+    lstk::PolySynth* poly;   // polyphonic voice allocator (renders natively when enabled)
+    long pipeline;           // @pipeline: process on a worker thread one block ahead
+    long latency;            // @latency (read-only): added latency in samples
+    long underruns;          // @underruns (read-only): blocks the worker missed
+    std::atomic<lstk::Pipeline*> pipe;    // active worker (NULL when pipeline is off)
+    std::atomic<lstk::Pipeline*> running; // worker the current block uses
+    lstk::Pipeline* retired; // previous worker, freed once no block can use it
+    void* event_outlet;      // right outlet: emit() events from the DSP function
 } t_lstk;
 
 
@@ -47,8 +58,16 @@ void lstk_bang(t_lstk *x);
 void lstk_anything(t_lstk* x, t_symbol* s, long argc, t_atom* argv);
 void lstk_list(t_lstk* x, t_symbol* s, long argc, t_atom* argv);
 void lstk_float(t_lstk *x, double f);
+void lstk_note(t_lstk *x, double pitch, double velocity);
+void lstk_poly(t_lstk* x, t_symbol* s, long argc, t_atom* argv);
+void lstk_control(t_lstk *x, double number, double value);
+void lstk_bend(t_lstk *x, double semitones);
+void lstk_flush(t_lstk *x);
 void lstk_dsp64(t_lstk *x, t_object *dsp64, short *count, double samplerate, long maxvectorsize, long flags);
 void lstk_perform64(t_lstk *x, t_object *dsp64, double **ins, long numins, double **outs, long numouts, long sampleframes, long flags, void *userparam);
+void lstk_process(void *context, double *in, double *out, long n);
+void lstk_retire(t_lstk *x, lstk::Pipeline *old);
+t_max_err lstk_underruns_get(t_lstk *x, void *attr, long *argc, t_atom **argv);
 
 // global class pointer variable
 static t_class *lstk_class = NULL;
@@ -91,6 +110,115 @@ void lstk_run_file(t_lstk *x) {
     mxh_load_lua_file(lstk_class, x->engine->filename, load_lua_file_adapter, x);
 }
 
+//-----------------------------------------------------------------------------------------------
+// Polyphony: Lua `poly` table
+//
+// Lua only selects the instrument and shapes parameters; voices are rendered
+// natively in lstk_perform64 while poly mode is enabled.
+//
+//   poly.instrument("Rhodey", 32)   -- select instrument class and voice count
+//   poly.release(1.5)               -- release tail in seconds
+//   poly.gain(0.25)                 -- per-voice output gain
+//   poly.control(2, 64)             -- controlChange() on every voice
+//   poly.noteon(60, 100) / poly.noteoff(60)
+//   poly.bend(2)                    -- pitch bend in semitones
+//   poly.off()                      -- return to per-sample Lua processing
+//-----------------------------------------------------------------------------------------------
+
+static t_lstk* poly_owner(lua_State* L) {
+    return (t_lstk*)lua_touserdata(L, lua_upvalueindex(1));
+}
+
+// poly.instrument(name [, voices])
+static int poly_instrument(lua_State* L) {
+    t_lstk* x = poly_owner(L);
+    const char* name = luaL_checkstring(L, 1);
+    int voices = (int)luaL_optinteger(L, 2, lstk::DEFAULT_VOICES);
+
+    std::string err;
+    if (!x->poly->configure(name, voices, err)) {
+        return luaL_error(L, "poly.instrument: %s", err.c_str());
+    }
+    return 0;
+}
+
+// poly.release(seconds)
+static int poly_release(lua_State* L) {
+    poly_owner(L)->poly->set_release(luaL_checknumber(L, 1));
+    return 0;
+}
+
+// poly.gain(gain)
+static int poly_gain(lua_State* L) {
+    poly_owner(L)->poly->set_gain(luaL_checknumber(L, 1));
+    return 0;
+}
+
+// poly.control(number, value)
+static int poly_control(lua_State* L) {
+    poly_owner(L)->poly->push(lstk::NoteEvent::CONTROL,
+                              (float)luaL_checknumber(L, 1), (float)luaL_checknumber(L, 2));
+    return 0;
+}
+
+// poly.noteon(pitch, velocity)
+static int poly_noteon(lua_State* L) {
+    poly_owner(L)->poly->push(lstk::NoteEvent::NOTE_ON,
+                              (float)luaL_checknumber(L, 1), (float)luaL_optnumber(L, 2, 100.0));
+    return 0;
+}
+
+// poly.noteoff(pitch [, velocity])
+static int poly_noteoff(lua_State* L) {
+    poly_owner(L)->poly->push(lstk::NoteEvent::NOTE_OFF,
+                              (float)luaL_checknumber(L, 1), (float)luaL_optnumber(L, 2, 0.0));
+    return 0;
+}
+
+// poly.bend(semitones)
+static int poly_bend(lua_State* L) {
+    poly_owner(L)->poly->push(lstk::NoteEvent::BEND, (float)luaL_checknumber(L, 1), 0.0f);
+    return 0;
+}
+
+// poly.off()
+static int poly_off(lua_State* L) {
+    poly_owner(L)->poly->set_enabled(false);
+    return 0;
+}
+
+// poly.stats() -> voices, active, dropped
+static int poly_stats(lua_State* L) {
+    lstk::PolySynth* poly = poly_owner(L)->poly;
+    lua_pushinteger(L, poly->voices());
+    lua_pushinteger(L, poly->active());
+    lua_pushinteger(L, poly->dropped());
+    return 3;
+}
+
+static void register_poly_table(t_lstk* x, lua_State* L) {
+    static const luaL_Reg poly_funcs[] = {
+        {"instrument", poly_instrument},
+        {"release",    poly_release},
+        {"gain",       poly_gain},
+        {"control",    poly_control},
+        {"noteon",     poly_noteon},
+        {"noteoff",    poly_noteoff},
+        {"bend",       poly_bend},
+        {"off",        poly_off},
+        {"stats",      poly_stats},
+        {NULL, NULL}
+    };
+
+    lua_newtable(L);
+    for (const luaL_Reg* f = poly_funcs; f->name; f++) {
+        lua_pushlightuserdata(L, x);
+        lua_pushcclosure(L, f->func, 1);
+        lua_setfield(L, -2, f->name);
+    }
+    lua_setglobal(L, "poly");
+}
+
 //-----------------------------------------------------------------------------------------------
 
 void ext_main(void *r)
@@ -101,9 +229,26 @@ void ext_main(void *r)
     class_addmethod(c, (method)lstk_list,     "list",     A_GIMME, 0);
     class_addmethod(c, (method)lstk_anything, "anything", A_GIMME, 0);
     class_addmethod(c, (method)lstk_bang,     "bang",              0);
+    class_addmethod(c, (method)lstk_note,     "note",     A_FLOAT, A_FLOAT, 0);
+    class_addmethod(c, (method)lstk_poly,     "poly",     A_GIMME, 0);
+    class_addmethod(c, (method)lstk_control,  "control",  A_FLOAT, A_FLOAT, 0);
+    class_addmethod(c, (method)lstk_bend,     "bend",     A_FLOAT, 0);
+    class_addmethod(c, (method)lstk_flush,    "flush",             0);
     class_addmethod(c, (method)lstk_dsp64,    "dsp64",    A_CANT,  0);
     class_addmethod(c, (method)lstk_assist,   "assist",   A_CANT,  0);
 
+    // Attributes
+    CLASS_ATTR_LONG(c, "pipeline", 0, t_lstk, pipeline);
+    CLASS_ATTR_STYLE_LABEL(c, "pipeline", 0, "onoff", "Process on Worker Thread");
+    CLASS_ATTR_SAVE(c, "pipeline", 0);
+
+    CLASS_ATTR_LONG(c, "latency", ATTR_SET_OPAQUE_USER, t_lstk, latency);
+    CLASS_ATTR_LABEL(c, "latency", 0, "Added Latency (samples)");
+
+    CLASS_ATTR_LONG(c, "underruns", ATTR_SET_OPAQUE_USER, t_lstk, underruns);
+    CLASS_ATTR_ACCESSORS(c, "underruns", lstk_underruns_get, NULL);
+    CLASS_ATTR_LABEL(c, "underruns", 0, "Worker Underruns");
+
     class_dspinit(c);
     class_register(CLASS_BOX, c);
     lstk_class = c;
@@ -116,6 +261,7 @@ void *lstk_new(t_symbol *s, long argc, t_atom *argv)
 
     if (x) {
         dsp_setup((t_pxobject *)x, 1);  // MSP inlets: arg is # of inlets and is REQUIRED!
+        x->event_outlet = outlet_new(x, NULL);  // created first, so it is the rightmost
         outlet_new(x, "signal");         // signal outlet (note "signal" rather than NULL)
 
         // Initialize legacy parameters
@@ -124,6 +270,13 @@ void *lstk_new(t_symbol *s, long argc, t_atom *argv)
         x->param2 = 0.0;
         x->param3 = 0.0;
         x->engine = NULL;
+        x->poly = new lstk::PolySynth();
+        x->pipeline = 0;
+        x->latency = 0;
+        x->underruns = 0;
+        x->pipe.store(NULL);
+        x->running.store(NULL);
+        x->retired = NULL;
 
         // Create proxy inlets
         for(int i = (MAX_INLET_INDEX - 1); i > 0; i--) {
@@ -143,6 +296,9 @@ void *lstk_new(t_symbol *s, long argc, t_atom *argv)
             // Now load the Lua file
             lstk_run_file(x);
         }
+
+        // Process @attributes (e.g. @pipeline 1)
+        attr_args_process(x, argc, argv);
     }
     return (x);
 }
@@ -150,9 +306,19 @@ void *lstk_new(t_symbol *s, long argc, t_atom *argv)
 
 void lstk_free(t_lstk *x)
 {
-    luajit_free(x->engine);
     dsp_free((t_pxobject *)x);
 
+    // Stop the worker before the Lua state it runs goes away
+    delete x->pipe.exchange(NULL);
+    delete x->retired;
+    x->retired = NULL;
+
+    luajit_free(x->engine);
+
+    // Audio thread is gone after dsp_free(), so the voice banks can go too
+    delete x->poly;
+    x->poly = NULL;
+
     for(int i = (MAX_INLET_INDEX - 1); i > 0; i--) {
         if (x->inlets[i]) {
             object_free(x->inlets[i]);
@@ -168,7 +334,7 @@ void lstk_assist(t_lstk* x, void* b, long io, long idx, char* s)
     if (io == ASSIST_INLET) {
         switch (idx) {
         case PARAM0:
-            snprintf_zero(s, ASSIST_MAX_STRING_LEN, "%ld: input/param", idx);
+            snprintf_zero(s, ASSIST_MAX_STRING_LEN, "%ld: input/param, note pitch vel, poly name [voices]", idx);
             break;
         case PARAM1:
             snprintf_zero(s, ASSIST_MAX_STRING_LEN, "%ld: param", idx);
@@ -183,8 +349,11 @@ void lstk_assist(t_lstk* x, void* b, long io, long idx, char* s)
     }
 
     /* Document outlet */
-    else {  // outlet
-        snprintf_zero(s, ASSIST_MAX_STRING_LEN, "outlet %ld", idx);
+    else if (idx == 0) {  // outlet
+        snprintf_zero(s, ASSIST_MAX_STRING_LEN, "(signal) output");
+    }
+    else {
+        snprintf_zero(s, ASSIST_MAX_STRING_LEN, "emit() events: id value, or name value");
     }
 }
 
@@ -246,23 +415,178 @@ void lstk_float(t_lstk *x, double f)
 }
 
 
+//-----------------------------------------------------------------------------------------------
+// Polyphony messages (any thread: events are queued for the audio thread)
+
+void lstk_note(t_lstk *x, double pitch, double velocity)
+{
+    if (!x->poly->enabled()) {
+        error("luajit.stk~: 'note' requires poly mode (send 'poly <instrument> [voices]')");
+        return;
+    }
+    x->poly->push(lstk::NoteEvent::NOTE_ON, (float)pitch, (float)velocity);
+}
+
+// poly <instrument> [voices] | poly off
+void lstk_poly(t_lstk* x, t_symbol* s, long argc, t_atom* argv)
+{
+    if (argc < 1 || atom_gettype(argv) != A_SYM) {
+        error("luajit.stk~: poly <instrument> [voices] | poly off");
+        return;
+    }
+
+    t_symbol* name = atom_getsym(argv);
+    if (name == gensym("off")) {
+        x->poly->set_enabled(false);
+        return;
+    }
+
+    int voices = argc > 1 ? (int)atom_getlong(argv + 1) : lstk::DEFAULT_VOICES;
+    std::string err;
+    if (!x->poly->configure(name->s_name, voices, err)) {
+        error("luajit.stk~: poly: %s", err.c_str());
+        return;
+    }
+    post("luajit.stk~: poly %s (%d voices)", name->s_name,
+         voices < 1 ? 1 : (voices > lstk::MAX_VOICES ? lstk::MAX_VOICES : voices));
+}
+
+void lstk_control(t_lstk *x, double number, double value)
+{
+    x->poly->push(lstk::NoteEvent::CONTROL, (float)number, (float)value);
+}
+
+void lstk_bend(t_lstk *x, double semitones)
+{
+    x->poly->push(lstk::NoteEvent::BEND, (float)semitones, 0.0f);
+}
+
+// Release all held notes
+void lstk_flush(t_lstk *x)
+{
+    x->poly->push(lstk::NoteEvent::ALL_OFF, 0.0f, 0.0f);
+}
+
+//-----------------------------------------------------------------------------------------------
+
+// Mailbox command: between blocks, or at once while DSP is off
+static void lstk_set_samplerate(void* ud, t_symbol* s, double value)
+{
+    stk::Stk::setSampleRate(value);
+}
+
 void lstk_dsp64(t_lstk *x, t_object *dsp64, short *count, double samplerate, long maxvectorsize, long flags)
 {
+    // STK keeps a global rate; setSampleRate() also notifies every existing
+    // object registered for sampleRateChanged() (oscillators, envelopes,
+    // filters, poly voices), so they recompute their coefficients here rather
+    // than running at the default 44.1 kHz. Objects created from Lua are
+    // ticked inside the VM, so the change goes through the engine mailbox,
+    // ahead of the dsp_prepare call queued by luajit_handle_dsp64().
+    if (stk::Stk::sampleRate() != samplerate) {
+        if (x->engine) {
+            mailbox_call(x->engine->mailbox, lstk_set_samplerate, NULL, NULL, samplerate);
+        } else {
+            stk::Stk::setSampleRate(samplerate);
+        }
+    }
+
+    // Rebuild the worker for the new vector size. It is fully built before
+    // it is published, and the old DSP chain may still be running, so the
+    // previous worker goes through lstk_retire().
+    lstk::Pipeline* fresh = NULL;
+    x->latency = 0;
+
+    if (x->pipeline) {
+        fresh = new lstk::Pipeline(lstk_process, x, maxvectorsize, samplerate);
+        x->latency = fresh->latency();
+        post("luajit.stk~: pipeline on (%ld samples latency)", x->latency);
+    }
+    lstk_retire(x, x->pipe.exchange(fresh));
+
     if (x->engine) {
         luajit_handle_dsp64(x->engine, x, dsp64, count, samplerate, maxvectorsize, flags, (void*)lstk_perform64);
     }
 }
 
+// Free a worker replaced in dsp64 (main thread). perform64 announces the
+// worker it is about to use in x->running and then re-reads x->pipe, so once
+// x->pipe has moved on, only the worker named in x->running can still be in
+// use; that one waits until a later rebuild or lstk_free.
+void lstk_retire(t_lstk *x, lstk::Pipeline *old)
+{
+    lstk::Pipeline* running = x->running.load();
+    if (x->retired && x->retired != running) {
+        delete x->retired;
+        x->retired = NULL;
+    }
+    if (old && old == running) {
+        x->retired = old;
+    } else {
+        delete old;
+    }
+}
+
 void lstk_perform64(t_lstk *x, t_object *dsp64, double **ins, long numins, double **outs, long numouts, long sampleframes, long flags, void *userparam)
 {
+    // Load the worker once per block, announcing it before use (see lstk_retire)
+    lstk::Pipeline* pipe = x->pipe.load();
+    lstk::Pipeline* seen;
+    do {
+        seen = pipe;
+        x->running.store(seen);
+        pipe = x->pipe.load();
+    } while (pipe != seen);
+
+    if (pipe) {
+        // Worker renders one block ahead; this never blocks
+        pipe->perform(ins[0], outs[0], sampleframes);
+    } else {
+        lstk_process(x, ins[0], outs[0], sampleframes);
+    }
+}
+
+// Render one block of the Lua/STK graph (audio thread, or the worker in pipeline mode)
+void lstk_process(void *context, double *in, double *out, long n)
+{
+    t_lstk* x = (t_lstk*)context;
+
+    if (x->poly->enabled()) {
+        // Native polyphonic rendering: no per-sample Lua calls
+        x->poly->render(out, n, x->engine ? x->engine->samplerate : 44100.0);
+        return;
+    }
+
     if (x->engine) {
-        luajit_handle_perform64(x->engine, dsp64, ins, numins, outs, numouts, sampleframes, flags, userparam);
+        double* ins[1] = { in };
+        double* outs[1] = { out };
+        luajit_handle_perform64(x->engine, NULL, ins, 1, outs, 1, n, 0, NULL);
+    } else {
+        memset(out, 0, sizeof(double) * n);
     }
 }
 
+t_max_err lstk_underruns_get(t_lstk *x, void *attr, long *argc, t_atom **argv)
+{
+    char alloc;
+    if (atom_alloc(argc, argv, &alloc) != MAX_ERR_NONE) {
+        return MAX_ERR_GENERIC;
+    }
+    lstk::Pipeline* pipe = x->pipe.load();
+    x->underruns = pipe ? pipe->underruns() : 0;
+    atom_setlong(*argv, x->underruns);
+    return MAX_ERR_NONE;
+}
+
 void lstk_init_lua(t_lstk *x)
 {
     // Allocate and initialize Lua engine with STK bindings
     x->engine = luajit_new(stk_bindings_callback, "luajit.stk~");
+    if (x->engine) {
+        register_poly_table(x, x->engine->L);
+        if (luajit_events_attach(x->engine, x->event_outlet) != 0) {
+            error("luajit.stk~: failed to allocate the event queue");
+        }
+    }
     // Note: Don't load file here - filename needs to be set first
 }
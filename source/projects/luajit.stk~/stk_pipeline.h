@@ -0,0 +1,183 @@
+// stk_pipeline.h
+// One-block-ahead worker thread for luajit.stk~ (@pipeline 1)
+//
+// The audio thread hands each input block to a dedicated real-time worker
+// and outputs the block the worker finished during the previous period, so
+// heavy STK models get a full block period on another core at the cost of
+// one block of latency.
+//
+// Exchange is lock-free: two input and two output buffers indexed by block
+// sequence number, plus atomic posted/done counters. The audio thread never
+// waits; if the worker has not finished in time it outputs silence, drops
+// the input block and counts an underrun.
+
+#pragma once
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+
+#ifdef __APPLE__
+#include <dispatch/dispatch.h>
+#include <mach/mach.h>
+#include <mach/mach_time.h>
+#include <mach/thread_policy.h>
+#else
+#include <sched.h>
+#include <semaphore.h>
+#endif
+
+namespace lstk {
+
+// Wake-up signal that is safe to post from the audio thread
+class Signal {
+public:
+#ifdef __APPLE__
+    Signal() : sem_(dispatch_semaphore_create(0)) {}
+    ~Signal() { dispatch_release(sem_); }
+    void post() { dispatch_semaphore_signal(sem_); }
+    void wait() { dispatch_semaphore_wait(sem_, DISPATCH_TIME_FOREVER); }
+private:
+    dispatch_semaphore_t sem_;
+#else
+    Signal() { sem_init(&sem_, 0, 0); }
+    ~Signal() { sem_destroy(&sem_); }
+    void post() { sem_post(&sem_); }
+    void wait() { while (sem_wait(&sem_) != 0) {} }
+private:
+    sem_t sem_;
+#endif
+    Signal(const Signal&) = delete;
+    Signal& operator=(const Signal&) = delete;
+};
+
+class Pipeline {
+public:
+    // Processes one block: in and out hold n samples
+    typedef void (*ProcessFunc)(void* context, double* in, double* out, long n);
+
+    Pipeline(ProcessFunc process, void* context, long maxframes, double samplerate)
+        : process_(process), context_(context), maxframes_(maxframes), samplerate_(samplerate)
+    {
+        for (int i = 0; i < 2; i++) {
+            in_[i].assign((size_t)maxframes, 0.0);
+            out_[i].assign((size_t)maxframes, 0.0);
+            frames_[i] = 0;
+        }
+        worker_ = std::thread(&Pipeline::run, this);
+    }
+
+    ~Pipeline() {
+        running_.store(false, std::memory_order_release);
+        wake_.post();
+        if (worker_.joinable()) {
+            worker_.join();
+        }
+    }
+
+    // Added latency in samples
+    long latency() const { return maxframes_; }
+
+    long underruns() const { return underruns_.load(std::memory_order_relaxed); }
+
+    // Audio thread: submit this block's input, emit the previous block's output
+    void perform(const double* in, double* out, long n) {
+        if (n > maxframes_) {
+            std::memset(out, 0, sizeof(double) * n);
+            return;
+        }
+
+        uint64_t posted = posted_;
+        if (done_.load(std::memory_order_acquire) != posted) {
+            // Worker still busy with the previous block: never wait for it
+            std::memset(out, 0, sizeof(double) * n);
+            underruns_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        // Hand the new block to the worker first so it starts as early as possible
+        int next = (int)((posted + 1) & 1);
+        std::memcpy(in_[next].data(), in, sizeof(double) * n);
+        frames_[next] = n;
+        posted_ = posted + 1;
+        requested_.store(posted_, std::memory_order_release);
+        wake_.post();
+
+        // Then copy out the finished block; the worker writes the other slot
+        int prev = (int)(posted & 1);
+        if (posted > 0 && frames_[prev] == n) {
+            std::memcpy(out, out_[prev].data(), sizeof(double) * n);
+        } else {
+            std::memset(out, 0, sizeof(double) * n);
+        }
+    }
+
+private:
+    void run() {
+        set_realtime_priority();
+
+        while (true) {
+            wake_.wait();
+            if (!running_.load(std::memory_order_acquire)) {
+                break;
+            }
+
+            uint64_t seq = requested_.load(std::memory_order_acquire);
+            if (seq == done_.load(std::memory_order_relaxed)) {
+                continue;
+            }
+
+            int slot = (int)(seq & 1);
+            process_(context_, in_[slot].data(), out_[slot].data(), frames_[slot]);
+            done_.store(seq, std::memory_order_release);
+        }
+    }
+
+    // Best effort: run the worker at audio priority. Failure (e.g. missing
+    // privileges on Linux) leaves it at normal priority.
+    void set_realtime_priority() {
+#ifdef __APPLE__
+        mach_timebase_info_data_t timebase;
+        mach_timebase_info(&timebase);
+        double ns_to_abs = (double)timebase.denom / (double)timebase.numer;
+        double period_ns = 1.0e9 * (double)maxframes_ / samplerate_;
+
+        thread_time_constraint_policy_data_t policy;
+        policy.period = (uint32_t)(period_ns * ns_to_abs);
+        policy.computation = (uint32_t)(period_ns * 0.75 * ns_to_abs);
+        policy.constraint = (uint32_t)(period_ns * ns_to_abs);
+        policy.preemptible = 1;
+        thread_policy_set(pthread_mach_thread_np(pthread_self()),
+                          THREAD_TIME_CONSTRAINT_POLICY,
+                          (thread_policy_t)&policy,
+                          THREAD_TIME_CONSTRAINT_POLICY_COUNT);
+#else
+        struct sched_param param;
+        param.sched_priority = sched_get_priority_max(SCHED_FIFO) - 1;
+        pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+#endif
+    }
+
+    ProcessFunc process_;
+    void* context_;
+    long maxframes_;
+    double samplerate_;
+
+    std::vector<double> in_[2];
+    std::vector<double> out_[2];
+    long frames_[2];
+
+    uint64_t posted_ = 0;                       // audio thread only
+    std::atomic<uint64_t> requested_{0};        // audio -> worker
+    std::atomic<uint64_t> done_{0};             // worker -> audio
+    std::atomic<long> underruns_{0};
+    std::atomic<bool> running_{true};
+
+    Signal wake_;
+    std::thread worker_;
+};
+
+} // namespace lstk
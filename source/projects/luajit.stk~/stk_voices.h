@@ -0,0 +1,488 @@
+// stk_voices.h
+// Native polyphonic voice allocator for luajit.stk~
+//
+// Lua only selects the instrument class and shapes parameters; note events
+// are queued by the message thread and rendered block-wise on the audio
+// thread without any per-sample Lua calls.
+//
+// Threading model:
+//   - note/control events: any non-audio thread -> EventQueue -> audio thread
+//   - instrument changes: main thread builds a new VoiceBank and publishes it
+//     through PolySynth::next; the audio thread adopts it at the next block
+//     boundary and hands the old bank back through PolySynth::retired.
+
+#pragma once
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+
+#include "Instrmnt.h"
+#include "BandedWG.h"
+#include "BeeThree.h"
+#include "BlowBotl.h"
+#include "BlowHole.h"
+#include "Bowed.h"
+#include "Brass.h"
+#include "Clarinet.h"
+#include "Drummer.h"
+#include "FMVoices.h"
+#include "Flute.h"
+#include "HevyMetl.h"
+#include "Mandolin.h"
+#include "Mesh2D.h"
+#include "Moog.h"
+#include "PercFlut.h"
+#include "Plucked.h"
+#include "Recorder.h"
+#include "Resonate.h"
+#include "Rhodey.h"
+#include "Saxofony.h"
+#include "Shakers.h"
+#include "Simple.h"
+#include "Sitar.h"
+#include "StifKarp.h"
+#include "TubeBell.h"
+#include "VoicForm.h"
+#include "Whistle.h"
+#include "Wurley.h"
+
+namespace lstk {
+
+// Maximum number of voices in a bank
+constexpr int MAX_VOICES = 64;
+
+// Default number of voices when none is given
+constexpr int DEFAULT_VOICES = 8;
+
+// Peak level below which a releasing voice is considered finished (-100 dB)
+constexpr double SILENCE_THRESHOLD = 1.0e-5;
+
+// Largest block rendered with Instrmnt::tick(StkFrames&); larger blocks
+// fall back to per-sample ticking
+constexpr unsigned int MAX_BLOCK = 4096;
+
+// Lowest frequency passed to waveguide instruments that need one
+constexpr stk::StkFloat LOWEST_FREQUENCY = 20.0;
+
+//------------------------------------------------------------------------------
+// Instrument factory
+//------------------------------------------------------------------------------
+
+typedef stk::Instrmnt* (*InstrumentFactory)();
+
+struct InstrumentEntry {
+    const char* name;
+    InstrumentFactory create;
+};
+
+// Instrmnt subclasses that can be used as polyphonic voices
+static const InstrumentEntry INSTRUMENTS[] = {
+    { "BandedWG",  []() -> stk::Instrmnt* { return new stk::BandedWG(); } },
+    { "BeeThree",  []() -> stk::Instrmnt* { return new stk::BeeThree(); } },
+    { "BlowBotl",  []() -> stk::Instrmnt* { return new stk::BlowBotl(); } },
+    { "BlowHole",  []() -> stk::Instrmnt* { return new stk::BlowHole(LOWEST_FREQUENCY); } },
+    { "Bowed",     []() -> stk::Instrmnt* { return new stk::Bowed(LOWEST_FREQUENCY); } },
+    { "Brass",     []() -> stk::Instrmnt* { return new stk::Brass(LOWEST_FREQUENCY); } },
+    { "Clarinet",  []() -> stk::Instrmnt* { return new stk::Clarinet(LOWEST_FREQUENCY); } },
+    { "Drummer",   []() -> stk::Instrmnt* { return new stk::Drummer(); } },
+    { "FMVoices",  []() -> stk::Instrmnt* { return new stk::FMVoices(); } },
+    { "Flute",     []() -> stk::Instrmnt* { return new stk::Flute(LOWEST_FREQUENCY); } },
+    { "HevyMetl",  []() -> stk::Instrmnt* { return new stk::HevyMetl(); } },
+    { "Mandolin",  []() -> stk::Instrmnt* { return new stk::Mandolin(LOWEST_FREQUENCY); } },
+    { "Mesh2D",    []() -> stk::Instrmnt* { return new stk::Mesh2D(10, 10); } },
+    { "Moog",      []() -> stk::Instrmnt* { return new stk::Moog(); } },
+    { "PercFlut",  []() -> stk::Instrmnt* { return new stk::PercFlut(); } },
+    { "Plucked",   []() -> stk::Instrmnt* { return new stk::Plucked(LOWEST_FREQUENCY); } },
+    { "Recorder",  []() -> stk::Instrmnt* { return new stk::Recorder(); } },
+    { "Resonate",  []() -> stk::Instrmnt* { return new stk::Resonate(); } },
+    { "Rhodey",    []() -> stk::Instrmnt* { return new stk::Rhodey(); } },
+    { "Saxofony",  []() -> stk::Instrmnt* { return new stk::Saxofony(LOWEST_FREQUENCY); } },
+    { "Shakers",   []() -> stk::Instrmnt* { return new stk::Shakers(); } },
+    { "Simple",    []() -> stk::Instrmnt* { return new stk::Simple(); } },
+    { "Sitar",     []() -> stk::Instrmnt* { return new stk::Sitar(LOWEST_FREQUENCY); } },
+    { "StifKarp",  []() -> stk::Instrmnt* { return new stk::StifKarp(LOWEST_FREQUENCY); } },
+    { "TubeBell",  []() -> stk::Instrmnt* { return new stk::TubeBell(); } },
+    { "VoicForm",  []() -> stk::Instrmnt* { return new stk::VoicForm(); } },
+    { "Whistle",   []() -> stk::Instrmnt* { return new stk::Whistle(); } },
+    { "Wurley",    []() -> stk::Instrmnt* { return new stk::Wurley(); } },
+};
+
+static inline InstrumentFactory find_instrument(const char* name) {
+    for (const InstrumentEntry& entry : INSTRUMENTS) {
+        if (std::strcmp(entry.name, name) == 0) {
+            return entry.create;
+        }
+    }
+    return nullptr;
+}
+
+// MIDI note number (may be fractional) to frequency in Hz
+static inline stk::StkFloat note_to_freq(double note) {
+    return 440.0 * std::pow(2.0, (note - 69.0) / 12.0);
+}
+
+//------------------------------------------------------------------------------
+// Event queue (many non-audio producers, audio thread consumer)
+//------------------------------------------------------------------------------
+
+struct NoteEvent {
+    enum Type : uint8_t { NOTE_ON, NOTE_OFF, CONTROL, BEND, ALL_OFF };
+    Type type;
+    float a;    // note number / controller number / bend in semitones
+    float b;    // velocity (0-127) / controller value (0-128)
+};
+
+class EventQueue {
+public:
+    static constexpr uint32_t SIZE = 512;   // must be a power of two
+
+    // Producers may be the main thread and the scheduler thread, so writers
+    // are serialised with a mutex. The audio thread never takes the lock.
+    bool push(const NoteEvent& ev) {
+        std::lock_guard<std::mutex> guard(write_lock_);
+        uint32_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) >= SIZE) {
+            return false;   // full: drop the event
+        }
+        ring_[head & (SIZE - 1)] = ev;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(NoteEvent& ev) {
+        uint32_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        ev = ring_[tail & (SIZE - 1)];
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    NoteEvent ring_[SIZE];
+    std::atomic<uint32_t> head_{0};
+    std::atomic<uint32_t> tail_{0};
+    std::mutex write_lock_;
+};
+
+//------------------------------------------------------------------------------
+// Voice bank (one instrument class, N voices)
+//------------------------------------------------------------------------------
+
+class VoiceBank {
+public:
+    // Allocates all voices up front. May throw stk::StkError (e.g. missing
+    // rawwaves), so only construct it on the main thread inside try/catch.
+    VoiceBank(InstrumentFactory create, int nvoices)
+        : nvoices_(nvoices), frames_(MAX_BLOCK, 1)
+    {
+        for (int i = 0; i < MAX_VOICES; i++) {
+            voices_[i] = Voice();
+        }
+        try {
+            for (int i = 0; i < nvoices_; i++) {
+                voices_[i].inst = create();
+            }
+        } catch (...) {
+            release_instruments();
+            throw;
+        }
+    }
+
+    ~VoiceBank() {
+        release_instruments();
+    }
+
+    int voice_count() const { return nvoices_; }
+
+    // Number of voices that are not idle (audio thread only)
+    int active_count() const {
+        int count = 0;
+        for (int i = 0; i < nvoices_; i++) {
+            if (voices_[i].state != Voice::IDLE) count++;
+        }
+        return count;
+    }
+
+    // Apply one queued event (audio thread only)
+    void handle(const NoteEvent& ev, long release_samples) {
+        switch (ev.type) {
+            case NoteEvent::NOTE_ON:
+                if (ev.b <= 0.0f) {
+                    note_off(ev.a, 0.0f, release_samples);
+                } else {
+                    note_on(ev.a, ev.b);
+                }
+                break;
+            case NoteEvent::NOTE_OFF:
+                note_off(ev.a, ev.b, release_samples);
+                break;
+            case NoteEvent::CONTROL:
+                for (int i = 0; i < nvoices_; i++) {
+                    voices_[i].inst->controlChange((int)ev.a, ev.b);
+                }
+                break;
+            case NoteEvent::BEND:
+                bend_ = std::pow(2.0, ev.a / 12.0);
+                for (int i = 0; i < nvoices_; i++) {
+                    if (voices_[i].state != Voice::IDLE) {
+                        voices_[i].inst->setFrequency(voices_[i].freq * bend_);
+                    }
+                }
+                break;
+            case NoteEvent::ALL_OFF:
+                for (int i = 0; i < nvoices_; i++) {
+                    if (voices_[i].state == Voice::ON) {
+                        voices_[i].inst->noteOff(0.5);
+                        voices_[i].state = Voice::RELEASE;
+                        voices_[i].release_left = release_samples;
+                    }
+                }
+                break;
+        }
+    }
+
+    // Mix all sounding voices into out (audio thread only).
+    // out must already be cleared by the caller.
+    void render(double* out, long n, double gain) {
+        // StkFrames::resize() only reallocates when growing past capacity
+        const bool block = n <= (long)MAX_BLOCK;
+        if (block && (long)frames_.frames() != n) {
+            frames_.resize((size_t)n, 1);
+        }
+
+        for (int i = 0; i < nvoices_; i++) {
+            Voice& v = voices_[i];
+            if (v.state == Voice::IDLE) {
+                continue;   // idle voices cost nothing
+            }
+
+            double peak = 0.0;
+            if (block) {
+                v.inst->tick(frames_, 0);
+                for (long k = 0; k < n; k++) {
+                    double s = frames_[k];
+                    out[k] += s * gain;
+                    peak = std::fmax(peak, std::fabs(s));
+                }
+            } else {
+                for (long k = 0; k < n; k++) {
+                    double s = v.inst->tick();
+                    out[k] += s * gain;
+                    peak = std::fmax(peak, std::fabs(s));
+                }
+            }
+
+            // Release tail: keep ticking until the tail has died away or the
+            // release time is exhausted, then stop processing the voice.
+            if (v.state == Voice::RELEASE) {
+                v.release_left -= n;
+                if (v.release_left <= 0 || peak < SILENCE_THRESHOLD) {
+                    v.state = Voice::IDLE;
+                    v.note = -1.0f;
+                }
+            }
+        }
+    }
+
+private:
+    struct Voice {
+        enum State : uint8_t { IDLE, ON, RELEASE };
+        stk::Instrmnt* inst = nullptr;
+        float note = -1.0f;         // MIDI note currently assigned
+        stk::StkFloat freq = 0.0;   // unbent frequency
+        uint64_t age = 0;           // note-on order, used for stealing
+        long release_left = 0;      // samples of release tail remaining
+        State state = IDLE;
+    };
+
+    void note_on(float note, float velocity) {
+        Voice* v = find_voice(note);
+        if (!v) v = find_idle();
+        if (!v) v = steal();
+
+        v->note = note;
+        v->freq = note_to_freq(note);
+        v->age = ++clock_;
+        v->state = Voice::ON;
+        v->release_left = 0;
+        v->inst->noteOn(v->freq * bend_, velocity / 127.0);
+    }
+
+    void note_off(float note, float velocity, long release_samples) {
+        for (int i = 0; i < nvoices_; i++) {
+            Voice& v = voices_[i];
+            if (v.state == Voice::ON && v.note == note) {
+                v.inst->noteOff(velocity > 0.0f ? velocity / 127.0 : 0.5);
+                v.state = Voice::RELEASE;
+                v.release_left = release_samples;
+            }
+        }
+    }
+
+    // Retrigger a voice that is already playing this note
+    Voice* find_voice(float note) {
+        for (int i = 0; i < nvoices_; i++) {
+            if (voices_[i].state != Voice::IDLE && voices_[i].note == note) {
+                return &voices_[i];
+            }
+        }
+        return nullptr;
+    }
+
+    Voice* find_idle() {
+        for (int i = 0; i < nvoices_; i++) {
+            if (voices_[i].state == Voice::IDLE) {
+                return &voices_[i];
+            }
+        }
+        return nullptr;
+    }
+
+    // Steal the oldest releasing voice, or the oldest held voice if none
+    Voice* steal() {
+        Voice* oldest_release = nullptr;
+        Voice* oldest_on = nullptr;
+        for (int i = 0; i < nvoices_; i++) {
+            Voice& v = voices_[i];
+            if (v.state == Voice::RELEASE) {
+                if (!oldest_release || v.age < oldest_release->age) oldest_release = &v;
+            } else {
+                if (!oldest_on || v.age < oldest_on->age) oldest_on = &v;
+            }
+        }
+        return oldest_release ? oldest_release : oldest_on;
+    }
+
+    void release_instruments() {
+        for (int i = 0; i < MAX_VOICES; i++) {
+            delete voices_[i].inst;
+            voices_[i].inst = nullptr;
+        }
+    }
+
+    Voice voices_[MAX_VOICES];
+    int nvoices_;
+    stk::StkFrames frames_;     // per-block scratch for Instrmnt::tick(StkFrames&)
+    double bend_ = 1.0;         // pitch bend frequency ratio
+    uint64_t clock_ = 0;        // note-on counter
+};
+
+//------------------------------------------------------------------------------
+// PolySynth: queue + bank hand-over between main and audio threads
+//------------------------------------------------------------------------------
+
+class PolySynth {
+public:
+    ~PolySynth() {
+        // Only called after dsp_free(), so the audio thread is gone
+        delete current_;
+        delete next_.exchange(nullptr);
+        delete retired_.exchange(nullptr);
+    }
+
+    // Build a new bank and publish it (main thread only).
+    // Returns false and fills err on failure.
+    bool configure(const char* name, int nvoices, std::string& err) {
+        InstrumentFactory create = find_instrument(name);
+        if (!create) {
+            err = std::string("unknown instrument '") + name + "'";
+            return false;
+        }
+        if (nvoices < 1) nvoices = 1;
+        if (nvoices > MAX_VOICES) nvoices = MAX_VOICES;
+
+        VoiceBank* bank = nullptr;
+        try {
+            bank = new VoiceBank(create, nvoices);
+        } catch (stk::StkError& e) {
+            err = e.getMessage();
+            return false;
+        } catch (std::exception& e) {
+            err = e.what();
+            return false;
+        }
+
+        collect();
+        delete next_.exchange(bank, std::memory_order_acq_rel);  // never adopted
+        enabled_.store(true, std::memory_order_release);
+        return true;
+    }
+
+    // Free a bank the audio thread has finished with (main thread only)
+    void collect() {
+        delete retired_.exchange(nullptr, std::memory_order_acq_rel);
+    }
+
+    void set_enabled(bool on) { enabled_.store(on, std::memory_order_release); }
+    bool enabled() const { return enabled_.load(std::memory_order_acquire); }
+
+    void set_gain(double gain) { gain_.store(gain, std::memory_order_relaxed); }
+    void set_release(double seconds) { release_.store(seconds < 0.0 ? 0.0 : seconds, std::memory_order_relaxed); }
+
+    bool push(NoteEvent::Type type, float a, float b) {
+        if (!enabled()) return false;
+        NoteEvent ev = { type, a, b };
+        if (!events_.push(ev)) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    int voices() const { return voices_.load(std::memory_order_relaxed); }
+    int active() const { return active_.load(std::memory_order_relaxed); }
+    long dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    // Audio thread: adopt pending bank, apply events, mix voices into out
+    void render(double* out, long n, double samplerate) {
+        adopt();
+
+        std::memset(out, 0, sizeof(double) * n);
+        if (!current_) {
+            return;
+        }
+
+        long release_samples = (long)(release_.load(std::memory_order_relaxed) * samplerate);
+        NoteEvent ev;
+        while (events_.pop(ev)) {
+            current_->handle(ev, release_samples);
+        }
+
+        current_->render(out, n, gain_.load(std::memory_order_relaxed));
+        active_.store(current_->active_count(), std::memory_order_relaxed);
+    }
+
+private:
+    void adopt() {
+        // Only swap once the previous bank has been collected, so the audio
+        // thread never has to free anything itself.
+        if (retired_.load(std::memory_order_acquire) != nullptr) {
+            return;
+        }
+        VoiceBank* bank = next_.exchange(nullptr, std::memory_order_acq_rel);
+        if (bank) {
+            retired_.store(current_, std::memory_order_release);
+            current_ = bank;
+            voices_.store(bank->voice_count(), std::memory_order_relaxed);
+        }
+    }
+
+    EventQueue events_;
+    VoiceBank* current_ = nullptr;                  // audio thread only
+    std::atomic<VoiceBank*> next_{nullptr};         // main -> audio
+    std::atomic<VoiceBank*> retired_{nullptr};      // audio -> main
+    std::atomic<bool> enabled_{false};
+    std::atomic<double> gain_{0.5};
+    std::atomic<double> release_{1.0};              // seconds
+    std::atomic<int> voices_{0};
+    std::atomic<int> active_{0};
+    std::atomic<long> dropped_{0};
+};
+
+} // namespace lstk
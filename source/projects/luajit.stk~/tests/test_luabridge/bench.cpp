@@ -0,0 +1,306 @@
+// bench.cpp
+// Lua <-> C++ call overhead benchmark for luajit.stk~ binding styles
+//
+// Measures a stk::SineWave tick through each way Lua can reach C++:
+//
+//   native              C++ only, no Lua (reference cost)
+//   entry               host -> Lua call only (lua_engine_call_dsp_dynamic)
+//   capi                hand-written lua_CFunction
+//   luabridge_overload  generated stk_bindings.h (overloaded tick)
+//   luabridge_single    LuaBridge with a single-signature tick
+//   ffi                 LuaJIT FFI call into exported C symbols
+//
+// Each runs in two modes:
+//   sample  host calls the Lua DSP function once per sample, exactly like
+//           luajit_handle_perform64 (lua_engine_call_dsp_dynamic)
+//   block   host calls Lua once per block; Lua uses the block form of the
+//           binding where one exists
+//
+// Usage: ./bench [samples] [blocksize] > results.csv
+// Output is CSV on stdout; diagnostics go to stderr.
+
+#define LUAJIT_ENGINE_ONLY
+
+#include "lua.hpp"
+#include <LuaBridge.h>
+
+#include "stk_bindings.h"
+
+extern "C" {
+#include "luajit_external.h"
+}
+
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// Provided for luajit_external.h (Max's error() in the externals)
+extern "C" void error(const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    std::fprintf(stderr, "[error] ");
+    std::vfprintf(stderr, fmt, args);
+    std::fprintf(stderr, "\n");
+    va_end(args);
+}
+
+namespace bench {
+
+// Same C++ type as stk::SineWave, registered with one tick signature
+struct SineWaveSingle : public stk::SineWave {};
+
+static stk::SineWave* native_sine = nullptr;
+
+} // end namespace bench
+
+//------------------------------------------------------------------------------
+// Raw Lua C API binding
+//------------------------------------------------------------------------------
+
+// bench.capi_tick(ptr) -> sample
+static int capi_tick(lua_State* L) {
+    stk::SineWave* sine = (stk::SineWave*)lua_touserdata(L, 1);
+    lua_pushnumber(L, sine->tick());
+    return 1;
+}
+
+// bench.capi_tick_block(ptr, n) -> last sample
+static int capi_tick_block(lua_State* L) {
+    stk::SineWave* sine = (stk::SineWave*)lua_touserdata(L, 1);
+    int n = (int)lua_tointeger(L, 2);
+    stk::StkFloat last = 0.0;
+    for (int i = 0; i < n; i++) {
+        last = sine->tick();
+    }
+    lua_pushnumber(L, last);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// FFI entry points (resolved through ffi.C, so they must stay exported)
+//------------------------------------------------------------------------------
+
+extern "C" {
+
+double bench_sine_tick(void* ptr) {
+    return ((stk::SineWave*)ptr)->tick();
+}
+
+void bench_sine_tick_block(void* ptr, double* out, int n) {
+    stk::SineWave* sine = (stk::SineWave*)ptr;
+    for (int i = 0; i < n; i++) {
+        out[i] = sine->tick();
+    }
+}
+
+} // extern "C"
+
+//------------------------------------------------------------------------------
+
+static void register_bench_bindings(lua_State* L) {
+    luabridge::getGlobalNamespace(L)
+        .beginNamespace("bench")
+            .addFunction("capi_tick", &capi_tick)
+            .addFunction("capi_tick_block", &capi_tick_block)
+            .beginClass <stk::StkFrames> ("Frames")
+                .addConstructor<void (*) (unsigned int nFrames, unsigned int nChannels)>()
+                .addFunction("get", [](stk::StkFrames& self, unsigned int i) { return self[i]; })
+            .endClass()
+            .beginClass <bench::SineWaveSingle> ("SineWaveSingle")
+                .addConstructor<void ()> ()
+                .addFunction("setFrequency", [](bench::SineWaveSingle& self, stk::StkFloat f) { self.setFrequency(f); })
+                .addFunction("tick", [](bench::SineWaveSingle& self) { return self.tick(); })
+                .addFunction("tickBlock", [](bench::SineWaveSingle& self, stk::StkFrames& frames) { self.tick(frames, 0); })
+            .endClass()
+        .endNamespace();
+
+    lua_pushlightuserdata(L, bench::native_sine);
+    lua_setglobal(L, "SINE_PTR");
+}
+
+struct Result {
+    const char* binding;
+    const char* mode;
+    double ns_per_call;
+    double ns_per_sample;
+    double checksum;
+};
+
+static double elapsed_ns(std::chrono::steady_clock::time_point t0) {
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - t0).count();
+}
+
+// Per-sample mode: one lua_engine_call_dsp_dynamic per sample
+static bool run_sample(lua_State* L, const char* binding, long samples, Result& r) {
+    char func[64];
+    std::snprintf(func, sizeof(func), "%s_sample", binding);
+
+    int ref = lua_engine_cache_function(L, func);
+    if (ref == LUA_NOREF) {
+        return false;
+    }
+
+    char error_flag = 0;
+    float params[1] = { 220.0f };
+    double prev = 0.0;
+    double sum = 0.0;
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (long i = 0; i < samples; i++) {
+        prev = lua_engine_call_dsp_dynamic(L, ref, &error_flag, 0.0f, (float)prev,
+                                           (float)(samples - i), params, 1);
+        sum += prev;
+    }
+    double ns = elapsed_ns(t0);
+
+    lua_engine_release_function(L, ref);
+    if (error_flag) {
+        return false;
+    }
+
+    r.binding = binding;
+    r.mode = "sample";
+    r.ns_per_call = ns / (double)samples;
+    r.ns_per_sample = r.ns_per_call;
+    r.checksum = sum;
+    return true;
+}
+
+// Block mode: one Lua call per block of n samples
+static bool run_block(lua_State* L, const char* binding, long samples, int n, Result& r) {
+    char func[64];
+    std::snprintf(func, sizeof(func), "%s_block", binding);
+
+    int ref = lua_engine_cache_function(L, func);
+    if (ref == LUA_NOREF) {
+        return false;
+    }
+
+    long blocks = samples / n;
+    double sum = 0.0;
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (long b = 0; b < blocks; b++) {
+        lua_rawgeti(L, LUA_REGISTRYINDEX, ref);
+        lua_pushinteger(L, n);
+        if (lua_pcall(L, 1, 1, 0) != 0) {
+            error("%s: %s", func, lua_tostring(L, -1));
+            lua_pop(L, 1);
+            lua_engine_release_function(L, ref);
+            return false;
+        }
+        sum += lua_tonumber(L, -1);
+        lua_pop(L, 1);
+    }
+    double ns = elapsed_ns(t0);
+
+    lua_engine_release_function(L, ref);
+
+    r.binding = binding;
+    r.mode = "block";
+    r.ns_per_call = ns / (double)blocks;
+    r.ns_per_sample = ns / (double)(blocks * n);
+    r.checksum = sum;
+    return true;
+}
+
+// C++ reference: the cost STK itself has, without Lua
+static void run_native(long samples, int n, Result& sample, Result& block) {
+    stk::SineWave sine;
+    sine.setFrequency(220.0);
+    double sum = 0.0;
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (long i = 0; i < samples; i++) {
+        sum += sine.tick();
+    }
+    double ns = elapsed_ns(t0);
+    sample = { "native", "sample", ns / (double)samples, ns / (double)samples, sum };
+
+    stk::StkFrames frames((unsigned int)n, 1);
+    long blocks = samples / n;
+    sum = 0.0;
+
+    t0 = std::chrono::steady_clock::now();
+    for (long b = 0; b < blocks; b++) {
+        sine.tick(frames, 0);
+        sum += frames[0];
+    }
+    ns = elapsed_ns(t0);
+    block = { "native", "block", ns / (double)blocks, ns / (double)(blocks * n), sum };
+}
+
+static void print_result(const Result& r, int blocksize, long samples) {
+    std::printf("%s,%s,%d,%ld,%.3f,%.3f,%.6f\n",
+                r.binding, r.mode, r.mode[0] == 'b' ? blocksize : 1, samples,
+                r.ns_per_call, r.ns_per_sample, r.checksum);
+}
+
+int main(int argc, char* argv[]) {
+    long samples = argc > 1 ? std::atol(argv[1]) : 4410000;   // 100 s of audio at 44.1 kHz
+    int blocksize = argc > 2 ? std::atoi(argv[2]) : 64;
+    if (samples <= 0 || blocksize <= 0) {
+        std::fprintf(stderr, "usage: %s [samples] [blocksize]\n", argv[0]);
+        return 1;
+    }
+
+    stk::Stk::setSampleRate(44100.0);
+    stk::SineWave native;
+    native.setFrequency(220.0);
+    bench::native_sine = &native;
+
+    lua_State* L = lua_engine_init();
+    if (!L) {
+        return 1;
+    }
+
+    try {
+        register_stk_bindings(L);
+        register_bench_bindings(L);
+    } catch (std::exception& e) {
+        error("bindings: %s", e.what());
+        return 1;
+    }
+
+    lua_engine_set_samplerate(L, 44100.0);
+    lua_engine_set_blocksize(L, blocksize);
+    if (lua_engine_run_file(L, "bench.lua") != 0) {
+        return 1;
+    }
+
+    static const char* bindings[] = {
+        "entry", "capi", "luabridge_overload", "luabridge_single", "ffi"
+    };
+
+    std::printf("binding,mode,block_size,samples,ns_per_call,ns_per_sample,checksum\n");
+
+    Result sample, block;
+    run_native(samples, blocksize, sample, block);
+    print_result(sample, blocksize, samples);
+    print_result(block, blocksize, samples);
+
+    for (const char* binding : bindings) {
+        Result r;
+
+        // Warm up (lets LuaJIT compile the traces before timing)
+        run_sample(L, binding, samples / 10, r);
+        if (run_sample(L, binding, samples, r)) {
+            print_result(r, blocksize, samples);
+        } else {
+            std::fprintf(stderr, "skipped %s/sample\n", binding);
+        }
+
+        run_block(L, binding, samples / 10, blocksize, r);
+        if (run_block(L, binding, samples, blocksize, r)) {
+            print_result(r, blocksize, samples);
+        } else {
+            std::fprintf(stderr, "skipped %s/block\n", binding);
+        }
+    }
+
+    lua_engine_free(L);
+    return 0;
+}
@@ -0,0 +1,83 @@
+-- bench.lua
+-- DSP functions driven by bench.cpp, one pair per binding style:
+--   <binding>_sample(x, fb, n, p0)  called once per sample (luajit~ signature)
+--   <binding>_block(n)              called once per block, returns a checksum
+
+local ffi = require("ffi")
+
+ffi.cdef[[
+double bench_sine_tick(void* ptr);
+void bench_sine_tick_block(void* ptr, double* out, int n);
+]]
+
+local C = ffi.C
+local sine_ptr = ffi.cast("void*", SINE_PTR)
+local ffi_buf = ffi.new("double[?]", BLOCK_SIZE)
+
+local capi_tick = bench.capi_tick
+local capi_tick_block = bench.capi_tick_block
+
+local overload_sine = stk.SineWave()
+overload_sine:setFrequency(220.0)
+
+local single_sine = bench.SineWaveSingle()
+single_sine:setFrequency(220.0)
+
+local frames = bench.Frames(BLOCK_SIZE, 1)
+
+
+-- host -> Lua call only
+entry_sample = function(x, fb, n, p0)
+   return x
+end
+
+entry_block = function(n)
+   local sum = 0.0
+   for i = 1, n do
+      sum = sum + i
+   end
+   return sum
+end
+
+
+-- hand-written lua_CFunction
+capi_sample = function(x, fb, n, p0)
+   return capi_tick(SINE_PTR)
+end
+
+capi_block = function(n)
+   return capi_tick_block(SINE_PTR, n)
+end
+
+
+-- generated stk_bindings.h (tick is overloaded: tick() / tick(frames, channel))
+luabridge_overload_sample = function(x, fb, n, p0)
+   return overload_sine:tick()
+end
+
+luabridge_overload_block = function(n)
+   overload_sine:tick(frames, 0)
+   return frames:get(0)
+end
+
+
+-- LuaBridge with one signature per method
+luabridge_single_sample = function(x, fb, n, p0)
+   return single_sine:tick()
+end
+
+luabridge_single_block = function(n)
+   single_sine:tickBlock(frames)
+   return frames:get(0)
+end
+
+
+-- LuaJIT FFI
+ffi_sample = function(x, fb, n, p0)
+   return C.bench_sine_tick(sine_ptr)
+end
+
+ffi_block = function(n)
+   C.bench_sine_tick_block(sine_ptr, ffi_buf, n)
+   return ffi_buf[0]
+end
@@ -18,3 +18,17 @@ g++ --std=c++17 \
 	${LUAJIT}/lib/libluajit-5.1.a \
 	${STK}/lib/libstk.a
 
+# binding overhead benchmark: ./bench [samples] [blocksize] > bench.csv
+g++ --std=c++17 -O2 \
+	-I${LUABRIDGE} \
+	-I${LUAJIT}/include/luajit-2.1 \
+	-I${STK}/include/stk \
+	-I. \
+	-I../.. \
+	-I../../../common \
+	-framework CoreAudio \
+	-framework CoreFoundation \
+	-o bench \
+	bench.cpp \
+	${LUAJIT}/lib/libluajit-5.1.a \
+	${STK}/lib/libstk.a
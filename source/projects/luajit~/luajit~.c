@@ -17,6 +17,7 @@ typedef struct _mlj {
     t_pxobject ob;           // the object itself (t_pxobject in MSP instead of t_object)
     luajit_engine* engine;   // Lua engine (allocated separately)
     double param1;           // legacy single parameter support
+    void* event_outlet;      // right outlet: emit() events from the DSP function
 } t_mlj;
 
 
@@ -81,6 +82,7 @@ void *mlj_new(t_symbol *s, long argc, t_atom *argv)
 
     if (x) {
         dsp_setup((t_pxobject *)x, 1);  // MSP inlets: arg is # of inlets and is REQUIRED!
+        x->event_outlet = outlet_new(x, NULL);  // created first, so it is the rightmost
         outlet_new(x, "signal");         // signal outlet (note "signal" rather than NULL)
 
         // Initialize legacy parameter
@@ -92,6 +94,9 @@ void *mlj_new(t_symbol *s, long argc, t_atom *argv)
 
         // Set filename and funcname if engine was created successfully
         if (x->engine) {
+            if (luajit_events_attach(x->engine, x->event_outlet) != 0) {
+                error("luajit~: failed to allocate the event queue");
+            }
             x->engine->filename = atom_getsymarg(0, argc, argv); // 1st arg of object
             x->engine->funcname = gensym("base");
             post("filename: %s", x->engine->filename->s_name);
@@ -106,8 +111,9 @@ void *mlj_new(t_symbol *s, long argc, t_atom *argv)
 
 void mlj_free(t_mlj *x)
 {
-    luajit_free(x->engine);
+    // Stop the audio thread before the engine and its event queue go away
     dsp_free((t_pxobject *)x);
+    luajit_free(x->engine);
 }
 
 
@@ -116,8 +122,11 @@ void mlj_assist(t_mlj *x, void *b, long m, long a, char *s)
     if (m == ASSIST_INLET) { //inlet
         sprintf(s, "I am inlet %ld", a);
     }
-    else {  // outlet
-        sprintf(s, "I am outlet %ld", a);
+    else if (a == 0) {  // outlet
+        sprintf(s, "(signal) output");
+    }
+    else {
+        sprintf(s, "emit() events: id value, or name value");
     }
 }
 